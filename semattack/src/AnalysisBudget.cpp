@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * AnalysisBudget.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#include "AnalysisBudget.hpp"
+#include "StringBuilder.hpp"
+#include "exceptions/StrangerException.hpp"
+
+thread_local const AnalysisBudget* AnalysisBudget::t_budget = nullptr;
+thread_local std::chrono::steady_clock::time_point AnalysisBudget::t_deadline;
+thread_local bool AnalysisBudget::t_exceeded = false;
+std::atomic<unsigned int> AnalysisBudget::s_exceeded(0);
+
+AnalysisBudget::AnalysisBudget()
+  : m_seconds(0.0)
+  , m_max_states(0)
+  , m_max_bdd_nodes(0)
+{
+}
+
+AnalysisBudget::AnalysisBudget(double seconds, unsigned long max_states, unsigned long max_bdd_nodes)
+  : m_seconds(seconds)
+  , m_max_states(max_states)
+  , m_max_bdd_nodes(max_bdd_nodes)
+{
+}
+
+bool AnalysisBudget::isUnlimited() const
+{
+  return m_seconds <= 0.0 && m_max_states == 0 && m_max_bdd_nodes == 0;
+}
+
+AnalysisBudget::Scope::Scope(const AnalysisBudget& budget)
+  : m_previous(t_budget)
+  , m_previous_deadline(t_deadline)
+  , m_previous_exceeded(t_exceeded)
+{
+  t_budget = budget.isUnlimited() ? nullptr : &budget;
+  t_deadline = std::chrono::steady_clock::now()
+    + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(budget.getSeconds()));
+  t_exceeded = false;
+}
+
+AnalysisBudget::Scope::~Scope()
+{
+  if (t_exceeded) {
+    s_exceeded++;
+  }
+  t_budget = m_previous;
+  t_deadline = m_previous_deadline;
+  t_exceeded = m_previous_exceeded;
+}
+
+AnalysisBudget::Pause::Pause()
+  : m_previous(t_budget)
+{
+  t_budget = nullptr;
+}
+
+AnalysisBudget::Pause::~Pause()
+{
+  t_budget = m_previous;
+}
+
+void AnalysisBudget::check(unsigned long states, unsigned long bdd_nodes)
+{
+  const AnalysisBudget* budget = t_budget;
+  if (budget == nullptr) {
+    return;
+  }
+  if (budget->m_max_states > 0 && states > budget->m_max_states) {
+    t_exceeded = true;
+    throw StrangerException(AnalysisError::ResourceLimit,
+                            stringbuilder() << "Automaton with " << states << " states exceeds the limit of "
+                            << budget->m_max_states);
+  }
+  if (budget->m_max_bdd_nodes > 0 && bdd_nodes > budget->m_max_bdd_nodes) {
+    t_exceeded = true;
+    throw StrangerException(AnalysisError::ResourceLimit,
+                            stringbuilder() << "Automaton with " << bdd_nodes << " BDD nodes exceeds the limit of "
+                            << budget->m_max_bdd_nodes);
+  }
+  if (budget->m_seconds > 0.0 && std::chrono::steady_clock::now() > t_deadline) {
+    t_exceeded = true;
+    throw StrangerException(AnalysisError::Timeout,
+                            stringbuilder() << "Analysis exceeded the time limit of " << budget->m_seconds << "s");
+  }
+}
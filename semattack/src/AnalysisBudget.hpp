@@ -0,0 +1,91 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * AnalysisBudget.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef ANALYSIS_BUDGET_HPP_
+#define ANALYSIS_BUDGET_HPP_
+
+#include <atomic>
+#include <chrono>
+
+// Wall-clock and automaton size limits for one analysis task. A budget is
+// armed for the current thread with a Scope. StrangerAutomaton checks it
+// whenever an operation creates an automaton, and a task over budget is
+// cancelled with a StrangerException carrying AnalysisError::Timeout or
+// AnalysisError::ResourceLimit. A limit of zero is unlimited.
+class AnalysisBudget {
+
+public:
+  AnalysisBudget();
+  AnalysisBudget(double seconds, unsigned long max_states, unsigned long max_bdd_nodes);
+
+  double getSeconds() const { return m_seconds; }
+  unsigned long getMaxStates() const { return m_max_states; }
+  unsigned long getMaxBddNodes() const { return m_max_bdd_nodes; }
+  bool isUnlimited() const;
+
+  // Arms the budget for the current thread until the scope ends, its clock
+  // starts when the scope is created
+  class Scope {
+  public:
+    explicit Scope(const AnalysisBudget& budget);
+    ~Scope();
+  private:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    const AnalysisBudget* m_previous;
+    std::chrono::steady_clock::time_point m_previous_deadline;
+    bool m_previous_exceeded;
+  };
+
+  // Suspends the budget of the current thread, for work which must not
+  // fail half way
+  class Pause {
+  public:
+    Pause();
+    ~Pause();
+  private:
+    Pause(const Pause&) = delete;
+    Pause& operator=(const Pause&) = delete;
+    const AnalysisBudget* m_previous;
+  };
+
+  // Throws if the budget armed for the current thread is exceeded by the
+  // clock or by an automaton of the given size
+  static void check(unsigned long states, unsigned long bdd_nodes);
+
+  // Number of scopes which ended over budget
+  static unsigned int getExceeded() { return s_exceeded; }
+
+private:
+  double m_seconds;
+  unsigned long m_max_states;
+  unsigned long m_max_bdd_nodes;
+
+  static thread_local const AnalysisBudget* t_budget;
+  static thread_local std::chrono::steady_clock::time_point t_deadline;
+  static thread_local bool t_exceeded;
+  static std::atomic<unsigned int> s_exceeded;
+};
+
+#endif /* ANALYSIS_BUDGET_HPP_ */
@@ -22,10 +22,48 @@
  */
 
 #include "AnalysisResult.hpp"
+#include "exceptions/StrangerException.hpp"
+
+AnalysisResultConstIterator::AnalysisResultConstIterator(
+    const std::vector<const StrangerAutomaton*>* automata, int node)
+    : m_automata(automata)
+    , m_entry(node, nullptr)
+{
+    skipEmpty();
+}
+
+AnalysisResultConstIterator& AnalysisResultConstIterator::operator++()
+{
+    m_entry.first++;
+    skipEmpty();
+    return *this;
+}
+
+void AnalysisResultConstIterator::skipEmpty()
+{
+    int size = m_automata->size();
+    while (m_entry.first < size && (*m_automata)[m_entry.first] == nullptr) {
+        m_entry.first++;
+    }
+    if (m_entry.first >= size) {
+        m_entry.first = size;
+        m_entry.second = nullptr;
+    } else {
+        m_entry.second = (*m_automata)[m_entry.first];
+    }
+}
 
 
 AnalysisResult::AnalysisResult()
-    : m_map()
+    : m_automata()
+    , m_size(0)
+    , m_live_automata(0)
+    , m_live_states(0)
+    , m_live_bdd_nodes(0)
+    , m_peak_automata(0)
+    , m_peak_states(0)
+    , m_peak_bdd_nodes(0)
+    , m_released(0)
 {
 }
 
@@ -37,43 +75,100 @@ AnalysisResult::~AnalysisResult()
 
 const StrangerAutomaton* AnalysisResult::get(int node) const
 {
-    if (m_map.count(node) > 0) {
-        return m_map.at(node);
+    if (node >= 0 && node < (int) m_automata.size()) {
+        return m_automata[node];
     }
     return nullptr;
 }
 
 void AnalysisResult::set(int node, const StrangerAutomaton* a)
 {
-    if (m_map[node] != nullptr) {
-        delete m_map[node];
+    if (node < 0) {
+        throw StrangerException(AnalysisError::MalformedDepgraph, stringbuilder() << "Invalid node id for analysis result: " << node);
+    }
+    if (node >= (int) m_automata.size()) {
+        m_automata.resize(node + 1, nullptr);
+    }
+    const StrangerAutomaton* old = m_automata[node];
+    if (old != nullptr) {
+        track(old, -1);
+        delete old;
+        m_size--;
+    }
+    m_automata[node] = a;
+    if (a != nullptr) {
+        m_size++;
+        track(a, 1);
+    }
+}
+
+void AnalysisResult::release(int node)
+{
+    if (node < 0 || node >= (int) m_automata.size() || m_automata[node] == nullptr) {
+        return;
     }
-    m_map[node] = a;
+    track(m_automata[node], -1);
+    delete m_automata[node];
+    m_automata[node] = nullptr;
+    m_size--;
+    m_released++;
 }
 
 void AnalysisResult::clear()
 {
-    for (auto a : m_map) {
-        if (a.second != nullptr) {
-            delete a.second;
-            a.second = nullptr;
+    for (auto a : m_automata) {
+        if (a != nullptr) {
+            delete a;
         }
     }
-    m_map.clear();
+    m_automata.clear();
+    m_size = 0;
+    m_live_automata = 0;
+    m_live_states = 0;
+    m_live_bdd_nodes = 0;
+}
+void AnalysisResult::track(const StrangerAutomaton* a, int sign)
+{
+    if (a == nullptr || a->isNull()) {
+        return;
+    }
+    m_live_automata += sign;
+    m_live_states += sign * a->get_num_of_states();
+    m_live_bdd_nodes += sign * (long) a->get_num_of_bdd_nodes();
+    if (m_live_automata > m_peak_automata) {
+        m_peak_automata = m_live_automata;
+    }
+    if (m_live_states > m_peak_states) {
+        m_peak_states = m_live_states;
+    }
+    if (m_live_bdd_nodes > m_peak_bdd_nodes) {
+        m_peak_bdd_nodes = m_live_bdd_nodes;
+    }
+}
+
+void AnalysisResult::printMemoryStats(std::ostream& os) const
+{
+    os << "peak automata: " << m_peak_automata
+       << ", peak states: " << m_peak_states
+       << ", peak bdd nodes: " << m_peak_bdd_nodes
+       << ", released: " << m_released;
 }
 
 AnalysisResultConstIterator AnalysisResult::find(int node) const
 {
-    return m_map.find(node);
+    if (get(node) == nullptr) {
+        return end();
+    }
+    return AnalysisResultConstIterator(&m_automata, node);
 }
 
 AnalysisResultConstIterator AnalysisResult::begin() const
 {
-    return m_map.begin();
+    return AnalysisResultConstIterator(&m_automata, 0);
 }
 
 AnalysisResultConstIterator AnalysisResult::end() const
 {
-    return m_map.end();
+    return AnalysisResultConstIterator(&m_automata, m_automata.size());
 }
 
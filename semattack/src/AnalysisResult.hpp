@@ -26,10 +26,32 @@
 #ifndef ANALYSISRESULT_HPP_
 #define ANALYSISRESULT_HPP_
 
+#include <ostream>
+#include <utility>
+#include <vector>
 #include "StrangerAutomaton.hpp"
 
-typedef std::map<int, const StrangerAutomaton*>::iterator AnalysisResultIterator;
-typedef std::map<int, const StrangerAutomaton*>::const_iterator AnalysisResultConstIterator;
+// Iterates over the (node id, automaton) entries of an AnalysisResult in
+// the order of the node ids
+class AnalysisResultConstIterator {
+
+public:
+    AnalysisResultConstIterator(const std::vector<const StrangerAutomaton*>* automata, int node);
+
+    const std::pair<int, const StrangerAutomaton*>& operator*() const { return m_entry; }
+    const std::pair<int, const StrangerAutomaton*>* operator->() const { return &m_entry; }
+    AnalysisResultConstIterator& operator++();
+    bool operator==(const AnalysisResultConstIterator& other) const { return m_entry.first == other.m_entry.first; }
+    bool operator!=(const AnalysisResultConstIterator& other) const { return m_entry.first != other.m_entry.first; }
+
+private:
+    void skipEmpty();
+
+    const std::vector<const StrangerAutomaton*>* m_automata;
+    std::pair<int, const StrangerAutomaton*> m_entry;
+};
+
+typedef AnalysisResultConstIterator AnalysisResultIterator;
 
 class AnalysisResult {
 
@@ -50,12 +72,34 @@ public:
     const StrangerAutomaton* get(int node) const;
     void clear();
 
+    // Deletes the automaton of a node which will not be read again
+    void release(int node);
+
+    // Memory held by the automata of this result, the peaks survive clear()
+    unsigned int size() const { return m_size; }
+    unsigned int getPeakAutomata() const { return m_peak_automata; }
+    long getPeakStates() const { return m_peak_states; }
+    long getPeakBddNodes() const { return m_peak_bdd_nodes; }
+    unsigned int getReleased() const { return m_released; }
+    void printMemoryStats(std::ostream& os) const;
+
     AnalysisResultConstIterator find(int node) const;
     AnalysisResultConstIterator begin() const;
     AnalysisResultConstIterator end() const;
 
 private:
-    std::map<int, const StrangerAutomaton*> m_map;
+    void track(const StrangerAutomaton* a, int sign);
+
+    // indexed by node id, node ids of parsed depgraphs are small and dense
+    std::vector<const StrangerAutomaton*> m_automata;
+    unsigned int m_size;
+    unsigned int m_live_automata;
+    long m_live_states;
+    long m_live_bdd_nodes;
+    unsigned int m_peak_automata;
+    long m_peak_states;
+    long m_peak_bdd_nodes;
+    unsigned int m_released;
 };
 
 #endif /* ANALYSISRESULT_HPP_ */
@@ -0,0 +1,134 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * AttackPatternRegistry.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+
+#include "AttackPatternRegistry.hpp"
+#include "AttackPatterns.hpp"
+#include "AnalysisBudget.hpp"
+
+#include <algorithm>
+
+AttackPatternRegistry::AttackPatternRegistry()
+  : m_patterns()
+  , m_containing()
+  , m_inclusions(0)
+  , m_mutex()
+  , m_builds(0)
+  , m_rebuilds_avoided(0)
+{
+
+}
+
+AttackPatternRegistry::~AttackPatternRegistry()
+{
+  for (auto iter : m_patterns) {
+    delete iter.second;
+  }
+  m_patterns.clear();
+}
+
+void AttackPatternRegistry::init(const std::vector<AttackContext>& contexts)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto c : contexts) {
+    findOrBuild(c);
+  }
+  computeInclusions(contexts);
+}
+
+/**
+ * If a post-image does not intersect a pattern, it cannot intersect any
+ * pattern contained in it. Checking all pairs once at startup lets the
+ * backward analysis skip those intersections.
+ */
+void AttackPatternRegistry::computeInclusions(const std::vector<AttackContext>& contexts)
+{
+  // Caller must hold m_mutex
+  std::set<AttackContext> unique(contexts.begin(), contexts.end());
+  m_containing.clear();
+  m_inclusions = 0;
+  for (auto a : unique) {
+    std::vector<AttackContext>& containing = m_containing[a];
+    for (auto b : unique) {
+      if (a != b && m_patterns.at(a)->checkInclusion(m_patterns.at(b))) {
+        containing.push_back(b);
+        m_inclusions++;
+      }
+    }
+  }
+}
+
+const std::vector<AttackContext>& AttackPatternRegistry::getContainingContexts(AttackContext context) const
+{
+  static const std::vector<AttackContext> none;
+  auto search = m_containing.find(context);
+  return (search != m_containing.end()) ? search->second : none;
+}
+
+/**
+ * A pattern strictly contained in another has more containing patterns,
+ * so sorting by that count gives a topological order of the lattice.
+ * Patterns with the same language are related both ways and keep their
+ * relative order.
+ */
+std::vector<AttackContext> AttackPatternRegistry::getLatticeOrder(const std::vector<AttackContext>& contexts) const
+{
+  std::vector<AttackContext> order(contexts);
+  std::stable_sort(order.begin(), order.end(), [this](AttackContext a, AttackContext b) {
+    return getContainingContexts(a).size() < getContainingContexts(b).size();
+  });
+  return order;
+}
+
+StrangerAutomaton* AttackPatternRegistry::getAttackPattern(AttackContext context)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  // patterns are shared between tasks, so building one is not charged to
+  // the budget of the task which happens to ask first
+  AnalysisBudget::Pause pause;
+  if (m_patterns.find(context) != m_patterns.end()) {
+    m_rebuilds_avoided++;
+  }
+  // every backward analysis thread reads its own DFA
+  return findOrBuild(context)->deepClone();
+}
+
+const StrangerAutomaton* AttackPatternRegistry::findOrBuild(AttackContext context)
+{
+  // Caller must hold m_mutex
+  auto search = m_patterns.find(context);
+  if (search != m_patterns.end()) {
+    return search->second;
+  }
+  const StrangerAutomaton* pattern = AttackPatterns::getAttackPatternForContext(context);
+  m_patterns.insert(std::make_pair(context, pattern));
+  m_builds++;
+  return pattern;
+}
+
+void AttackPatternRegistry::printStatus(std::ostream& os) const
+{
+  os << "# Attack patterns built --> Rebuilds avoided --> Inclusions" << std::endl;
+  os << "# " << getBuilds() << " --> " << getRebuildsAvoided() << " --> " << getInclusions() << std::endl;
+}
@@ -0,0 +1,88 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * AttackPatternRegistry.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef ATTACK_PATTERN_REGISTRY_HPP_
+#define ATTACK_PATTERN_REGISTRY_HPP_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <vector>
+
+#include "StrangerAutomaton.hpp"
+#include "AttackContext.hpp"
+
+// Process wide store of the attack pattern automata, each pattern
+// is only built once from its regex and then copied on request
+class AttackPatternRegistry {
+
+public:
+  // Make AttackPatternRegistry a singleton
+  static AttackPatternRegistry& getInstance() {
+    static AttackPatternRegistry instance;
+    return instance;
+  }
+
+  // Build the patterns for the given contexts up front and compute the
+  // inclusion order between them
+  void init(const std::vector<AttackContext>& contexts);
+
+  // Returns a copy of the pattern for the context, owned by the caller.
+  // MONA marks the BDD nodes of the source DFA when copying, so the
+  // stored pattern is only ever copied while holding the lock.
+  StrangerAutomaton* getAttackPattern(AttackContext context);
+
+  // Contexts whose pattern contains the pattern of the given context. Only
+  // contexts passed to init() are related, call it before the analysis.
+  const std::vector<AttackContext>& getContainingContexts(AttackContext context) const;
+
+  // Orders the contexts so every pattern comes after all patterns containing it
+  std::vector<AttackContext> getLatticeOrder(const std::vector<AttackContext>& contexts) const;
+
+  unsigned int getInclusions() const { return m_inclusions; }
+  unsigned int getBuilds() const { return m_builds; }
+  unsigned int getRebuildsAvoided() const { return m_rebuilds_avoided; }
+
+  void printStatus(std::ostream& os) const;
+
+private:
+  AttackPatternRegistry();
+  virtual ~AttackPatternRegistry();
+  AttackPatternRegistry(const AttackPatternRegistry&) = delete;
+  AttackPatternRegistry& operator=(const AttackPatternRegistry&) = delete;
+
+  const StrangerAutomaton* findOrBuild(AttackContext context);
+  void computeInclusions(const std::vector<AttackContext>& contexts);
+
+  std::map<AttackContext, const StrangerAutomaton*> m_patterns;
+  std::map<AttackContext, std::vector<AttackContext> > m_containing;
+  unsigned int m_inclusions;
+  std::mutex m_mutex;
+  std::atomic<unsigned int> m_builds;
+  std::atomic<unsigned int> m_rebuilds_avoided;
+};
+
+#endif /* ATTACK_PATTERN_REGISTRY_HPP_ */
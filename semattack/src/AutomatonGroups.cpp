@@ -42,7 +42,9 @@ std::vector<AttackContext> AutomatonGroup::m_sink_contexts = {
 
 AutomatonGroup::AutomatonGroup(const StrangerAutomaton* automaton, const std::string& name, int id)
   : m_automaton(automaton)
+  , m_fingerprint((automaton != nullptr) ? automaton->getFingerprint() : 0)
   , m_graphs()
+  , m_verdicts((automaton != nullptr) ? std::make_shared<GroupVerdicts>() : nullptr)
   , m_name(name)
   , m_id(id)
 {
@@ -51,7 +53,9 @@ AutomatonGroup::AutomatonGroup(const StrangerAutomaton* automaton, const std::st
 
 AutomatonGroup::AutomatonGroup(const StrangerAutomaton* automaton, int id)
   : m_automaton(automaton)
+  , m_fingerprint((automaton != nullptr) ? automaton->getFingerprint() : 0)
   , m_graphs()
+  , m_verdicts((automaton != nullptr) ? std::make_shared<GroupVerdicts>() : nullptr)
   , m_name(std::to_string(id))
   , m_id(id)
 {
@@ -346,8 +350,21 @@ unsigned int AutomatonGroup::getContainedEntriesForContext(const AttackContext&
   return total;
 }
 
+unsigned int AutomatonGroup::getErroredEntriesForContext(const AttackContext& context) const {
+  unsigned int entries = this->getEntries();
+  unsigned int total = 0;
+  if (m_graphs.size() > 0) {
+    // Get the first result in the group
+    const BackwardAnalysisResult* bw = m_graphs.at(0)->getBackwardAnalysis(context);
+    total = ((bw != nullptr && bw->isErrored()) ? 1 : 0) * entries;
+  }
+  return total;
+}
+
 AutomatonGroups::AutomatonGroups()
   : m_groups()
+  , m_index()
+  , m_null_group(-1)
   , m_id(0)
 {
 
@@ -384,10 +401,15 @@ AutomatonGroup* AutomatonGroups::addAutomaton(const StrangerAutomaton* automaton
 }
 
 AutomatonGroup* AutomatonGroups::addGroup(const StrangerAutomaton* automaton) {
- AutomatonGroup group(automaton, m_id);
+  AutomatonGroup group(automaton, m_id);
   m_id++;
   m_groups.push_back(group);
-  return &m_groups.back(); 
+  if (automaton == nullptr) {
+    m_null_group = m_groups.size() - 1;
+  } else {
+    m_index.insert(std::make_pair(group.getFingerprint(), m_groups.size() - 1));
+  }
+  return &m_groups.back();
 }
 
 AutomatonGroup* AutomatonGroups::addNewEntry(const StrangerAutomaton* automaton, const CombinedAnalysisResult* graph)
@@ -397,42 +419,36 @@ AutomatonGroup* AutomatonGroups::addNewEntry(const StrangerAutomaton* automaton,
   return group;
 }
 
-AutomatonGroup* AutomatonGroups::getGroupForAutomaton(const StrangerAutomaton* automaton)
+int AutomatonGroups::findGroupIndex(const StrangerAutomaton* automaton) const
 {
-  for (auto iter = m_groups.begin(); iter != m_groups.end(); ++iter) {
-    const StrangerAutomaton* existing = iter->getAutomaton();
-    // std::cout << "Comparing insertion automaton (nstates: "
-    //           << ((automaton != nullptr) ? automaton->get_num_of_states() : -2)
-    //           <<" to group: " << iter->getName() << " with states: "
-    //           << ((existing != nullptr) ? existing->get_num_of_states() : -2)
-    //           << std::endl;
-    // Both are null, found a match!
-    if ((automaton == nullptr) && (existing == nullptr)) {
-      return &(*iter);
-    }
-    // If one is null, but the other not don't match
-    if ((automaton == nullptr) || (existing == nullptr)) {
-      continue;
-    }
-    // Otherwise check
+  // Null automata (errored analyses) only match each other
+  if (automaton == nullptr) {
+    return m_null_group;
+  }
+  // Only groups with the same fingerprint can be equal, so just
+  // check those to rule out hash collisions
+  auto range = m_index.equal_range(automaton->getFingerprint());
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    const StrangerAutomaton* existing = m_groups.at(iter->second).getAutomaton();
     if ((automaton == existing) ||
         ((automaton->get_num_of_states()  == existing->get_num_of_states())
          && automaton->equals(existing))) {
-      return &(*iter);
+      return iter->second;
     }
   }
-  return nullptr;
+  return -1;
+}
+
+AutomatonGroup* AutomatonGroups::getGroupForAutomaton(const StrangerAutomaton* automaton)
+{
+  int index = findGroupIndex(automaton);
+  return (index >= 0) ? &m_groups.at(index) : nullptr;
 }
 
 const AutomatonGroup* AutomatonGroups::getGroupForAutomaton(const StrangerAutomaton* automaton) const
 {
-  for (auto iter = m_groups.begin(); iter != m_groups.end(); ++iter) {
-    const StrangerAutomaton* existing = iter->getAutomaton();
-    if (automaton->equals(existing)) {
-      return &(*iter);
-    }
-  }
-  return nullptr;
+  int index = findGroupIndex(automaton);
+  return (index >= 0) ? &m_groups.at(index) : nullptr;
 }
 
 void AutomatonGroups::printStatus(std::ostream& os) const
@@ -637,6 +653,7 @@ void AutomatonGroups::printTotals(std::ostream& os, const std::vector<AttackCont
     os << getContainedEntriesForContext(context) << ", ";
     os << entries - success << ", ";
     os << getSuccessfulGroupsForContext(context) << ", ";
+    os << getErroredEntriesForContext(context) << ", ";
   }
   os << ", " << std::endl;
 
@@ -655,6 +672,7 @@ void AutomatonGroups::printTotals(std::ostream& os, const std::vector<AttackCont
     os << getContainedEntriesForContext(context) << ", ";
     os << entries - success << ", ";
     os << getSuccessfulGroupsForContext(context) << ", ";
+    os << getErroredEntriesForContext(context) << ", ";
   }
   os << ", " << std::endl;
 
@@ -671,6 +689,7 @@ void AutomatonGroups::printTotals(std::ostream& os, const std::vector<AttackCont
     os << getContainedEntriesForContext(context) << ", ";
     os << entries - success << ", ";
     os << getSuccessfulGroupsForContext(context) << ", ";
+    os << getErroredEntriesForContext(context) << ", ";
   }
   os << ", " << std::endl;
 }
@@ -700,6 +719,14 @@ unsigned int AutomatonGroups::getContainedEntriesForContext(const AttackContext&
   return total;
 }
 
+unsigned int AutomatonGroups::getErroredEntriesForContext(const AttackContext& context) const {
+  unsigned int total = 0;
+  for (auto iter = m_groups.begin(); iter != m_groups.end(); ++iter) {
+    total += iter->getErroredEntriesForContext(context);
+  }
+  return total;
+}
+
 unsigned int AutomatonGroups::getSuccessfulGroupsForContext(const AttackContext& context) const {
   unsigned int total = 0;
   for (auto iter = m_groups.begin(); iter != m_groups.end(); ++iter) {
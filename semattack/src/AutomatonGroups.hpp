@@ -25,8 +25,10 @@
 #ifndef AUTOMATON_GROUPS_HPP_
 #define AUTOMATON_GROUPS_HPP_
 
+#include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "StrangerAutomaton.hpp"
@@ -46,12 +48,18 @@ public:
     void setName(const std::string& name);
     std::string getName() const;
     const StrangerAutomaton* getAutomaton() const;
+    // Unique among the groups and stable, unlike their addresses
+    int getId() const { return m_id; }
+    unsigned long long getFingerprint() const { return m_fingerprint; }
+    // Attack pattern verdicts shared by the members, nullptr for the NULL group
+    const std::shared_ptr<GroupVerdicts>& getVerdicts() const { return m_verdicts; }
     void addCombinedAnalysisResult(const CombinedAnalysisResult* graph);
     size_t getEntries() const { return m_graphs.size(); }
     unsigned int getEntriesWithDuplicates() const;
     unsigned int getNonUniqueEntries() const;
     unsigned int getSuccessfulEntriesForContext(const AttackContext& context) const;
     unsigned int getContainedEntriesForContext(const AttackContext& context) const;
+    unsigned int getErroredEntriesForContext(const AttackContext& context) const;
     unsigned int getSuccessfulValidated() const;
     unsigned int getErrored() const;
     unsigned int getSanitizersForPayload() const;
@@ -78,7 +86,9 @@ public:
     void printGeneratedPayloads(std::ostream& os) const;
 private:
     const StrangerAutomaton* m_automaton;
+    unsigned long long m_fingerprint;
     std::vector<const CombinedAnalysisResult*> m_graphs;
+    std::shared_ptr<GroupVerdicts> m_verdicts;
     std::string m_name;
     int m_id;
 
@@ -108,6 +118,7 @@ public:
     unsigned int getNonUniqueEntries() const;
     unsigned int getSuccessfulEntriesForContext(const AttackContext& context) const;
     unsigned int getContainedEntriesForContext(const AttackContext& context) const;
+    unsigned int getErroredEntriesForContext(const AttackContext& context) const;
     unsigned int getSuccessfulGroupsForContext(const AttackContext& context) const;
     unsigned int getSuccessfulValidated() const;
     unsigned int getErrored() const;
@@ -139,7 +150,12 @@ public:
 private:
 
     std::vector<AutomatonGroup> m_groups;
+    // Index of groups by the fingerprint of their automaton
+    std::unordered_multimap<unsigned long long, size_t> m_index;
+    // Index of the group for the null automaton, -1 if there is none
+    int m_null_group;
     int m_id;
+    int findGroupIndex(const StrangerAutomaton* automaton) const;
     AutomatonGroup* addNewEntry(const StrangerAutomaton* automaton, const CombinedAnalysisResult* graph);
     void printTotals(std::ostream& os, const std::vector<AttackContext>& contexts) const;
     void printHistogram(std::ostream& os, const std::vector<size_t>& data, size_t max) const;
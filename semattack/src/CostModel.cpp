@@ -0,0 +1,325 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * CostModel.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#include "CostModel.hpp"
+#include "depgraph/CompactDepGraph.hpp"
+#include "depgraph/DepGraphOpNode.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+// Seconds per unit of each feature, in the order of CostFeatures::toVector()
+static const double DEFAULT_WEIGHTS[CostFeatures::size] = {
+  0.01,   // constant
+  0.001,  // nodes
+  0.0005, // edges
+  0.01,   // substr
+  0.05,   // replace
+  0.02,   // encode and decode
+  0.05,   // scc nodes
+  0.5,    // approximated
+  0.5     // infinite regex
+};
+static const double DEFAULT_SECONDS_PER_BYTE = 0.00001;
+// Pulls the fitted weights towards the defaults when there are few samples
+static const double RIDGE = 1.0;
+
+CostFeatures::CostFeatures()
+  : nodes(0)
+  , edges(0)
+  , substr_ops(0)
+  , replace_ops(0)
+  , encode_ops(0)
+  , scc_nodes(0)
+  , approximated(false)
+  , infinite_regex(false)
+{
+}
+
+std::vector<double> CostFeatures::toVector() const
+{
+  return { 1.0, (double) nodes, (double) edges, (double) substr_ops,
+           (double) replace_ops, (double) encode_ops, (double) scc_nodes,
+           approximated ? 1.0 : 0.0, infinite_regex ? 1.0 : 0.0 };
+}
+
+CostModel::Sample::Sample()
+  : features()
+  , bytes(0)
+  , seconds(0.0)
+  , estimate(0.0)
+{
+}
+
+CostModel::CostModel()
+  : m_mutex()
+  , m_weights(DEFAULT_WEIGHTS, DEFAULT_WEIGHTS + CostFeatures::size)
+  , m_seconds_per_byte(DEFAULT_SECONDS_PER_BYTE)
+  , m_recorded()
+  , m_samples()
+  , m_fitted_samples(0)
+{
+}
+
+CostFeatures CostModel::getFeatures(const DepGraph& graph)
+{
+  CostFeatures features;
+  const CompactDepGraph& compact = graph.getCompactGraph();
+  features.nodes = compact.size();
+  features.edges = graph.getNumOfEdges();
+  for (int i = 0; i < compact.size(); i++) {
+    const DepGraphOpNode* op = dynamic_cast<const DepGraphOpNode*>(compact.nodeAt(i));
+    if (op == nullptr) {
+      continue;
+    }
+    const std::string& name = op->getName();
+    if (name.find("substr") != std::string::npos) {
+      features.substr_ops++;
+    } else if (name.find("replace") != std::string::npos) {
+      features.replace_ops++;
+    } else if (name.find("code") != std::string::npos || name.find("escape") != std::string::npos) {
+      // encodeURIComponent, decodeURI, escape, ...
+      features.encode_ops++;
+    }
+  }
+  for (auto& scc : compact.getSCCs()) {
+    features.scc_nodes += scc.second.size();
+  }
+  const Metadata& metadata = graph.get_metadata();
+  features.approximated = metadata.has_approximated_method();
+  features.infinite_regex = metadata.has_infinite_regex();
+  return features;
+}
+
+double CostModel::estimate(const fs::path& file, const CostFeatures& features)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  Sample& sample = m_samples[file.string()];
+  sample.features = features;
+  auto search = m_recorded.find(file.string());
+  if (search != m_recorded.end()) {
+    sample.estimate = search->second;
+  } else {
+    std::vector<double> values = features.toVector();
+    sample.estimate = 0.0;
+    for (int i = 0; i < CostFeatures::size; i++) {
+      sample.estimate += m_weights[i] * values[i];
+    }
+  }
+  return sample.estimate;
+}
+
+double CostModel::estimateBeforeParse(const fs::path& file) const
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  auto search = m_recorded.find(file.string());
+  if (search != m_recorded.end()) {
+    return search->second;
+  }
+  boost::system::error_code ec;
+  unsigned long bytes = fs::file_size(file, ec);
+  return ec ? 0.0 : m_seconds_per_byte * bytes;
+}
+
+double CostModel::getEstimate(const fs::path& file) const
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  auto search = m_samples.find(file.string());
+  return (search != m_samples.end()) ? search->second.estimate : 0.0;
+}
+
+void CostModel::addTime(const fs::path& file, double seconds)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_samples[file.string()].seconds += seconds;
+}
+
+/**
+ * Each line holds the seconds, the file size, the features and the file
+ * name, as written by writeTimings. Lines which do not parse are skipped.
+ */
+bool CostModel::loadTimings(const fs::path& path)
+{
+  std::ifstream ifs(path.string());
+  if (!ifs.is_open()) {
+    return false;
+  }
+  std::vector<Sample> samples;
+  std::map<std::string, double> recorded;
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream ls(line);
+    Sample sample;
+    int approximated = 0;
+    int infinite_regex = 0;
+    char sep;
+    std::string file;
+    if (!(ls >> sample.seconds >> sep >> sample.bytes >> sep
+          >> sample.features.nodes >> sep >> sample.features.edges >> sep
+          >> sample.features.substr_ops >> sep >> sample.features.replace_ops >> sep
+          >> sample.features.encode_ops >> sep >> sample.features.scc_nodes >> sep
+          >> approximated >> sep >> infinite_regex >> sep)
+        || !std::getline(ls, file) || file.empty()) {
+      continue;
+    }
+    sample.features.approximated = approximated != 0;
+    sample.features.infinite_regex = infinite_regex != 0;
+    recorded[file] = sample.seconds;
+    samples.push_back(sample);
+  }
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_recorded.swap(recorded);
+  fit(samples);
+  return true;
+}
+
+void CostModel::writeTimings(const fs::path& path) const
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  std::ofstream ofs(path.string());
+  ofs << "# seconds,bytes,nodes,edges,substr,replace,encode,scc_nodes,approximated,infinite_regex,file" << std::endl;
+  boost::system::error_code ec;
+  for (auto& entry : m_samples) {
+    const Sample& sample = entry.second;
+    if (sample.seconds <= 0.0) {
+      continue;
+    }
+    unsigned long bytes = fs::file_size(entry.first, ec);
+    const CostFeatures& f = sample.features;
+    ofs << sample.seconds << "," << (ec ? 0 : bytes) << ","
+        << f.nodes << "," << f.edges << "," << f.substr_ops << ","
+        << f.replace_ops << "," << f.encode_ops << "," << f.scc_nodes << ","
+        << (f.approximated ? 1 : 0) << "," << (f.infinite_regex ? 1 : 0) << ","
+        << entry.first << std::endl;
+  }
+}
+
+/**
+ * Ridge regression towards the default weights: solves
+ * (X^T X + r I) w = X^T y + r w0 by Gaussian elimination. Features such as
+ * nodes and edges are nearly collinear, so instead of clamping a negative
+ * weight the most negative feature is dropped and the rest is fitted again.
+ * Caller must hold m_mutex.
+ */
+void CostModel::fit(const std::vector<Sample>& samples)
+{
+  const int n = CostFeatures::size;
+  if (samples.empty()) {
+    return;
+  }
+  std::vector<std::vector<double> > xtx(n, std::vector<double>(n, 0.0));
+  std::vector<double> xty(n, 0.0);
+  double total_seconds = 0.0;
+  double total_bytes = 0.0;
+  for (auto& sample : samples) {
+    std::vector<double> x = sample.features.toVector();
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        xtx[i][j] += x[i] * x[j];
+      }
+      xty[i] += x[i] * sample.seconds;
+    }
+    total_seconds += sample.seconds;
+    total_bytes += sample.bytes;
+  }
+
+  std::vector<int> active;
+  for (int i = 0; i < n; i++) {
+    active.push_back(i);
+  }
+  std::vector<double> weights(n, 0.0);
+  while (!active.empty()) {
+    int m = active.size();
+    std::vector<std::vector<double> > a(m, std::vector<double>(m + 1, 0.0));
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < m; j++) {
+        a[i][j] = xtx[active[i]][active[j]];
+      }
+      a[i][i] += RIDGE;
+      a[i][m] = xty[active[i]] + RIDGE * DEFAULT_WEIGHTS[active[i]];
+    }
+    for (int col = 0; col < m; col++) {
+      int pivot = col;
+      for (int row = col + 1; row < m; row++) {
+        if (std::fabs(a[row][col]) > std::fabs(a[pivot][col])) {
+          pivot = row;
+        }
+      }
+      std::swap(a[col], a[pivot]);
+      for (int row = col + 1; row < m; row++) {
+        double factor = a[row][col] / a[col][col];
+        for (int k = col; k <= m; k++) {
+          a[row][k] -= factor * a[col][k];
+        }
+      }
+    }
+    std::vector<double> solution(m, 0.0);
+    for (int row = m - 1; row >= 0; row--) {
+      double sum = a[row][m];
+      for (int k = row + 1; k < m; k++) {
+        sum -= a[row][k] * solution[k];
+      }
+      solution[row] = sum / a[row][row];
+    }
+    int most_negative = -1;
+    for (int i = 0; i < m; i++) {
+      if (!std::isfinite(solution[i])) {
+        return;
+      }
+      if (solution[i] < 0.0 && (most_negative < 0 || solution[i] < solution[most_negative])) {
+        most_negative = i;
+      }
+    }
+    if (most_negative < 0) {
+      std::fill(weights.begin(), weights.end(), 0.0);
+      for (int i = 0; i < m; i++) {
+        weights[active[i]] = solution[i];
+      }
+      break;
+    }
+    active.erase(active.begin() + most_negative);
+  }
+  m_weights = weights;
+  if (total_bytes > 0.0) {
+    m_seconds_per_byte = total_seconds / total_bytes;
+  }
+  m_fitted_samples = samples.size();
+}
+
+void CostModel::printStatus(std::ostream& os) const
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  os << "# Cost model recorded timings --> fitted samples --> weights" << std::endl;
+  os << "# " << m_recorded.size() << " --> " << m_fitted_samples << " -->";
+  for (double w : m_weights) {
+    os << " " << w;
+  }
+  os << std::endl;
+}
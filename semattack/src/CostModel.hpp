@@ -0,0 +1,111 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * CostModel.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef COST_MODEL_HPP_
+#define COST_MODEL_HPP_
+
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "depgraph/DepGraph.hpp"
+
+namespace fs = boost::filesystem;
+
+// Features of a dependency graph known after parsing which drive the
+// time of its analysis
+struct CostFeatures {
+  CostFeatures();
+
+  int nodes;
+  int edges;
+  int substr_ops;
+  int replace_ops;
+  int encode_ops;
+  // Nodes in strongly connected components, these need a fixpoint
+  int scc_nodes;
+  bool approximated;
+  bool infinite_regex;
+
+  // Number of entries of toVector()
+  static const int size = 9;
+  // Feature values with a leading constant term
+  std::vector<double> toVector() const;
+};
+
+// Estimates the analysis time of a dependency graph in seconds, so the
+// most expensive graphs can be started first. The default linear weights
+// are refined from the timings written by a previous run.
+class CostModel {
+
+public:
+  CostModel();
+
+  static CostFeatures getFeatures(const DepGraph& graph);
+
+  // Expected seconds for the whole analysis of a parsed graph, the
+  // recorded time is used if the file was analysed in a previous run
+  double estimate(const fs::path& file, const CostFeatures& features);
+  // Estimate from the file size, used to order the parsing
+  double estimateBeforeParse(const fs::path& file) const;
+  // The last estimate given for a file
+  double getEstimate(const fs::path& file) const;
+
+  // Adds to the time spent on a file in this run
+  void addTime(const fs::path& file, double seconds);
+
+  // Reads timings of a previous run and fits the weights to them
+  bool loadTimings(const fs::path& path);
+  void writeTimings(const fs::path& path) const;
+
+  unsigned int getRecordedTimings() const { return m_recorded.size(); }
+
+  void printStatus(std::ostream& os) const;
+
+private:
+  struct Sample {
+    Sample();
+    CostFeatures features;
+    unsigned long bytes;
+    double seconds;
+    double estimate;
+  };
+
+  void fit(const std::vector<Sample>& samples);
+
+  mutable std::mutex m_mutex;
+  std::vector<double> m_weights;
+  double m_seconds_per_byte;
+  // Seconds per file from the previous run
+  std::map<std::string, double> m_recorded;
+  // Features and timings of this run
+  std::map<std::string, Sample> m_samples;
+  unsigned int m_fitted_samples;
+};
+
+#endif /* COST_MODEL_HPP_ */
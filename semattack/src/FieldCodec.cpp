@@ -0,0 +1,58 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * FieldCodec.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#include "FieldCodec.hpp"
+
+void FieldCodec::writeInt(std::ostream& os, long value)
+{
+  os << value << ';';
+}
+
+long FieldCodec::readInt(std::istream& is)
+{
+  long value = 0;
+  char sep = 0;
+  if (is >> value >> sep && sep != ';') {
+    is.setstate(std::ios::failbit);
+  }
+  return value;
+}
+
+void FieldCodec::writeString(std::ostream& os, const std::string& value)
+{
+  os << value.size() << ':' << value;
+}
+
+std::string FieldCodec::readString(std::istream& is)
+{
+  size_t size = 0;
+  char sep = 0;
+  if (!(is >> size >> sep) || sep != ':') {
+    is.setstate(std::ios::failbit);
+    return "";
+  }
+  std::string value(size, '\0');
+  is.read(&value[0], size);
+  return value;
+}
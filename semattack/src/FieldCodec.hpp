@@ -0,0 +1,45 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * FieldCodec.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef FIELD_CODEC_HPP_
+#define FIELD_CODEC_HPP_
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+// Fields of the messages to worker processes and of the result journal.
+// Strings are prefixed with their length, so they may hold any character.
+// A failed read leaves the stream failed, which callers check once at the
+// end of a record.
+class FieldCodec {
+
+public:
+  static void writeInt(std::ostream& os, long value);
+  static long readInt(std::istream& is);
+  static void writeString(std::ostream& os, const std::string& value);
+  static std::string readString(std::istream& is);
+};
+
+#endif /* FIELD_CODEC_HPP_ */
@@ -34,6 +34,11 @@ ImageComputer::ImageComputer()
     , m_doConcats(true)
     , m_doSubstr(true)
     , m_inputAuto(nullptr)
+    , m_freeDeadAutomata(false)
+    , m_keepBackwardNodes(true)
+    , m_remainingConsumers()
+    , m_pinned()
+    , m_retired()
 {
 }
 
@@ -42,6 +47,11 @@ ImageComputer::ImageComputer(bool doConcats, bool doSubstr, StrangerAutomaton* i
     , m_doConcats(doConcats)
     , m_doSubstr(doSubstr)
     , m_inputAuto(inputAuto)
+    , m_freeDeadAutomata(false)
+    , m_keepBackwardNodes(true)
+    , m_remainingConsumers()
+    , m_pinned()
+    , m_retired()
 {
 }
 
@@ -61,7 +71,7 @@ ImageComputer::~ImageComputer() {
 
 
 
-PerfInfo* ImageComputer::perfInfo = &PerfInfo::getInstance();
+thread_local PerfInfo* ImageComputer::perfInfo = &PerfInfo::getInstance();
 
 /*******************************************************************************************************************************/
 /*********** SANITIZATION PATCH EXTRACTION METHODS *****************************************************************************/
@@ -85,6 +95,10 @@ void ImageComputer::doForwardAnalysis_SingleInput(
 	stack<DepGraphNode*> process_stack;
 	set<DepGraphNode*> visited;
 
+	if (m_freeDeadAutomata) {
+		initLiveness(origDepGraph, inputDepGraph);
+	}
+
 	process_stack.push( inputDepGraph.getRoot() );
 	while (!process_stack.empty()) {
 
@@ -111,6 +125,10 @@ void ImageComputer::doForwardAnalysis_SingleInput(
 void ImageComputer::doPostImageComputation_SingleInput(
     DepGraph& origDepGraph, DepGraph& inputDepGraph, DepGraphNode* node, AnalysisResult& analysisResult) {
 
+    if (isRetired(node)) {
+        return;
+    }
+
     NodesList successors = origDepGraph.getSuccessors(node);
 
     StrangerAutomaton* newAuto = nullptr;
@@ -161,6 +179,83 @@ void ImageComputer::doPostImageComputation_SingleInput(
     }
 
     analysisResult.set(node->getID(), newAuto);
+    retireNode(origDepGraph, node, analysisResult);
+}
+
+/**
+ * Counts for every node below the root how many distinct nodes read its
+ * forward automaton and pins the nodes that have to survive the analysis.
+ */
+void ImageComputer::initLiveness(DepGraph& origDepGraph, DepGraph& inputDepGraph) {
+    m_remainingConsumers.clear();
+    m_pinned.clear();
+    m_retired.clear();
+
+    DepGraphNode* root = inputDepGraph.getRoot();
+    m_pinned.insert(root->getID());
+
+    stack<DepGraphNode*> process_stack;
+    set<int> visited;
+    process_stack.push(root);
+    visited.insert(root->getID());
+    while (!process_stack.empty()) {
+        DepGraphNode* curr = process_stack.top();
+        process_stack.pop();
+        // uninit nodes are initialized before the analysis and scc members
+        // are read repeatedly while widening
+        if (dynamic_cast<DepGraphUninitNode*>(curr) != nullptr || origDepGraph.isSCCElement(curr)) {
+            m_pinned.insert(curr->getID());
+        }
+        set<int> consumed;
+        for (auto succ_node : origDepGraph.getSuccessors(curr)) {
+            if (succ_node->getID() == curr->getID() || !consumed.insert(succ_node->getID()).second) {
+                continue;
+            }
+            m_remainingConsumers[succ_node->getID()]++;
+            if (visited.insert(succ_node->getID()).second) {
+                process_stack.push(succ_node);
+            }
+        }
+    }
+
+    if (m_keepBackwardNodes) {
+        for (auto node : inputDepGraph.getNodes()) {
+            m_pinned.insert(node->getID());
+            if (dynamic_cast<DepGraphOpNode*>(node) != nullptr) {
+                for (auto succ_node : origDepGraph.getSuccessors(node)) {
+                    m_pinned.insert(succ_node->getID());
+                }
+            }
+        }
+    }
+}
+
+bool ImageComputer::isRetired(const DepGraphNode* node) const {
+    return m_freeDeadAutomata && m_retired.count(node->getID()) > 0;
+}
+
+/**
+ * Called once the automaton of node is computed, node will not read its
+ * successors again so the ones without any other pending reader are freed.
+ */
+void ImageComputer::retireNode(DepGraph& depGraph, const DepGraphNode* node, AnalysisResult& analysisResult) {
+    if (!m_freeDeadAutomata || !m_retired.insert(node->getID()).second) {
+        return;
+    }
+    set<int> consumed;
+    for (auto succ_node : depGraph.getSuccessors(node)) {
+        int id = succ_node->getID();
+        if (id == node->getID() || !consumed.insert(id).second) {
+            continue;
+        }
+        auto it = m_remainingConsumers.find(id);
+        if (it == m_remainingConsumers.end()) {
+            continue;
+        }
+        if (--(it->second) <= 0 && m_pinned.count(id) == 0) {
+            analysisResult.release(id);
+        }
+    }
 }
 
 /*******************************************************************************************************************************/
@@ -296,6 +391,7 @@ void ImageComputer::doPreImageComputationForSCC_GeneralCase(const DepGraph& orig
 	int coarse_widening_limit = 20;
 
 	int scc_id = origDepGraph.getSCCID(node);
+	const CompactDepGraph& graph = origDepGraph.getCompactGraph();
 
 	map<int, int> visit_count;
 	NodesList current_scc_nodes = origDepGraph.getSCCNodes(scc_id);
@@ -320,11 +416,13 @@ void ImageComputer::doPreImageComputationForSCC_GeneralCase(const DepGraph& orig
 	do {
 		DepGraphNode* curr_node = worklist.front();
 		worklist.pop();
+		int curr_index = graph.indexOf(curr_node);
 		// calculate the values for predecessors (in a depgraph predecessors are children during forward analysis)
-		for (auto succ_node : origDepGraph.getSuccessors(curr_node)) {
+		for (const int* succ = graph.succBegin(curr_index); succ != graph.succEnd(curr_index); ++succ) {
 			// ignore nodes that are not part of the current scc
-			if (!origDepGraph.isSCCElement(succ_node) || origDepGraph.getSCCID(succ_node) != scc_id)
+			if (graph.getSCCID(*succ) != scc_id)
 				continue;
+			DepGraphNode* succ_node = graph.nodeAt(*succ);
 
 			const StrangerAutomaton* forward_auto = fwAnalysisResult.find(succ_node->getID())->second;
 			const StrangerAutomaton* prev_auto = bwAnalysisResult.get(succ_node->getID());
@@ -386,6 +484,7 @@ StrangerAutomaton* ImageComputer::makePreImageForOpChild_GeneralCase(
 	NodesList successors = depGraph.getSuccessors(opNode);
 	const StrangerAutomaton* opAuto = bwAnalysisResult.get(opNode->getID());
 	string opName = opNode->getName();
+	boost::posix_time::ptime op_start_time = perfInfo->current_time();
 
 
 
@@ -407,7 +506,7 @@ StrangerAutomaton* ImageComputer::makePreImageForOpChild_GeneralCase(
 		} else {
 			throw StrangerException(AnalysisError::MalformedDepgraph, stringbuilder() << "child node (" << childNode->getID() << ") of __vlab_restrict (" << opNode->getID() << ") is not in backward path");
 		}
-		perfInfo->pre_vlab_restrict_total_time += perfInfo->current_time() - start_time;
+		perfInfo->pre_vlab_restrict_total_time += perfInfo->record_operation("pre_vlab_restrict", start_time);
 		perfInfo->number_of_pre_vlab_restrict++;
 
 	} else if ((opName == ".") || (opName == "concat")) {
@@ -541,12 +640,21 @@ StrangerAutomaton* ImageComputer::makePreImageForOpChild_GeneralCase(
 			string patternStr = patternAuto->generateSatisfyingExample();
 			if ( replaceStr.length() == 2 && patternStr.length() == 1 && patternStr[0] == replaceStr[1]) {
 				retMe = StrangerAutomaton::general_replace(replaceAuto, patternAuto, subjectAuto, childNode->getID());
+			} else if (replaceStr.length() == 1 && patternStr.length() == 1) {
+				// a character translation, its pre-image is the inverse image of the map
+				retMe = subjectAuto->preTranslateChars({ { patternStr[0], replaceStr[0] } }, childNode->getID());
 			} else {
 				retMe = subjectAuto->preReplace(patternAuto, replaceStr, childNode->getID());
 			}
 		} else {
 			retMe = subjectAuto->preReplace(patternAuto, replaceStr, childNode->getID());
 		}
+	} else if (opName == "escape_chars") {
+		// an annotated replace of a character class, see DepGraph::parseStream
+		if (successors.size() != 3 || !childNode->equals(successors[2])) {
+			throw StrangerException(AnalysisError::MalformedDepgraph, stringbuilder() << "SNH: child node (" << childNode->getID() << ") of escape_chars (" << opNode->getID() << ") is not its subject");
+		}
+		retMe = StrangerAutomaton::pre_escapeChars(opAuto, opNode->getEscapes(), childNode->getID());
         } else if (opName == "str_replace_once") {
             if (successors.size() != 3) {
                 throw StrangerException(AnalysisError::MalformedDepgraph, stringbuilder() << "replace invalid number of arguments");
@@ -661,6 +769,7 @@ StrangerAutomaton* ImageComputer::makePreImageForOpChild_GeneralCase(
 		throw StrangerException(AnalysisError::NotImplemented,  "Not implemented yet for regular validation phase: " + opName);
 	}
 
+	perfInfo->record_depgraph_pre_op(opName, op_start_time);
 	return retMe;
 }
 
@@ -784,6 +893,10 @@ void ImageComputer::doForwardAnalysis_GeneralCase(DepGraph& depGraph, DepGraphNo
 
 void ImageComputer::doPostImageComputation_GeneralCase(DepGraph& depGraph, DepGraphNode* node, AnalysisResult& analysisResult) {
 
+	if (isRetired(node)) {
+		return;
+	}
+
 	NodesList successors = depGraph.getSuccessors(node);
 
 	StrangerAutomaton* newAuto = nullptr;
@@ -823,6 +936,7 @@ void ImageComputer::doPostImageComputation_GeneralCase(DepGraph& depGraph, DepGr
 		throw StrangerException(AnalysisError::MalformedDepgraph, stringbuilder() << "Forward automaton cannot be computed!, node id: " << node->getID());
 	}
 	analysisResult.set(node->getID(), newAuto);
+	retireNode(depGraph, node, analysisResult);
 }
 
 /**
@@ -835,6 +949,7 @@ void ImageComputer::doPostImageComputationForSCC_GeneralCase(DepGraph& depGraph,
 	int coarse_widening_limit = 20;
 
 	int scc_id = depGraph.getSCCID(node);
+	const CompactDepGraph& graph = depGraph.getCompactGraph();
 
 	map<int, int> visit_count;
 	NodesList current_scc_nodes = depGraph.getSCCNodes(scc_id);
@@ -859,11 +974,13 @@ void ImageComputer::doPostImageComputationForSCC_GeneralCase(DepGraph& depGraph,
 	do {
 		DepGraphNode* curr_node = worklist.front();
 		worklist.pop();
+		int curr_index = graph.indexOf(curr_node);
 		// calculate the values for predecessors (in a depgraph predecessors are children during forward analysis)
-		for (auto pred_node : depGraph.getPredecessors(curr_node)) {
+		for (const int* pred = graph.predBegin(curr_index); pred != graph.predEnd(curr_index); ++pred) {
 			// ignore nodes that are not part of the current scc
-			if (!depGraph.isSCCElement(pred_node) || depGraph.getSCCID(pred_node) != scc_id)
+			if (graph.getSCCID(*pred) != scc_id)
 				continue;
+			DepGraphNode* pred_node = graph.nodeAt(*pred);
 
 			const StrangerAutomaton* prev_auto = analysisResult.get(pred_node->getID()); // may need clone
 			StrangerAutomaton* tmp_auto = nullptr;
@@ -915,6 +1032,8 @@ StrangerAutomaton* ImageComputer::makePostImageForOp_GeneralCase(DepGraph& depGr
 	NodesList successors = depGraph.getSuccessors(opNode);
 	StrangerAutomaton* retMe = nullptr;
 	string opName = opNode->getName();
+	// in single input mode this includes the recursive analysis of the operands
+	boost::posix_time::ptime op_start_time = perfInfo->current_time();
         //cout << "Computing : " << opName << endl;
 	// __vlab_restrict
 	if (opName.find("__vlab_restrict") != string::npos) {
@@ -953,7 +1072,7 @@ StrangerAutomaton* ImageComputer::makePostImageForOp_GeneralCase(DepGraph& depGr
 			retMe = subjectAuto->intersect(complementAuto, opNode->getID());
 			delete complementAuto;
 		}
-		perfInfo->vlab_restrict_total_time += perfInfo->current_time() - start_time;
+		perfInfo->vlab_restrict_total_time += perfInfo->record_operation("vlab_restrict", start_time);
 		perfInfo->number_of_vlab_restrict++;
 
 	} else if ((opName == ".") || (opName == "concat")) {
@@ -1030,6 +1149,19 @@ StrangerAutomaton* ImageComputer::makePostImageForOp_GeneralCase(DepGraph& depGr
 
 		retMe = StrangerAutomaton::general_replace(patternAuto,replaceAuto,subjectAuto, opNode->getID());
 
+	} else if (opName == "escape_chars") {
+		// an annotated replace of a character class, see DepGraph::parseStream
+		if (successors.size() != 3) {
+			throw StrangerException(AnalysisError::MalformedDepgraph, stringbuilder() << "escape_chars invalid number of arguments: " << opNode->getID());
+		}
+
+		DepGraphNode* subjectNode = successors[2];
+		if (analysisResult.find(subjectNode->getID()) == analysisResult.end()) {
+			doForwardAnalysis_GeneralCase(depGraph, subjectNode, analysisResult);
+		}
+		const StrangerAutomaton* subjectAuto = analysisResult.get(subjectNode->getID());
+		retMe = StrangerAutomaton::escapeChars(subjectAuto, opNode->getEscapes(), opNode->getID());
+
 	} else if (opName == "str_replace_once") {
 		if (successors.size() != 3) {
 			throw StrangerException(AnalysisError::MalformedDepgraph, stringbuilder() << "replace invalid number of arguments: " << opNode->getID());
@@ -1331,5 +1463,6 @@ StrangerAutomaton* ImageComputer::makePostImageForOp_GeneralCase(DepGraph& depGr
     }
 
         //retMe->printAutomatonVitals();
+    perfInfo->record_depgraph_op(opName, op_start_time);
     return retMe;
 }
@@ -26,6 +26,8 @@
 #ifndef IMAGECOMPUTER_HPP_
 #define IMAGECOMPUTER_HPP_
 
+#include <map>
+#include <set>
 #include "AnalysisResult.hpp"
 #include "StrangerAutomaton.hpp"
 #include "depgraph/DepGraph.hpp"
@@ -36,6 +38,17 @@ public:
     ImageComputer(bool doConcats, bool doSubstr, StrangerAutomaton* inputAuto);
     virtual ~ImageComputer();
 
+    /**
+     * Frees the forward automaton of a node as soon as all nodes reading it
+     * have been computed. If keepBackwardNodes is set, the nodes read by the
+     * backward analysis (the input relevant graph and the operands of its
+     * operations) are kept.
+     */
+    void setFreeDeadAutomata(bool freeDead, bool keepBackwardNodes = true) {
+        m_freeDeadAutomata = freeDead;
+        m_keepBackwardNodes = keepBackwardNodes;
+    }
+
     /****************************************************************************************************/
     /*********** SINGLE INPUT POST-IMAGE COMPUTATION METHODS **********************************************/
     /****************************************************************************************************/
@@ -61,7 +74,7 @@ public:
     StrangerAutomaton* makePostImageForOp_GeneralCase(DepGraph& depGraph, DepGraphOpNode* opNode, AnalysisResult& analysisResult);
     void doPostImageComputationForSCC_GeneralCase(DepGraph& depGraph, DepGraphNode* node, AnalysisResult& analysisResult);
 
-    static PerfInfo* perfInfo;
+    static thread_local PerfInfo* perfInfo;
 
 protected:
     std::string getLiteralOrConstantValue(const DepGraphNode* node);
@@ -72,6 +85,10 @@ protected:
     */
     StrangerAutomaton* getLiteralorConstantNodeAuto(const DepGraphNode* node, bool is_vlab_restrict);
 
+    void initLiveness(DepGraph& origDepGraph, DepGraph& inputDepGraph);
+    bool isRetired(const DepGraphNode* node) const;
+    void retireNode(DepGraph& depGraph, const DepGraphNode* node, AnalysisResult& analysisResult);
+
 private:
 
     StrangerAutomaton* uninit_node_default_initialization;
@@ -81,6 +98,13 @@ private:
     bool m_doConcats;
     bool m_doSubstr;
 
+    // Liveness of forward automata, keyed by node id
+    bool m_freeDeadAutomata;
+    bool m_keepBackwardNodes;
+    std::map<int, int> m_remainingConsumers;
+    std::set<int> m_pinned;
+    std::set<int> m_retired;
+
 };
 
 
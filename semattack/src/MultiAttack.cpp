@@ -25,19 +25,77 @@
 
 #include "SemAttack.hpp"
 #include "AttackPatterns.hpp"
+#include "AttackPatternRegistry.hpp"
+#include "FieldCodec.hpp"
 #include "MultiAttack.hpp"
 #include "StrangerAutomaton.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <chrono>
 #include <thread>
 #include <algorithm>
 #include <functional>
+#include <limits>
+#include <set>
+#include <sstream>
 #include <unordered_set>
 #include <boost/thread.hpp>
 
+#include <unistd.h>
+
 namespace asio = boost::asio;
 
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Errors which depend on the limits or the luck of this run, such results
+// are analysed again on resume
+static bool isTransientError(AnalysisError error)
+{
+  return error == AnalysisError::Timeout
+    || error == AnalysisError::ResourceLimit
+    || error == AnalysisError::WorkerCrash;
+}
+
+static bool isTransientError(const BackwardAnalysisResult* bw)
+{
+  return bw != nullptr && bw->isErrored() && isTransientError(bw->getError());
+}
+
+bool ScheduledTask::operator<(const ScheduledTask& other) const
+{
+  // std::priority_queue puts the largest element on top
+  if (cost != other.cost) {
+    return cost < other.cost;
+  }
+  return order > other.order;
+}
+
+MultiAttackProgress::MultiAttackProgress()
+  : entries_with_duplicates(0)
+  , non_unique_entries(0)
+  , entries(0)
+  , fw_done(0)
+  , fw_errored(0)
+  , bw_done(0)
+  , non_zero_groups(0)
+  , sanitizers_for_payload(0)
+  , sanitizers_with_payload(0)
+  , vulnerable_sanitizers_with_payload(0)
+  , vulnerable_sanitizers_with_bypass(0)
+  , errored_sanitizers_with_payload(0)
+  , skipped_checks(0)
+  , restored(0)
+  , parse_pending(0)
+  , fw_pending(0)
+  , group_pending(0)
+  , bw_pending(0)
+{
+}
+
 MultiAttack::MultiAttack(const std::string& graph_directory, const std::string& output_dir, const std::string& input_field_name, int max, StrangerAutomaton* input_auto)
   : m_graph_directory(graph_directory)
   , m_output_directory(output_dir)
@@ -45,17 +103,51 @@ MultiAttack::MultiAttack(const std::string& graph_directory, const std::string&
   , m_dot_paths()
   , m_results()
   , m_result_hash_map()
+  , m_pending_metadata()
+  , m_skipped_parses(0)
   , m_automata()
   , m_groups()
   , m_analyzed_contexts()
+  , m_lattice_contexts()
   , results_mutex()
+  , m_group_queue(128)
+  , m_group_consumer()
+  , m_fw_finished(false)
+  , m_deferred_mutex()
+  , m_deferred_results()
+  , m_loading_done(false)
+  , m_schedule()
+  , m_schedule_mutex()
+  , m_schedule_order(0)
+  , m_cost_model()
+  , m_timings_file()
+  , m_budget()
+  , m_workers(0)
+  , m_worker_pool(nullptr)
+  , m_worker_mutex()
+  , m_result_workers()
+  , m_worker_results()
+  , m_worker_exports(0)
+  , m_journal()
+  , m_journal_mutex()
+  , m_group_post_images()
+  , m_result_post_images()
+  , m_restored_results()
+  , m_progress()
+  , m_status_reporter()
+  , m_status_mutex()
+  , m_status_cv()
+  , m_stop_reporter(false)
   , m_nThreads(boost::thread::hardware_concurrency())
   , m_max(max)
   , m_concats(0)
   , m_compute_preimage(true)
   , m_output_dotfiles(true)
   , m_attack_forward(false)
+  , m_free_dead_automata(false)
   , m_no_exploit_match(true)
+  , m_resume(false)
+  , m_cache(nullptr)
   , m_input_automaton(nullptr)
 {
   if (input_auto == nullptr) {
@@ -67,16 +159,49 @@ MultiAttack::MultiAttack(const std::string& graph_directory, const std::string&
 }
 
 MultiAttack::~MultiAttack() {
+  stopGroupConsumer();
+  stopStatusReporter();
 
   for (auto iter : m_results) {
     delete iter;
   }
   m_results.clear();
   m_result_hash_map.clear();
+  m_pending_metadata.clear();
   for (auto iter : m_automata) {
     delete iter;
   }
   m_automata.clear();
+  if (m_cache) {
+    delete m_cache;
+    m_cache = nullptr;
+  }
+  if (m_worker_pool) {
+    delete m_worker_pool;
+    m_worker_pool = nullptr;
+  }
+}
+
+void MultiAttack::setWorkers(unsigned int workers) {
+  m_workers = workers;
+  // Every worker needs a thread waiting for its reply
+  if (m_nThreads < workers) {
+    m_nThreads = workers;
+  }
+}
+
+void MultiAttack::setTimingsFile(const fs::path& file) {
+  m_timings_file = file;
+  if (m_cost_model.loadTimings(file)) {
+    std::cout << "Loaded " << m_cost_model.getRecordedTimings() << " timings from " << file.string() << std::endl;
+  }
+}
+
+void MultiAttack::setPostImageCache(const fs::path& dir, unsigned long max_mb) {
+  if (m_cache) {
+    delete m_cache;
+  }
+  m_cache = new PostImageCache(dir, max_mb * 1024 * 1024);
 }
 
 void MultiAttack::writeResultsToFile() const {
@@ -98,6 +223,12 @@ void MultiAttack::writeResultsToFile() const {
   m_groups.printOverlapSummary(ofs_sum, m_analyzed_contexts);
   ofs_sum.close();
 
+  fs::path output_perf(m_output_directory / fs::path("semattack_perf.csv"));
+  std::ofstream ofs_perf;
+  ofs_perf.open (output_perf.string(), std::ofstream::out);
+  PerfInfo::getAggregate().write_csv(ofs_perf);
+  ofs_perf.close();
+
   fs::path output_sum_pc(m_output_directory / fs::path("semattack_summary_percent.csv"));
   std::ofstream ofs_sum_pc;
   ofs_sum_pc.open (output_sum_pc.string(), std::ofstream::out);
@@ -169,39 +300,81 @@ void MultiAttack::printResults(std::ostream& os, bool printFiles) const
   m_groups.printGroups(os, printFiles, m_analyzed_contexts);
 }
 
-int MultiAttack::countDone() const
-{
-  int done = 0;
-  for (auto& result : m_results) {
-    if (result->isDone()) {
-      done++;
-    }
-  }
-  return done;
-}
-  
 void MultiAttack::printStatus(bool printGroups) const
 {
-  int done = countDone();
-  int total = m_results.size();
+  unsigned int done = m_progress.bw_done;
+  unsigned int total = m_progress.entries;
   double percent = total > 0 ? ((double) done / (double) total) * 100.0 : 0.0;
   std::cout << "Status: completed " << done << "/" << total << "(" << percent << "%)" << std::endl;
   if (printGroups) {
     m_groups.printStatus(std::cout);
+    AttackPatternRegistry::getInstance().printStatus(std::cout);
   }
 }
 
-void MultiAttack::computeAttackPatternOverlap(CombinedAnalysisResult* result, AttackContext context)
+/**
+ * Prints the status from the progress counters only, this is safe to call
+ * while the analysis is running.
+ */
+void MultiAttack::printProgress(std::ostream& os) const
+{
+  unsigned int total = m_progress.entries;
+  unsigned int fw_done = m_progress.fw_done;
+  unsigned int bw_done = m_progress.bw_done;
+  double percent = total > 0 ? ((double) bw_done / (double) total) * 100.0 : 0.0;
+  os << "Status: forward analysis " << fw_done << "/" << total
+     << ", completed " << bw_done << "/" << total << "(" << percent << "%)" << std::endl;
+  os << "# DepGraph files --> Duplicates removed --> Unique Hash (errors) --> Unique Post-images" << std::endl;
+  os << "# " << m_progress.entries_with_duplicates
+     << " --> " << m_progress.non_unique_entries
+     << " --> " << total
+     << " (" << m_progress.fw_errored << ")"
+     << " --> " << m_progress.non_zero_groups << std::endl;
+  os << "# Sanitizers --> Sanitizers with payload -> Vulnerable sanitizers -> Sanitizers with bypass (errored)" << std::endl;
+  os << "# " << m_progress.sanitizers_for_payload
+     << " --> " << m_progress.sanitizers_with_payload
+     << " --> " << m_progress.vulnerable_sanitizers_with_payload
+     << " --> " << m_progress.vulnerable_sanitizers_with_bypass
+     << " (" << m_progress.errored_sanitizers_with_payload << ")" << std::endl;
+  os << "# Attack pattern checks skipped by inclusion: " << m_progress.skipped_checks << std::endl;
+  os << "# Tasks cancelled over budget: " << AnalysisBudget::getExceeded() << std::endl;
+  os << "# Results restored from journal: " << m_progress.restored << std::endl;
+  if (m_worker_pool) {
+    os << "# Worker processes --> crashed" << std::endl;
+    os << "# " << m_worker_pool->getSize() << " --> " << m_worker_pool->getCrashes() << std::endl;
+  }
+  os << "# Pending parse --> forward --> grouping --> backward" << std::endl;
+  os << "# " << m_progress.parse_pending
+     << " --> " << m_progress.fw_pending
+     << " --> " << m_progress.group_pending
+     << " --> " << m_progress.bw_pending << std::endl;
+  AttackPatternRegistry::getInstance().printStatus(os);
+  if (m_cache) {
+    m_cache->printStatus(os);
+  }
+}
+
+/**
+ * If disjoint is set, the pattern is contained in one that does not
+ * intersect the post-image and the intersection is skipped.
+ */
+BackwardAnalysisResult* MultiAttack::computeAttackPatternOverlap(CombinedAnalysisResult* result, AttackContext context,
+                                                                 bool disjoint)
 {
   const std::string& file = result->getAttack()->getFileName();
   // std::cout << "Doing backward analysis for file: "
   //           << file
   //           << ", context: " << AttackContextHelper::getName(context)
   //           << std::endl;
+  BackwardAnalysisResult* bw = nullptr;
   try {
     fs::path dir(m_output_directory / result->getAttack()->getFile());
-    BackwardAnalysisResult* bw = result->addBackwardAnalysis(context);
-    bw->doAnalysis(m_compute_preimage, m_singleton_intersection, m_attack_forward);
+    bw = result->addBackwardAnalysis(context);
+    std::shared_ptr<AttackVerdict> verdict = result->getVerdict(bw->getName());
+    if (disjoint && verdict->setDisjoint()) {
+      m_progress.skipped_checks++;
+    }
+    bw->doAnalysis(m_compute_preimage, m_singleton_intersection, m_attack_forward, verdict.get());
     if (m_output_dotfiles) {
       bw->writeResultsToFile(dir);
     }
@@ -209,6 +382,7 @@ void MultiAttack::computeAttackPatternOverlap(CombinedAnalysisResult* result, At
   } catch (...) {
     std::cout << "EXCEPTION! In BW analysis file: " << file << " for context: " << AttackContextHelper::getName(context) << std::endl;
   }
+  return bw;
 }
 
 void MultiAttack::computeAttackPatternOverlapForMetadata(CombinedAnalysisResult* result)
@@ -221,7 +395,428 @@ void MultiAttack::computeAttackPatternOverlapForMetadata(CombinedAnalysisResult*
   result->doMetadataSpecificAnalysis(dir, true, m_singleton_intersection, m_output_dotfiles, m_attack_forward);
 }
 
-CombinedAnalysisResult* MultiAttack::findOrCreateResult(const fs::path& file, DepGraph& target_dep_graph, boost::asio::thread_pool &pool) {
+/**
+ * Runs the forward analysis of a result in a worker process, which keeps
+ * it for the backward analysis, and fills in the result from the reply. If
+ * the worker dies on the way the result is recorded as errored.
+ */
+const StrangerAutomaton* MultiAttack::analyseInWorker(CombinedAnalysisResult* result)
+{
+  const std::string file = result->getFileName();
+  std::stringstream request;
+  FieldCodec::writeString(request, "analyse");
+  FieldCodec::writeString(request, file);
+  std::string reply;
+  int worker = -1;
+  if (!m_worker_pool->call(request.str(), reply, -1, worker)) {
+    std::cout << "EXCEPTION! Worker crashed in analysis of: " << file << std::endl;
+    result->getFwAnalysis().setWorkerResult(nullptr, AnalysisError::WorkerCrash);
+    for (auto c : m_lattice_contexts) {
+      result->addBackwardAnalysis(c, new BackwardAnalysisResult(result->getFwAnalysis(),
+                                                                AttackContextHelper::getName(c),
+                                                                AnalysisError::WorkerCrash));
+    }
+    return nullptr;
+  }
+  {
+    const std::lock_guard<std::mutex> lock(m_worker_mutex);
+    m_result_workers[result] = worker;
+  }
+
+  std::istringstream is(reply);
+  AnalysisError error = static_cast<AnalysisError>(FieldCodec::readInt(is));
+  std::string post_image_file = FieldCodec::readString(is);
+  StrangerAutomaton* postImage = nullptr;
+  if (!post_image_file.empty()) {
+    postImage = StrangerAutomaton::importFromFile(post_image_file);
+    boost::system::error_code ec;
+    fs::remove(post_image_file, ec);
+    if (postImage != nullptr && postImage->isNull()) {
+      delete postImage;
+      postImage = nullptr;
+      error = AnalysisError::MonaException;
+    }
+  }
+  result->getFwAnalysis().setWorkerResult(postImage, error);
+  return postImage;
+}
+
+/**
+ * Runs the backward analysis in the worker which did the forward one, once
+ * the result has joined its group. The verdicts the group already has are
+ * sent along and those the worker computes come back, so the members of a
+ * group share them as in the threaded mode.
+ */
+void MultiAttack::analyseBackwardInWorker(CombinedAnalysisResult* result)
+{
+  const std::string file = result->getFileName();
+  // Contexts restored from the journal or lost with a crashed worker are done
+  std::vector<AttackContext> contexts;
+  std::vector<std::string> patterns;
+  for (auto c : m_lattice_contexts) {
+    if (result->getBackwardAnalysis(c) == nullptr) {
+      contexts.push_back(c);
+      patterns.push_back(AttackContextHelper::getName(c));
+    }
+  }
+  int preferred = getResultWorker(result, !m_payload_analysis);
+  if (contexts.empty()) {
+    if (!m_payload_analysis) {
+      releaseInWorker(preferred, file);
+    }
+    return;
+  }
+
+  std::stringstream request;
+  FieldCodec::writeString(request, "backward");
+  FieldCodec::writeString(request, file);
+  FieldCodec::writeInt(request, contexts.size());
+  for (auto c : contexts) {
+    FieldCodec::writeInt(request, static_cast<int>(c));
+  }
+  std::vector<std::string> files;
+  writeVerdicts(request, result, patterns, files);
+  std::string reply;
+  int worker = -1;
+  bool replied = m_worker_pool->call(request.str(), reply, preferred, worker);
+  removeExportFiles(files);
+  if (worker != preferred) {
+    releaseInWorker(preferred, file);
+    if (replied && m_payload_analysis) {
+      // The worker which took the request keeps the analysis now
+      const std::lock_guard<std::mutex> lock(m_worker_mutex);
+      m_result_workers[result] = worker;
+    }
+  }
+  if (!replied) {
+    std::cout << "EXCEPTION! Worker crashed in backward analysis of: " << file << std::endl;
+    for (auto c : contexts) {
+      result->addBackwardAnalysis(c, new BackwardAnalysisResult(result->getFwAnalysis(),
+                                                                AttackContextHelper::getName(c),
+                                                                AnalysisError::WorkerCrash));
+    }
+    return;
+  }
+
+  std::istringstream is(reply);
+  m_progress.skipped_checks += FieldCodec::readInt(is);
+  for (auto c : contexts) {
+    if (FieldCodec::readInt(is) != 0) {
+      result->addBackwardAnalysis(c, BackwardAnalysisResult::readSummary(result->getFwAnalysis(), is));
+    }
+  }
+  readVerdicts(is, result, patterns);
+}
+
+/**
+ * Analyses the payloads of a result in the worker which did its forward
+ * analysis, so it is not computed again. The results are added to the
+ * result, computeAttackPatternOverlapForMetadata then finds all of them.
+ */
+void MultiAttack::analysePayloadsInWorker(CombinedAnalysisResult* result)
+{
+  const std::string file = result->getFileName();
+  // Payloads restored from the journal are not analysed again
+  std::vector<std::string> payloads;
+  for (auto& payload : result->getPayloads()) {
+    if (!result->hasPayloadAnalysis(payload)) {
+      payloads.push_back(payload);
+    }
+  }
+  int preferred = getResultWorker(result, true);
+
+  if (payloads.empty()) {
+    releaseInWorker(preferred, file);
+    return;
+  }
+
+  // Do not crash another worker with the same graph
+  bool crashed = result->getFwAnalysis().getError() == AnalysisError::WorkerCrash;
+  for (auto c : m_lattice_contexts) {
+    const BackwardAnalysisResult* bw = result->getBackwardAnalysis(c);
+    crashed |= (bw != nullptr && bw->getError() == AnalysisError::WorkerCrash);
+  }
+
+  bool replied = false;
+  std::string reply;
+  if (!crashed) {
+    std::stringstream request;
+    FieldCodec::writeString(request, "payload");
+    FieldCodec::writeString(request, file);
+    FieldCodec::writeInt(request, payloads.size());
+    for (auto& payload : payloads) {
+      FieldCodec::writeString(request, payload);
+    }
+    std::vector<std::string> files;
+    writeVerdicts(request, result, payloads, files);
+    int worker = -1;
+    replied = m_worker_pool->call(request.str(), reply, preferred, worker);
+    removeExportFiles(files);
+    if (!replied) {
+      std::cout << "EXCEPTION! Worker crashed in payload analysis of: " << file << std::endl;
+    }
+    if (worker != preferred) {
+      releaseInWorker(preferred, file);
+    }
+  } else {
+    releaseInWorker(preferred, file);
+  }
+
+  std::istringstream is(reply);
+  long n = replied ? FieldCodec::readInt(is) : 0;
+  for (long i = 0; i < (long) payloads.size(); i++) {
+    BackwardAnalysisResult* bw = nullptr;
+    if (!replied) {
+      bw = new BackwardAnalysisResult(result->getFwAnalysis(), payloads[i], AnalysisError::WorkerCrash);
+    } else if (i < n && FieldCodec::readInt(is) != 0) {
+      bw = BackwardAnalysisResult::readSummary(result->getFwAnalysis(), is);
+    }
+    result->addPayloadAnalysis(payloads[i], bw);
+  }
+  if (replied && n == (long) payloads.size()) {
+    readVerdicts(is, result, payloads);
+  }
+}
+
+/**
+ * Drops the analysis a worker keeps for a result, when no further request
+ * for it reaches that worker.
+ */
+void MultiAttack::releaseInWorker(int worker, const std::string& file)
+{
+  if (worker < 0) {
+    return;
+  }
+  std::stringstream request;
+  FieldCodec::writeString(request, "release");
+  FieldCodec::writeString(request, file);
+  std::string reply;
+  m_worker_pool->call(request.str(), reply, worker, worker);
+}
+
+// The worker keeping the analysis of a result, or -1
+int MultiAttack::getResultWorker(CombinedAnalysisResult* result, bool release)
+{
+  const std::lock_guard<std::mutex> lock(m_worker_mutex);
+  auto search = m_result_workers.find(result);
+  if (search == m_result_workers.end()) {
+    return -1;
+  }
+  int worker = search->second;
+  if (release) {
+    m_result_workers.erase(search);
+  }
+  return worker;
+}
+
+/**
+ * Both processes see the same temporary directory, names carry the pid so
+ * the parent and its workers never pick the same one.
+ */
+std::string MultiAttack::getExportFile()
+{
+  std::stringstream name;
+  name << "multiattack_" << getpid() << "_" << m_worker_exports++ << ".bdd";
+  return (fs::temp_directory_path() / fs::path(name.str())).string();
+}
+
+void MultiAttack::removeExportFiles(const std::vector<std::string>& files)
+{
+  for (auto& file : files) {
+    boost::system::error_code ec;
+    fs::remove(file, ec);
+  }
+}
+
+void MultiAttack::writeVerdicts(std::ostream& os, CombinedAnalysisResult* result,
+                                const std::vector<std::string>& patterns, std::vector<std::string>& files)
+{
+  for (auto& pattern : patterns) {
+    std::string file = getExportFile();
+    if (result->getVerdict(pattern)->writeSummary(os, file)) {
+      files.push_back(file);
+    }
+  }
+}
+
+// Takes the verdicts computed by a worker into the group of the result
+void MultiAttack::readVerdicts(std::istream& is, CombinedAnalysisResult* result,
+                               const std::vector<std::string>& patterns)
+{
+  std::vector<std::string> files;
+  for (auto& pattern : patterns) {
+    std::string file = result->getVerdict(pattern)->readSummary(is);
+    if (!file.empty()) {
+      files.push_back(file);
+    }
+  }
+  removeExportFiles(files);
+}
+
+/**
+ * In a worker, takes the verdicts the parent sent along and returns which
+ * of them were known, only the others are sent back.
+ */
+std::vector<bool> MultiAttack::takeVerdicts(std::istream& is, CombinedAnalysisResult* result,
+                                            const std::vector<std::string>& patterns)
+{
+  std::vector<bool> known;
+  for (auto& pattern : patterns) {
+    std::shared_ptr<AttackVerdict> verdict = result->getVerdict(pattern);
+    verdict->readSummary(is);
+    known.push_back(verdict->isComputed());
+  }
+  return known;
+}
+
+void MultiAttack::giveVerdicts(std::ostream& os, CombinedAnalysisResult* result,
+                               const std::vector<std::string>& patterns, const std::vector<bool>& known)
+{
+  for (size_t i = 0; i < patterns.size(); i++) {
+    if (known[i]) {
+      FieldCodec::writeInt(os, 0);
+    } else {
+      result->getVerdict(patterns[i])->writeSummary(os, getExportFile());
+    }
+  }
+}
+
+/**
+ * Runs in a worker process, which has its own copy of this object as it was
+ * when the pool was started. Requests name the dot file, the worker parses
+ * it itself as the graphs of the parent are not shared, and keeps the
+ * analysis until its last request.
+ */
+std::string MultiAttack::handleWorkerRequest(const std::string& request)
+{
+  std::istringstream is(request);
+  std::string kind = FieldCodec::readString(is);
+  fs::path file(FieldCodec::readString(is));
+  std::stringstream reply;
+
+  if (kind == "analyse") {
+    CombinedAnalysisResult* result = createWorkerResult(file);
+    if (result == nullptr) {
+      FieldCodec::writeInt(reply, static_cast<int>(AnalysisError::MalformedDepgraph));
+      FieldCodec::writeString(reply, "");
+      return reply.str();
+    }
+    const StrangerAutomaton* postImage = computeFwAnalysis(result);
+    std::string post_image_file;
+    if (postImage != nullptr) {
+      post_image_file = getExportFile();
+      postImage->exportToFile(post_image_file);
+    }
+    FieldCodec::writeInt(reply, static_cast<int>(result->getFwAnalysis().getError()));
+    FieldCodec::writeString(reply, post_image_file);
+    m_worker_results[file.string()] = result;
+  } else if (kind == "backward") {
+    std::vector<AttackContext> contexts(FieldCodec::readInt(is));
+    std::vector<std::string> patterns;
+    for (auto& c : contexts) {
+      c = static_cast<AttackContext>(FieldCodec::readInt(is));
+      patterns.push_back(AttackContextHelper::getName(c));
+    }
+    CombinedAnalysisResult* result = getWorkerResult(file);
+    if (result == nullptr) {
+      FieldCodec::writeInt(reply, 0);
+      for (size_t i = 0; i < 2 * contexts.size(); i++) {
+        FieldCodec::writeInt(reply, 0);
+      }
+      return reply.str();
+    }
+    std::vector<bool> known = takeVerdicts(is, result, patterns);
+    unsigned int skipped = m_progress.skipped_checks;
+    computeAttackPatternOverlaps(result);
+    FieldCodec::writeInt(reply, m_progress.skipped_checks - skipped);
+    for (auto c : contexts) {
+      const BackwardAnalysisResult* bw = result->getBackwardAnalysis(c);
+      FieldCodec::writeInt(reply, bw != nullptr);
+      if (bw != nullptr) {
+        bw->writeSummary(reply);
+      }
+    }
+    giveVerdicts(reply, result, patterns, known);
+    if (!m_payload_analysis) {
+      m_worker_results.erase(file.string());
+      result->finishAnalysis();
+      delete result;
+    }
+  } else if (kind == "payload") {
+    std::vector<std::string> payloads(FieldCodec::readInt(is));
+    for (auto& payload : payloads) {
+      payload = FieldCodec::readString(is);
+    }
+    CombinedAnalysisResult* result = getWorkerResult(file);
+    m_worker_results.erase(file.string());
+    FieldCodec::writeInt(reply, (result != nullptr) ? payloads.size() : 0);
+    if (result != nullptr) {
+      std::vector<bool> known = takeVerdicts(is, result, payloads);
+      {
+        AnalysisBudget::Scope budget(m_budget);
+        fs::path dir(m_output_directory / file);
+        for (auto& payload : payloads) {
+          const BackwardAnalysisResult* bw = result->doBackwardAnalysisForPayload(
+            payload, dir, true, m_singleton_intersection, m_output_dotfiles, m_attack_forward);
+          FieldCodec::writeInt(reply, bw != nullptr);
+          if (bw != nullptr) {
+            bw->writeSummary(reply);
+          }
+        }
+      }
+      giveVerdicts(reply, result, payloads, known);
+      result->finishAnalysis();
+      delete result;
+    }
+  } else if (kind == "release") {
+    auto search = m_worker_results.find(file.string());
+    if (search != m_worker_results.end()) {
+      search->second->finishAnalysis();
+      delete search->second;
+      m_worker_results.erase(search);
+    }
+  }
+  return reply.str();
+}
+
+/**
+ * In a worker, the result kept from an earlier request, or a new one if
+ * this worker replaced the one which did the forward analysis.
+ */
+CombinedAnalysisResult* MultiAttack::getWorkerResult(const fs::path& file)
+{
+  auto search = m_worker_results.find(file.string());
+  if (search != m_worker_results.end()) {
+    return search->second;
+  }
+  CombinedAnalysisResult* result = createWorkerResult(file);
+  if (result != nullptr) {
+    computeFwAnalysis(result);
+    m_worker_results[file.string()] = result;
+  }
+  return result;
+}
+
+CombinedAnalysisResult* MultiAttack::createWorkerResult(const fs::path& file)
+{
+  try {
+    DepGraph target_dep_graph = DepGraph::parseDotFile(file.string());
+    CombinedAnalysisResult* result = new CombinedAnalysisResult(file, target_dep_graph, m_input_name, m_input_automaton);
+    // Holds the verdicts sent by the parent for this result
+    result->setGroupVerdicts(std::make_shared<GroupVerdicts>());
+    return result;
+  } catch(std::exception& e) {
+    cerr << "Error parsing " << file.string() << " in worker: " << e.what() << "\n";
+  }
+  return nullptr;
+}
+
+/**
+ * Registers the result of a parsed graph, unless it is a duplicate. Its
+ * forward analysis is posted unless it is restoring from the journal.
+ */
+CombinedAnalysisResult* MultiAttack::findOrCreateResult(const fs::path& file, DepGraph& target_dep_graph, boost::asio::thread_pool &pool,
+                                                        bool restoring) {
   // Find the result for the given hash
   const std::lock_guard<std::mutex> lock(this->results_mutex);
   CombinedAnalysisResult* result = nullptr;
@@ -230,16 +825,15 @@ CombinedAnalysisResult* MultiAttack::findOrCreateResult(const fs::path& file, De
     auto search = this->m_result_hash_map.find(hash);
     if(target_dep_graph.get_metadata().is_initialized() && // Legacy failsafe to support depgraphs without the hash field
        search != this->m_result_hash_map.end()) {
-      if (search->second->addMetadata(target_dep_graph.get_metadata())) {
-        // std::cout << "Incremeted count to " << search->second->getCount() << " for " << search->second->getFileName() << std::endl;
-      } else {
-        // This is a bit too verbose
-        //std::cout << "Discarding duplicate depgraph: " << file.string() << " (total: " << search->second->getCountWithDuplicates() << ")" << std::endl;
-      }
+      mergeMetadata(search->second, target_dep_graph.get_metadata());
     } else {
       result = new CombinedAnalysisResult(file, target_dep_graph, m_input_name, m_input_automaton);
-      // Start the forward analysis
-      asio::post(pool, std::bind(&MultiAttack::doFwAnalysis, this, result));
+      m_progress.entries++;
+      m_progress.non_unique_entries++;
+      m_progress.entries_with_duplicates++;
+      if (!restoring) {
+        postFwAnalysis(result, pool);
+      }
       this->m_results.push_back(result);
       if (((m_results.size() % 1000) == 0)) {
         std::cout << "Added " << m_results.size() << " sanitizers to worker queue." << std::endl;
@@ -247,17 +841,252 @@ CombinedAnalysisResult* MultiAttack::findOrCreateResult(const fs::path& file, De
       // Only insert into hash map if metadata is initialized
       if (target_dep_graph.get_metadata().is_initialized()) {
         this->m_result_hash_map.insert(std::make_pair(hash, result));
+        // Merge the duplicates which were found while this graph was parsed
+        auto pending = this->m_pending_metadata.find(hash);
+        if (pending != this->m_pending_metadata.end()) {
+          for (auto& duplicate : pending->second) {
+            mergeMetadata(result, duplicate.second);
+          }
+          this->m_pending_metadata.erase(pending);
+        }
       }
     }
   }
   return result;
 }
 
+void MultiAttack::postFwAnalysis(CombinedAnalysisResult* result, boost::asio::thread_pool &pool) {
+  const fs::path file = result->getInputPath();
+  m_progress.fw_pending++;
+  postByCost(pool, m_cost_model.getEstimate(file), [this, result, file]() {
+    auto start = std::chrono::steady_clock::now();
+    this->doFwAnalysis(result);
+    m_cost_model.addTime(file, secondsSince(start));
+    m_progress.fw_pending--;
+  });
+}
+
+/**
+ * Fills in a result from the journal of an earlier run and hands it to the
+ * group consumer without a forward analysis. Returns false if the entry does
+ * not match the graph or its post-image, the result is then analysed as
+ * usual.
+ */
+bool MultiAttack::restoreResult(CombinedAnalysisResult* result, const JournalEntry& entry) {
+  const std::string file = result->getFileName();
+  const Metadata& metadata = result->getMetadata();
+  if (metadata.is_initialized() != entry.has_sanitizer_hash ||
+      (entry.has_sanitizer_hash && metadata.get_sanitizer_hash() != entry.sanitizer_hash)) {
+    std::cout << "Journal entry does not match " << file << ", analysing it again" << std::endl;
+    return false;
+  }
+  if (isTransientError(entry.error)) {
+    // Written before such results were left out of the journal
+    return false;
+  }
+  StrangerAutomaton* postImage = nullptr;
+  if (!entry.post_image.empty()) {
+    postImage = m_journal.importPostImage(entry.post_image, entry.fingerprint);
+    if (postImage == nullptr) {
+      std::cout << "Journaled post image of " << file << " is missing, analysing it again" << std::endl;
+      return false;
+    }
+    // New payloads of duplicates may still need the forward analysis
+    result->getAttack()->setPrint(false);
+    result->getAttack()->setFreeDeadAutomata(m_free_dead_automata, m_compute_preimage || m_payload_analysis);
+    try {
+      result->getAttack()->init();
+    } catch (std::exception const &e) {
+      std::cout << "EXCEPTION! Restoring " << file << " from journal: " << e.what() << std::endl;
+      delete postImage;
+      return false;
+    }
+  }
+  result->getFwAnalysis().setRestoredResult(postImage, entry.error, m_concats);
+  for (auto& context : entry.contexts) {
+    std::istringstream is(context.second);
+    result->addBackwardAnalysis(static_cast<AttackContext>(context.first),
+                                BackwardAnalysisResult::readSummary(result->getFwAnalysis(), is));
+  }
+  for (auto& payload : entry.payloads) {
+    BackwardAnalysisResult* bw = nullptr;
+    if (!payload.second.empty()) {
+      std::istringstream is(payload.second);
+      bw = BackwardAnalysisResult::readSummary(result->getFwAnalysis(), is);
+    }
+    result->addPayloadAnalysis(payload.first, bw);
+  }
+  {
+    const std::lock_guard<std::mutex> lock(m_journal_mutex);
+    m_restored_results.insert(result);
+  }
+  m_progress.restored++;
+  std::cout << "Restored analysis of " << file << " from journal" << std::endl;
+
+  GroupInsertion insertion = { (postImage != nullptr) ? postImage->deepClone() : nullptr, result };
+  m_progress.group_pending++;
+  m_group_queue.push(insertion);
+  return true;
+}
+
+/**
+ * Adds the metadata of a duplicate depgraph to an existing result, the
+ * caller must hold results_mutex.
+ */
+void MultiAttack::mergeMetadata(CombinedAnalysisResult* result, const Metadata& metadata) {
+  if (result->addMetadata(metadata)) {
+    m_progress.non_unique_entries++;
+  }
+  m_progress.entries_with_duplicates++;
+}
+
+/**
+ * Decides from the metadata header of a dot file whether the whole graph
+ * needs to be parsed. Only the first file with a given sanitizer hash is
+ * parsed, the metadata of every other one is merged into its result, either
+ * directly or once the first graph has been parsed.
+ */
+bool MultiAttack::claimSanitizerHash(const fs::path& file, const Metadata& metadata) {
+  const std::lock_guard<std::mutex> lock(this->results_mutex);
+  if (!metadata.has_correct_exploit_match() && !this->m_no_exploit_match) {
+    // findOrCreateResult would discard this graph anyway
+    m_skipped_parses++;
+    return false;
+  }
+  if (!metadata.is_initialized()) {
+    // Legacy depgraphs without metadata are always parsed
+    return true;
+  }
+  int hash = metadata.get_sanitizer_hash();
+  auto search = this->m_result_hash_map.find(hash);
+  if (search != this->m_result_hash_map.end()) {
+    mergeMetadata(search->second, metadata);
+    m_skipped_parses++;
+    return false;
+  }
+  auto pending = this->m_pending_metadata.find(hash);
+  if (pending != this->m_pending_metadata.end()) {
+    pending->second.emplace_back(file, metadata);
+    m_skipped_parses++;
+    return false;
+  }
+  // First occurrence, duplicates are queued until the graph is parsed
+  this->m_pending_metadata.emplace(hash, std::vector<std::pair<fs::path, Metadata> >());
+  return true;
+}
+
+/**
+ * Called once the graph claiming a sanitizer hash has been handled. If it did
+ * not produce a result for that hash, the queued duplicates are loaded again
+ * so one of them is parsed instead.
+ */
+void MultiAttack::releaseSanitizerHash(const Metadata& metadata, boost::asio::thread_pool &pool) {
+  std::vector<std::pair<fs::path, Metadata> > duplicates;
+  {
+    const std::lock_guard<std::mutex> lock(this->results_mutex);
+    if (!metadata.is_initialized()) {
+      return;
+    }
+    auto pending = this->m_pending_metadata.find(metadata.get_sanitizer_hash());
+    if (pending == this->m_pending_metadata.end()) {
+      return;
+    }
+    duplicates.swap(pending->second);
+    this->m_pending_metadata.erase(pending);
+    m_skipped_parses -= duplicates.size();
+  }
+  for (auto& duplicate : duplicates) {
+    postLoadDepGraph(duplicate.first, pool);
+  }
+}
+
+void MultiAttack::postLoadDepGraph(const fs::path& file, boost::asio::thread_pool &pool) {
+  m_progress.parse_pending++;
+  // Journaled graphs go first, so they claim their sanitizer hash before a
+  // duplicate which would have to be analysed again
+  double cost = (m_journal.find(file) != nullptr) ?
+    std::numeric_limits<double>::max() : m_cost_model.estimateBeforeParse(file);
+  postByCost(pool, cost, [this, &pool, file]() {
+    this->loadDepGraph(file, pool);
+    m_progress.parse_pending--;
+  });
+}
+
+/**
+ * Every posted trampoline runs the most expensive task queued at that
+ * time, so expensive sanitizers start early instead of dominating the end
+ * of the run. Tasks with the same cost run in the order they were posted.
+ */
+void MultiAttack::postByCost(boost::asio::thread_pool &pool, double cost, std::function<void()> task) {
+  {
+    const std::lock_guard<std::mutex> lock(m_schedule_mutex);
+    m_schedule.push(ScheduledTask{ cost, m_schedule_order++, std::move(task) });
+  }
+  asio::post(pool, [this]() { this->runNextTask(); });
+}
+
+void MultiAttack::runNextTask() {
+  std::function<void()> task;
+  {
+    const std::lock_guard<std::mutex> lock(m_schedule_mutex);
+    if (m_schedule.empty()) {
+      return;
+    }
+    task = m_schedule.top().run;
+    m_schedule.pop();
+  }
+  task();
+}
+
+void MultiAttack::loadDepGraph(const fs::path& file, boost::asio::thread_pool &pool) {
+  Metadata metadata;
+  try {
+    metadata = DepGraph::parseDotFileMetadata(file.string());
+  } catch(std::exception& e) {
+    cerr << "Error parsing " << file.string() << ": " << e.what() << "\n";
+    return;
+  }
+  if (!this->claimSanitizerHash(file, metadata)) {
+    return;
+  }
+  try {
+    DepGraph target_dep_graph = DepGraph::parseDotFile(file.string());
+    m_cost_model.estimate(file, CostModel::getFeatures(target_dep_graph));
+    const JournalEntry* entry = m_journal.find(file);
+    CombinedAnalysisResult* result = this->findOrCreateResult(file, target_dep_graph, pool, entry != nullptr);
+    if (result != nullptr && entry != nullptr && !restoreResult(result, *entry)) {
+      postFwAnalysis(result, pool);
+    }
+  } catch(std::exception& e) {
+    cerr << "Error parsing " << file.string() << ": " << e.what() << "\n";
+  }
+  this->releaseSanitizerHash(metadata, pool);
+}
+
 void MultiAttack::doFwAnalysis(CombinedAnalysisResult* result) {
   if (result == nullptr) {
     return;
   }
 
+  const StrangerAutomaton* postImage = nullptr;
+  if (m_worker_pool) {
+    postImage = analyseInWorker(result);
+  } else {
+    postImage = computeFwAnalysis(result);
+  }
+
+  std::cout << "Finished analysis of " << result->getFileName() << std::endl;
+  // Hand over to the group consumer, the queue grows if it is full
+  GroupInsertion entry = { (postImage != nullptr) ? postImage->deepClone() : nullptr, result };
+  m_progress.group_pending++;
+  m_group_queue.push(entry);
+}
+
+/**
+ * Runs the forward analysis in this process and returns the post-image of
+ * the result, or nullptr if it failed.
+ */
+const StrangerAutomaton* MultiAttack::computeFwAnalysis(CombinedAnalysisResult* result) {
   bool errored = false;
   const StrangerAutomaton* postImage = NULL;
   const std::string file = result->getFileName();
@@ -266,12 +1095,25 @@ void MultiAttack::doFwAnalysis(CombinedAnalysisResult* result) {
 
   // Reduce debug prints
   result->getAttack()->setPrint(false);
+  // Preimages read the forward automata along the input path
+  result->getAttack()->setFreeDeadAutomata(m_free_dead_automata, m_compute_preimage || m_payload_analysis);
 
   try {
+    AnalysisBudget::Scope budget(m_budget);
     // Forward Analysis
     result->getAttack()->init();
-    result->getFwAnalysis().doAnalysis(m_concats);
+    result->getFwAnalysis().doAnalysis(m_concats, m_cache);
     postImage = result->getFwAnalysis().getPostImage();
+    if (result->getFwAnalysis().isFromCache()) {
+      std::cout << "Loaded post image for " << file << " from cache" << std::endl;
+    } else {
+      // Built first so the lines of parallel analyses do not interleave
+      std::stringstream memory;
+      memory << "Forward analysis memory for " << file << ": ";
+      result->getFwAnalysis().getFwAnalysisResult().printMemoryStats(memory);
+      memory << "\n";
+      std::cout << memory.str() << std::flush;
+    }
     if (m_output_dotfiles) {
       result->getAttack()->writeResultsToFile(dir);
       result->getFwAnalysis().writeResultsToFile(dir);
@@ -292,86 +1134,397 @@ void MultiAttack::doFwAnalysis(CombinedAnalysisResult* result) {
       postImage = nullptr;
     }
   }
+  return postImage;
+}
 
-  // Mutex Lock
-  std::cout << "Finished analysis of " << file << std::endl;
-  const std::lock_guard<std::mutex> lock(this->results_mutex);
-  std::cout << "Inserting results into groups for " << file << std::endl;
-  this->m_groups.addAutomaton(postImage, result);
-  std::cout << "Finished inserting results into groups for " << file << std::endl;
-  printStatus();
+void MultiAttack::startGroupConsumer(boost::asio::thread_pool &pool) {
+  m_fw_finished = false;
+  m_group_consumer = std::thread(&MultiAttack::consumeGroupInsertions, this, std::ref(pool));
+}
+
+/**
+ * Returns once every forward analysis has finished and its result has been
+ * inserted, all backward analyses have been posted at that point.
+ */
+void MultiAttack::waitForGroupConsumer() {
+  if (m_group_consumer.joinable()) {
+    m_group_consumer.join();
+  }
+}
+
+/**
+ * Stops the consumer without waiting for pending forward analyses, the
+ * entries already in the queue are inserted before returning.
+ */
+void MultiAttack::stopGroupConsumer() {
+  if (m_group_consumer.joinable()) {
+    m_fw_finished = true;
+    m_group_consumer.join();
+  }
+}
+
+void MultiAttack::consumeGroupInsertions(boost::asio::thread_pool &pool) {
+  GroupInsertion entry;
+  bool finished = false;
+  bool loading_done = false;
+  while (!finished) {
+    // Read the counters before draining, so entries pushed before they
+    // dropped to zero are never left behind. A parse posts its forward
+    // analysis before it is finished, so both are zero only at the end.
+    if (!loading_done && m_progress.parse_pending == 0) {
+      loading_done = true;
+    }
+    finished = m_fw_finished || (loading_done && m_progress.fw_pending == 0);
+    bool empty = true;
+    while (m_group_queue.pop(entry)) {
+      empty = false;
+      m_progress.group_pending--;
+      AutomatonGroup* group = this->m_groups.addAutomaton(entry.postImage, entry.result);
+      if (entry.postImage != nullptr) {
+        recordPostImage(group, entry);
+      }
+      if (group->getAutomaton() == entry.postImage) {
+        // New group, keep the copy for comparisons
+        if (entry.postImage != nullptr) {
+          m_automata.push_back(entry.postImage);
+        }
+      } else {
+        delete entry.postImage;
+      }
+      // Members of a group have equivalent post-images, so they can share
+      // the attack pattern verdicts in the backward analysis
+      entry.result->setGroupVerdicts(group->getVerdicts());
+      if (group->getEntries() == 1) {
+        m_progress.non_zero_groups++;
+      }
+      if (entry.result->getFwAnalysis().isErrored()) {
+        m_progress.fw_errored++;
+      }
+      m_progress.fw_done++;
+      // The backward analysis can start right away
+      CombinedAnalysisResult* result = entry.result;
+      m_progress.bw_pending++;
+      postByCost(pool, m_cost_model.getEstimate(result->getInputPath()), [this, result]() {
+        auto start = std::chrono::steady_clock::now();
+        this->doBwAnalysis(result);
+        m_cost_model.addTime(result->getInputPath(), secondsSince(start));
+        m_progress.bw_pending--;
+      });
+    }
+    if (loading_done) {
+      releaseDeferredResults(pool);
+    }
+    if (empty && !finished) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+void MultiAttack::startStatusReporter() {
+  {
+    const std::lock_guard<std::mutex> lock(m_status_mutex);
+    m_stop_reporter = false;
+  }
+  m_status_reporter = std::thread(&MultiAttack::reportStatus, this);
+}
+
+void MultiAttack::stopStatusReporter() {
+  if (m_status_reporter.joinable()) {
+    {
+      const std::lock_guard<std::mutex> lock(m_status_mutex);
+      m_stop_reporter = true;
+    }
+    m_status_cv.notify_all();
+    m_status_reporter.join();
+  }
+}
+
+void MultiAttack::reportStatus() {
+  std::unique_lock<std::mutex> lock(m_status_mutex);
+  while (!m_status_cv.wait_for(lock, std::chrono::seconds(m_status_interval_seconds),
+                               [this]() { return m_stop_reporter; })) {
+    printProgress(std::cout);
+  }
 }
 
 void MultiAttack::doBwAnalysis(CombinedAnalysisResult* result) {
   if (result == nullptr) {
     return;
   }
-  const std::string file = result->getFileName();
+  if (m_worker_pool) {
+    analyseBackwardInWorker(result);
+  } else {
+    computeAttackPatternOverlaps(result);
+  }
 
-  // Backward analysis
-  for (auto c : m_analyzed_contexts) {
-      computeAttackPatternOverlap(result, c);
+  if (m_payload_analysis) {
+    // Wait for the metadata of duplicates which are still being parsed
+    const std::lock_guard<std::mutex> lock(m_deferred_mutex);
+    if (!m_loading_done) {
+      m_deferred_results.push_back(result);
+      return;
+    }
   }
+  finishBwAnalysis(result);
+}
 
-  // Additional backward analysis for generated payloads
+/**
+ * Backward analysis, larger patterns first so a pattern contained in one
+ * which does not intersect the post-image needs no intersection.
+ */
+void MultiAttack::computeAttackPatternOverlaps(CombinedAnalysisResult* result) {
+  std::set<AttackContext> disjoint_contexts;
+  const AttackPatternRegistry& registry = AttackPatternRegistry::getInstance();
+  AnalysisBudget::Scope budget(m_budget);
+  for (auto c : m_lattice_contexts) {
+    bool disjoint = false;
+    for (auto containing : registry.getContainingContexts(c)) {
+      if (disjoint_contexts.find(containing) != disjoint_contexts.end()) {
+        disjoint = true;
+        break;
+      }
+    }
+    // Restored from the journal
+    const BackwardAnalysisResult* bw = result->getBackwardAnalysis(c);
+    if (bw == nullptr) {
+      bw = computeAttackPatternOverlap(result, c, disjoint);
+    }
+    if (bw != nullptr && !bw->isErrored() && bw->isDisjoint()) {
+      disjoint_contexts.insert(c);
+    }
+  }
+}
+
+void MultiAttack::finishBwAnalysis(CombinedAnalysisResult* result) {
+  const std::string file = result->getFileName();
+
+  // Additional backward analysis for generated payloads, with a budget of
+  // its own as it may run long after the other patterns
   if (m_payload_analysis) {
+    if (m_worker_pool) {
+      analysePayloadsInWorker(result);
+    }
+    AnalysisBudget::Scope budget(m_budget);
     computeAttackPatternOverlapForMetadata(result);
   }
 
   // Finish up (delete the semattack object)
   result->finishAnalysis();
 
+  // Update the payload summary now that this result is final
+  if (!result->getFwAnalysis().isErrored()) {
+    m_progress.sanitizers_for_payload++;
+    if (result->hasAtLeastOnePayload()) {
+      m_progress.sanitizers_with_payload++;
+      if (result->hasAtLeastOneVulnerablePayload()) {
+        m_progress.vulnerable_sanitizers_with_payload++;
+      }
+      if (result->hasAllErroredPayloads()) {
+        m_progress.errored_sanitizers_with_payload++;
+      }
+    }
+  }
+  if (result->hasAtLeastOneBypass()) {
+    m_progress.vulnerable_sanitizers_with_bypass++;
+  }
+  m_progress.bw_done++;
+  journalResult(result);
+
   std::cout << "Finised backward analysis for " << file << std::endl;
-  printStatus();
 }
 
-void MultiAttack::loadDepGraphs() {
+/**
+ * Everything the journaled results depend on, a journal written with other
+ * options is not resumed.
+ */
+std::string MultiAttack::getJournalConfiguration() const {
+  std::stringstream ss;
+  FieldCodec::writeString(ss, m_input_name);
+  FieldCodec::writeString(ss, std::to_string(m_input_automaton->getFingerprint()));
+  FieldCodec::writeInt(ss, m_concats);
+  FieldCodec::writeInt(ss, m_singleton_intersection);
+  FieldCodec::writeInt(ss, m_compute_preimage);
+  FieldCodec::writeInt(ss, m_payload_analysis);
+  FieldCodec::writeInt(ss, m_attack_forward);
+  FieldCodec::writeInt(ss, m_no_exploit_match);
+  FieldCodec::writeInt(ss, m_analyzed_contexts.size());
+  for (auto c : m_analyzed_contexts) {
+    FieldCodec::writeInt(ss, static_cast<int>(c));
+  }
+  return ss.str();
+}
+
+/**
+ * Called by the group consumer, the only thread reading group automata.
+ * The first member of a group writes its post-image, a restored result
+ * reuses the file of the earlier run.
+ */
+void MultiAttack::recordPostImage(const AutomatonGroup* group, const GroupInsertion& entry) {
+  std::string post_image;
+  bool restored = false;
+  {
+    const std::lock_guard<std::mutex> lock(m_journal_mutex);
+    auto search = m_group_post_images.find(group->getId());
+    if (search != m_group_post_images.end()) {
+      post_image = search->second;
+    }
+    restored = m_restored_results.find(entry.result) != m_restored_results.end();
+  }
+  if (post_image.empty()) {
+    if (restored) {
+      post_image = m_journal.find(entry.result->getInputPath())->post_image;
+    } else {
+      post_image = m_journal.exportPostImage(entry.postImage);
+    }
+  }
+  const std::lock_guard<std::mutex> lock(m_journal_mutex);
+  m_group_post_images.emplace(group->getId(), post_image);
+  m_result_post_images[entry.result] = std::make_pair(post_image, group->getFingerprint());
+}
+
+void MultiAttack::journalResult(CombinedAnalysisResult* result) {
+  JournalEntry entry;
+  {
+    const std::lock_guard<std::mutex> lock(m_journal_mutex);
+    if (m_restored_results.find(result) != m_restored_results.end()) {
+      return;
+    }
+    auto search = m_result_post_images.find(result);
+    if (search != m_result_post_images.end()) {
+      entry.post_image = search->second.first;
+      entry.fingerprint = search->second.second;
+    }
+  }
+  if (isTransientError(result->getFwAnalysis().getError())) {
+    return;
+  }
+  entry.file = result->getFileName();
+  entry.has_sanitizer_hash = result->getMetadata().is_initialized();
+  entry.sanitizer_hash = result->getMetadata().get_sanitizer_hash();
+  entry.error = result->getFwAnalysis().getError();
+  for (auto c : m_lattice_contexts) {
+    const BackwardAnalysisResult* bw = result->getBackwardAnalysis(c);
+    if (isTransientError(bw)) {
+      return;
+    }
+    if (bw != nullptr) {
+      std::stringstream summary;
+      bw->writeSummary(summary);
+      entry.contexts.emplace_back(static_cast<int>(c), summary.str());
+    }
+  }
+  for (auto& payload : result->getPayloadAnalyses()) {
+    if (isTransientError(payload.second)) {
+      return;
+    }
+    std::stringstream summary;
+    if (payload.second != nullptr) {
+      payload.second->writeSummary(summary);
+    }
+    entry.payloads.emplace_back(payload.first, summary.str());
+  }
+  m_journal.append(entry);
+}
+
+/**
+ * Called by the group consumer once all dependency graphs have been parsed,
+ * results which arrive later are finished directly by doBwAnalysis.
+ */
+void MultiAttack::releaseDeferredResults(boost::asio::thread_pool &pool) {
+  std::vector<CombinedAnalysisResult*> deferred;
+  {
+    const std::lock_guard<std::mutex> lock(m_deferred_mutex);
+    m_loading_done = true;
+    deferred.swap(m_deferred_results);
+  }
+  for (auto result : deferred) {
+    m_progress.bw_pending++;
+    postByCost(pool, m_cost_model.getEstimate(result->getInputPath()), [this, result]() {
+      auto start = std::chrono::steady_clock::now();
+      this->finishBwAnalysis(result);
+      m_cost_model.addTime(result->getInputPath(), secondsSince(start));
+      m_progress.bw_pending--;
+    });
+  }
+}
+
+/**
+ * Everything shared by the analysis tasks, done before any thread is
+ * started as the worker processes are forked from this state.
+ */
+void MultiAttack::prepareAnalysis() {
   findDotFiles();
-  boost::asio::thread_pool pool(this->m_nThreads);
 
-  std::cout << "Parsing dependency graphs..." << std::endl;
-  // Add all files first
-  int n = 0;
-  for (const auto& file : this->m_dot_paths) {
-    n++;
-    if ((m_max > 0) && (n > m_max)) {
-      break;
-    }
-    asio::post(pool, [this, &pool, file]() {
-        try {
-          DepGraph target_dep_graph = DepGraph::parseDotFile(file.string());
-          {
-            this->findOrCreateResult(file, target_dep_graph, pool);
-          }
-        } catch(std::exception& e) {
-          cerr << "Error parsing " << file.string() << ": " << e.what() << "\n";
-        }
-      });
+  // Build the attack patterns once, each backward analysis gets a copy
+  AttackPatternRegistry::getInstance().init(m_analyzed_contexts);
+  m_lattice_contexts = AttackPatternRegistry::getInstance().getLatticeOrder(m_analyzed_contexts);
+
+  m_journal.open(m_output_directory / fs::path("semattack_journal"), getJournalConfiguration(), m_resume);
+
+  if (m_workers > 0) {
+    m_worker_pool = new WorkerPool(m_workers, [this](const std::string& request) {
+      return this->handleWorkerRequest(request);
+    });
+    std::cout << "Started " << m_workers << " worker processes." << std::endl;
   }
-  pool.join();
-  printStatus();
 }
 
+/**
+ * Parsing, forward and backward analyses share one pool. The group consumer
+ * posts the backward analysis of a sanitizer as soon as its post-image has
+ * been grouped, so no phase waits for the slowest task of the one before.
+ */
 void MultiAttack::doAnalysis() {
   boost::asio::thread_pool pool(this->m_nThreads);
+  // The consumer posts from outside the pool, so keep the pool alive
+  // while the pending tasks are temporarily drained
+  auto work = asio::make_work_guard(pool);
+  startGroupConsumer(pool);
 
-  // std::cout << "Sorting inputs:" << std::endl;
-  // std::sort(m_results.begin(), m_results.end());
-
-  std::cout << "Computing post images with pool of " << m_nThreads << " threads." << std::endl;
-  // Start the analysis
-  for (auto& result : m_results) {
-    asio::post(pool, std::bind(&MultiAttack::doBwAnalysis, this, result));
+  std::cout << "Analysing dependency graphs with pool of " << m_nThreads << " threads." << std::endl;
+  // Counts as a pending parse until all files are posted, so the consumer
+  // does not see an empty pipeline before the first one
+  m_progress.parse_pending++;
+  std::vector<fs::path> files(m_dot_paths.begin(), m_dot_paths.end());
+  if ((m_max > 0) && (files.size() > (size_t) m_max)) {
+    files.resize(m_max);
   }
+  // Graphs restored from the journal are posted first
+  std::stable_partition(files.begin(), files.end(), [this](const fs::path& file) {
+    return m_journal.find(file) != nullptr;
+  });
+  for (const auto& file : files) {
+    postLoadDepGraph(file, pool);
+  }
+  m_progress.parse_pending--;
+  waitForGroupConsumer();
+  std::cout << "Skipped parsing " << m_skipped_parses << " duplicate dependency graphs." << std::endl;
+  work.reset();
   pool.join();
-  std::cout << "Forward analysis finished!" << std::endl;
+  std::cout << "Analysis finished!" << std::endl;
   printStatus();
-  this->writeResultsToFile();  
+  this->writeResultsToFile();
 }
-  
+
 void MultiAttack::compute() {
-  loadDepGraphs();
+  prepareAnalysis();
+  startStatusReporter();
   doAnalysis();
+  stopStatusReporter();
+  if (m_worker_pool) {
+    std::cout << "Worker processes crashed: " << m_worker_pool->getCrashes() << std::endl;
+    delete m_worker_pool;
+    m_worker_pool = nullptr;
+  }
+  if (m_cache) {
+    m_cache->evict();
+    m_cache->printStatus(std::cout);
+  }
+  m_journal.printStatus(std::cout);
+  m_cost_model.printStatus(std::cout);
+  if (!m_timings_file.empty()) {
+    m_cost_model.writeTimings(m_timings_file);
+  }
 }
 
 void MultiAttack::addAttackPattern(AttackContext context)
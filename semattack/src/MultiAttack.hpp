@@ -24,20 +24,80 @@
 #ifndef MULTIATTACK_HPP_
 #define MULTIATTACK_HPP_
 
+#include "AnalysisBudget.hpp"
 #include "AutomatonGroups.hpp"
+#include "CostModel.hpp"
 #include "StrangerAutomaton.hpp"
+#include "PostImageCache.hpp"
+#include "ResultJournal.hpp"
+#include "WorkerPool.hpp"
 
 #define BOOST_FILESYSTEM_VERSION 3
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #include <boost/filesystem.hpp>
 #include <boost/asio.hpp>
+#include <boost/lockfree/queue.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <ostream>
+#include <queue>
+#include <set>
 #include <thread>
 #include <vector>
 
 namespace fs = boost::filesystem;
 
+// A finished forward analysis waiting to be inserted into the groups. The
+// post-image is a copy owned by the consumer, as the original is read by
+// the backward analysis while the groups compare against it.
+struct GroupInsertion {
+    StrangerAutomaton* postImage;
+    CombinedAnalysisResult* result;
+};
+
+// A task waiting for a pool thread, ordered by its expected cost
+struct ScheduledTask {
+    double cost;
+    unsigned long order;
+    std::function<void()> run;
+    bool operator<(const ScheduledTask& other) const;
+};
+
+// Status counters which are updated as results progress, so they can be
+// reported at any time without walking over all results and groups
+struct MultiAttackProgress {
+    MultiAttackProgress();
+
+    // DepGraph files, including all duplicates
+    std::atomic<unsigned int> entries_with_duplicates;
+    // DepGraph files after removing duplicate findings
+    std::atomic<unsigned int> non_unique_entries;
+    // Unique sanitizer hashes, i.e. results
+    std::atomic<unsigned int> entries;
+    std::atomic<unsigned int> fw_done;
+    std::atomic<unsigned int> fw_errored;
+    std::atomic<unsigned int> bw_done;
+    // Groups containing at least one result
+    std::atomic<unsigned int> non_zero_groups;
+    std::atomic<unsigned int> sanitizers_for_payload;
+    std::atomic<unsigned int> sanitizers_with_payload;
+    std::atomic<unsigned int> vulnerable_sanitizers_with_payload;
+    std::atomic<unsigned int> vulnerable_sanitizers_with_bypass;
+    std::atomic<unsigned int> errored_sanitizers_with_payload;
+    // Attack pattern intersections implied by the inclusion lattice
+    std::atomic<unsigned int> skipped_checks;
+    // Results taken from the journal of an earlier run
+    std::atomic<unsigned int> restored;
+    // Tasks of each pipeline phase which are queued or running
+    std::atomic<unsigned int> parse_pending;
+    std::atomic<unsigned int> fw_pending;
+    std::atomic<unsigned int> group_pending;
+    std::atomic<unsigned int> bw_pending;
+};
+
 // Perform attack analysis on all dot files in the given directory
 class MultiAttack {
 
@@ -51,29 +111,85 @@ public:
     void printFiles() const { printFiles(std::cout); }
     void writeResultsToFile() const;
     void printStatus(bool printGroups = true) const;
+    void printProgress(std::ostream& os) const;
     void setConcats(bool c) { m_concats = c; }
     void setSingletonIntersection(bool s) { m_singleton_intersection = s; }
     void setComputePreimage(bool c) { m_compute_preimage = c; }
     void setPayloadAnalysis(bool a) { m_payload_analysis = a; }
     void setDotFiles(bool d) { m_output_dotfiles = d; }
     void setDoForwardAnalysisWithAttackPattern(bool f) { m_attack_forward = f; }
+    void setFreeDeadAutomata(bool f) { m_free_dead_automata = f; }
+    // Orders the work by the timings in the file, which is rewritten at the end
+    void setTimingsFile(const fs::path& file);
+    // Limits each forward and backward analysis task, zero is unlimited
+    void setBudget(const AnalysisBudget& budget) { m_budget = budget; }
+    // Runs the analyses in forked worker processes, a crash only loses the
+    // dependency graph being analysed. Zero analyses in threads.
+    void setWorkers(unsigned int workers);
+    // Takes the results journaled by an interrupted run with the same
+    // options instead of analysing them again
+    void setResume(bool r) { m_resume = r; }
+    // Reuse post-images of earlier runs, max_mb of zero means no eviction
+    void setPostImageCache(const fs::path& dir, unsigned long max_mb);
+
+    static std::vector<fs::path> getDotFilesInDir(fs::path const &dir);
+    static std::vector<fs::path> getFilesInPath(fs::path const & root, std::string const & ext);
 private:
     void printResults(std::ostream& os, bool printFiles = false) const;
     void printFiles(std::ostream& os) const;
     void fillCommonPatterns();
     void findDotFiles();
-    CombinedAnalysisResult* findOrCreateResult(const fs::path& file, DepGraph& target_dep_graph, boost::asio::thread_pool &pool);
+    bool claimSanitizerHash(const fs::path& file, const Metadata& metadata);
+    void releaseSanitizerHash(const Metadata& metadata, boost::asio::thread_pool &pool);
+    void postByCost(boost::asio::thread_pool &pool, double cost, std::function<void()> task);
+    void runNextTask();
+    void postLoadDepGraph(const fs::path& file, boost::asio::thread_pool &pool);
+    void loadDepGraph(const fs::path& file, boost::asio::thread_pool &pool);
+    CombinedAnalysisResult* findOrCreateResult(const fs::path& file, DepGraph& target_dep_graph, boost::asio::thread_pool &pool,
+                                               bool restoring = false);
+    void mergeMetadata(CombinedAnalysisResult* result, const Metadata& metadata);
+    void postFwAnalysis(CombinedAnalysisResult* result, boost::asio::thread_pool &pool);
+    bool restoreResult(CombinedAnalysisResult* result, const JournalEntry& entry);
     void doFwAnalysis(CombinedAnalysisResult* result);
+    const StrangerAutomaton* computeFwAnalysis(CombinedAnalysisResult* result);
     void doBwAnalysis(CombinedAnalysisResult* result);
-    void computeAttackPatternOverlap(CombinedAnalysisResult* result, AttackContext context);
+    void computeAttackPatternOverlaps(CombinedAnalysisResult* result);
+    void finishBwAnalysis(CombinedAnalysisResult* result);
+    std::string getJournalConfiguration() const;
+    void recordPostImage(const AutomatonGroup* group, const GroupInsertion& entry);
+    void journalResult(CombinedAnalysisResult* result);
+    void releaseDeferredResults(boost::asio::thread_pool &pool);
+    BackwardAnalysisResult* computeAttackPatternOverlap(CombinedAnalysisResult* result, AttackContext context,
+                                                        bool disjoint = false);
     void computeAttackPatternOverlapForMetadata(CombinedAnalysisResult* result);
-    static std::vector<fs::path> getDotFilesInDir(fs::path const &dir);
-    static std::vector<fs::path> getFilesInPath(fs::path const & root, std::string const & ext);
+    const StrangerAutomaton* analyseInWorker(CombinedAnalysisResult* result);
+    void analyseBackwardInWorker(CombinedAnalysisResult* result);
+    void analysePayloadsInWorker(CombinedAnalysisResult* result);
+    void releaseInWorker(int worker, const std::string& file);
+    int getResultWorker(CombinedAnalysisResult* result, bool release);
+    std::string getExportFile();
+    void removeExportFiles(const std::vector<std::string>& files);
+    void writeVerdicts(std::ostream& os, CombinedAnalysisResult* result,
+                       const std::vector<std::string>& patterns, std::vector<std::string>& files);
+    void readVerdicts(std::istream& is, CombinedAnalysisResult* result, const std::vector<std::string>& patterns);
+    std::vector<bool> takeVerdicts(std::istream& is, CombinedAnalysisResult* result,
+                                   const std::vector<std::string>& patterns);
+    void giveVerdicts(std::ostream& os, CombinedAnalysisResult* result,
+                      const std::vector<std::string>& patterns, const std::vector<bool>& known);
+    std::string handleWorkerRequest(const std::string& request);
+    CombinedAnalysisResult* getWorkerResult(const fs::path& file);
+    CombinedAnalysisResult* createWorkerResult(const fs::path& file);
 
-    void loadDepGraphs();
+    void prepareAnalysis();
     void doAnalysis();
-    
-    int countDone() const;
+
+    void startGroupConsumer(boost::asio::thread_pool &pool);
+    void waitForGroupConsumer();
+    void stopGroupConsumer();
+    void consumeGroupInsertions(boost::asio::thread_pool &pool);
+    void startStatusReporter();
+    void stopStatusReporter();
+    void reportStatus();
 
     fs::path m_graph_directory;
     fs::path m_output_directory;
@@ -84,14 +200,69 @@ private:
     std::vector<CombinedAnalysisResult*> m_results;
     // A map of depgraph hashes to their results
     std::map<int, CombinedAnalysisResult*> m_result_hash_map;
+    // Duplicates found by the metadata pre-scan while the first graph with
+    // the same sanitizer hash is still being parsed
+    std::map<int, std::vector<std::pair<fs::path, Metadata> > > m_pending_metadata;
+    // Number of dot files that were never fully parsed
+    int m_skipped_parses;
     // A list of all post images
     std::vector<StrangerAutomaton*> m_automata;
     // Results grouped by post image
     AutomatonGroups m_groups;
     std::vector<AttackContext> m_analyzed_contexts;
+    // The analyzed contexts with containing patterns first
+    std::vector<AttackContext> m_lattice_contexts;
 
     std::mutex results_mutex;
 
+    // Forward analysis results are inserted into m_groups by a single
+    // consumer thread, so the workers never wait for each other. The
+    // consumer posts the backward analysis of each result it inserts.
+    boost::lockfree::queue<GroupInsertion> m_group_queue;
+    std::thread m_group_consumer;
+    std::atomic<bool> m_fw_finished;
+
+    // The payload analysis reads the metadata of all duplicates, so results
+    // wait here until every dependency graph has been parsed
+    std::mutex m_deferred_mutex;
+    std::vector<CombinedAnalysisResult*> m_deferred_results;
+    bool m_loading_done;
+
+    // Tasks are posted as trampolines which run the most expensive task
+    std::priority_queue<ScheduledTask> m_schedule;
+    std::mutex m_schedule_mutex;
+    unsigned long m_schedule_order;
+    CostModel m_cost_model;
+    fs::path m_timings_file;
+    AnalysisBudget m_budget;
+
+    unsigned int m_workers;
+    WorkerPool* m_worker_pool;
+    // The worker which keeps the analysis of a result for its backward and
+    // payload requests
+    std::mutex m_worker_mutex;
+    std::map<CombinedAnalysisResult*, int> m_result_workers;
+    // In a worker, analyses kept for the backward and payload requests
+    std::map<std::string, CombinedAnalysisResult*> m_worker_results;
+    std::atomic<unsigned long> m_worker_exports;
+
+    // Finished results are journaled, the post-image of each group is
+    // written once by the group consumer and shared by its members
+    ResultJournal m_journal;
+    std::mutex m_journal_mutex;
+    // keyed by group id, the groups move as more of them are added
+    std::map<int, std::string> m_group_post_images;
+    std::map<CombinedAnalysisResult*, std::pair<std::string, unsigned long long> > m_result_post_images;
+    std::set<CombinedAnalysisResult*> m_restored_results;
+
+    // Status is printed periodically by a reporter thread
+    MultiAttackProgress m_progress;
+    std::thread m_status_reporter;
+    std::mutex m_status_mutex;
+    std::condition_variable m_status_cv;
+    bool m_stop_reporter;
+    static const int m_status_interval_seconds = 10;
+
     // Configuration
     int m_max;
     unsigned int m_nThreads;
@@ -101,7 +272,10 @@ private:
     bool m_payload_analysis;
     bool m_output_dotfiles;
     bool m_attack_forward;
+    bool m_free_dead_automata;
     bool m_no_exploit_match;
+    bool m_resume;
+    PostImageCache* m_cache;
     StrangerAutomaton* m_input_automaton;
 };
 
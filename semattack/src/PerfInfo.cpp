@@ -23,14 +23,271 @@
 
 #include "PerfInfo.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
 using namespace std;
 
-PerfInfo::PerfInfo() {
+namespace {
+
+// All live thread local PerfInfo shards
+struct PerfInfoRegistry {
+    std::mutex mutex;
+    std::vector<PerfInfo*> shards;
+};
+
+PerfInfoRegistry& registry() {
+    static PerfInfoRegistry instance;
+    return instance;
+}
+
+}
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets()
+    , m_count(0)
+    , m_total(0)
+    , m_max(0)
+{
+    m_buckets.fill(0);
+}
+
+int LatencyHistogram::bucket(long microseconds) {
+    if (microseconds < linear_buckets) {
+        return (microseconds < 0) ? 0 : (int) microseconds;
+    }
+    int exponent = 0;
+    while ((microseconds >> (exponent + 1)) != 0) {
+        exponent++;
+    }
+    if (exponent >= max_exponent) {
+        return num_buckets - 1;
+    }
+    int sub = (int) ((microseconds >> (exponent - 3)) & (sub_buckets - 1));
+    return linear_buckets + (exponent - 4) * sub_buckets + sub;
+}
+
+long LatencyHistogram::upper_bound(int bucket) {
+    if (bucket < linear_buckets) {
+        return bucket;
+    }
+    int exponent = (bucket - linear_buckets) / sub_buckets + 4;
+    int sub = (bucket - linear_buckets) % sub_buckets;
+    long width = 1L << (exponent - 3);
+    return (1L << exponent) + (sub + 1) * width - 1;
+}
+
+void LatencyHistogram::add(long microseconds) {
+    m_buckets[bucket(microseconds)]++;
+    m_count++;
+    m_total += microseconds;
+    m_max = std::max(m_max, microseconds);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < num_buckets; i++) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_total += other.m_total;
+    m_max = std::max(m_max, other.m_max);
+}
+
+long LatencyHistogram::percentile(double p) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    unsigned long rank = (unsigned long) std::ceil(p / 100.0 * m_count);
+    rank = std::max(rank, 1UL);
+    unsigned long seen = 0;
+    for (int i = 0; i < num_buckets; i++) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return std::min(upper_bound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+PerfInfo::PerfInfo(bool shard)
+    : m_shard(shard)
+{
     reset();
+    if (m_shard) {
+        PerfInfoRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.shards.push_back(this);
+    }
 }
 
 PerfInfo::~PerfInfo() {
+    if (m_shard) {
+        // Keep the numbers of threads which have finished
+        PerfInfoRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        getRetired().merge(*this);
+        r.shards.erase(std::remove(r.shards.begin(), r.shards.end(), this), r.shards.end());
+    }
+}
+
+PerfInfo& PerfInfo::getRetired() {
+    static PerfInfo instance(false);
+    return instance;
+}
+
+PerfInfo& PerfInfo::getAggregate() {
+    static PerfInfo instance(false);
+    PerfInfoRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    instance.reset();
+    instance.merge(getRetired());
+    for (PerfInfo* shard : r.shards) {
+        instance.merge(*shard);
+    }
+    return instance;
+}
+
+void PerfInfo::merge(const PerfInfo& other) {
+	 validation_target_backward_time += other.validation_target_backward_time;
+	 validation_reference_backward_time += other.validation_reference_backward_time;
+	 validation_comparison_time += other.validation_comparison_time;
+	 validation_patch_extraction_total_time += other.validation_patch_extraction_total_time;
+	 sanitization_target_first_forward_time += other.sanitization_target_first_forward_time;
+	 sanitization_reference_first_forward_time += other.sanitization_reference_first_forward_time;
+	 sanitization_length_issue_check_time += other.sanitization_length_issue_check_time;
+	 sanitization_length_backward_time += other.sanitization_length_backward_time;
+	 sanitization_length_patch_extraction_total_time += other.sanitization_length_patch_extraction_total_time;
+	 sanitization_patch_backward_time += other.sanitization_patch_backward_time;
+	 sanitization_comparison_time += other.sanitization_comparison_time;
+	 sanitization_patch_extraction_total_time += other.sanitization_patch_extraction_total_time;
+	 intersect_total_time += other.intersect_total_time;
+	 product_total_time += other.product_total_time;
+	 union_total_time += other.union_total_time;
+	 closure_total_time += other.closure_total_time;
+	 complement_total_time += other.complement_total_time;
+	 precisewiden_total_time += other.precisewiden_total_time;
+	 coarsewiden_total_time += other.coarsewiden_total_time;
+	 concat_total_time += other.concat_total_time;
+	 pre_concat_total_time += other.pre_concat_total_time;
+	 const_pre_concat_total_time += other.const_pre_concat_total_time;
+	 replace_total_time += other.replace_total_time;
+	 pre_replace_total_time += other.pre_replace_total_time;
+	 performance_time += other.performance_time;
+	 vlab_restrict_total_time += other.vlab_restrict_total_time;
+	 pre_vlab_restrict_total_time += other.pre_vlab_restrict_total_time;
+	 addslashes_total_time += other.addslashes_total_time;
+	 pre_addslashes_total_time += other.pre_addslashes_total_time;
+	 htmlspecialchars_total_time += other.htmlspecialchars_total_time;
+	 pre_htmlspecialchars_total_time += other.pre_htmlspecialchars_total_time;
+	 stripslashes_total_time += other.stripslashes_total_time;
+	 pre_stripslashes_total_time += other.pre_stripslashes_total_time;
+	 mysql_escape_string_total_time += other.mysql_escape_string_total_time;
+	 pre_mysql_escape_string_total_time += other.pre_mysql_escape_string_total_time;
+	 to_uppercase_total_time += other.to_uppercase_total_time;
+	 pre_to_uppercase_total_time += other.pre_to_uppercase_total_time;
+	 to_lowercase_total_time += other.to_lowercase_total_time;
+	 pre_to_lowercase_total_time += other.pre_to_lowercase_total_time;
+	 trim_spaces_total_time += other.trim_spaces_total_time;
+	 pre_trim_spaces_total_time += other.pre_trim_spaces_total_time;
+	 trim_spaces_left_total_time += other.trim_spaces_left_total_time;
+	 pre_trim_spaces_left_total_time += other.pre_trim_spaces_left_total_time;
+	 trim_spaces_right_total_time += other.trim_spaces_right_total_time;
+	 pre_trim_spaces_rigth_total_time += other.pre_trim_spaces_rigth_total_time;
+	 trim_set_total_time += other.trim_set_total_time;
+	 pre_trim_set_total_time += other.pre_trim_set_total_time;
+	 substr_total_time += other.substr_total_time;
+	 pre_substr_total_time += other.pre_substr_total_time;
+	 encodeattrstring_total_time += other.encodeattrstring_total_time;
+	 pre_encodeattrstring_total_time += other.pre_encodeattrstring_total_time;
+	 encodetextfragment_total_time += other.encodetextfragment_total_time;
+	 pre_encodetextfragment_total_time += other.pre_encodetextfragment_total_time;
+	 escapehtmltags_total_time += other.escapehtmltags_total_time;
+	 pre_escapehtmltags_total_time += other.pre_escapehtmltags_total_time;
+	 num_of_intersect += other.num_of_intersect;
+	 num_of_product += other.num_of_product;
+	 num_of_union += other.num_of_union;
+	 num_of_closure += other.num_of_closure;
+	 num_of_complement += other.num_of_complement;
+	 num_of_precisewiden += other.num_of_precisewiden;
+	 num_of_coarsewiden += other.num_of_coarsewiden;
+	 num_of_concat += other.num_of_concat;
+	 num_of_pre_concat += other.num_of_pre_concat;
+	 num_of_const_pre_concat += other.num_of_const_pre_concat;
+	 num_of_replace += other.num_of_replace;
+	 num_of_pre_replace += other.num_of_pre_replace;
+	 number_of_vlab_restrict += other.number_of_vlab_restrict;
+	 number_of_pre_vlab_restrict += other.number_of_pre_vlab_restrict;
+	 number_of_addslashes += other.number_of_addslashes;
+	 number_of_pre_addslashes += other.number_of_pre_addslashes;
+	 number_of_htmlspecialchars += other.number_of_htmlspecialchars;
+	 number_of_pre_htmlspecialchars += other.number_of_pre_htmlspecialchars;
+	 number_of_encodeuricomponent += other.number_of_encodeuricomponent;
+	 number_of_decodeuricomponent += other.number_of_decodeuricomponent;
+	 number_of_stripslashes += other.number_of_stripslashes;
+	 number_of_pre_stripslashes += other.number_of_pre_stripslashes;
+	 number_of_mysql_escape_string += other.number_of_mysql_escape_string;
+	 number_of_pre_mysql_escape_string += other.number_of_pre_mysql_escape_string;
+	 number_of_to_uppercase += other.number_of_to_uppercase;
+	 number_of_pre_to_uppercase += other.number_of_pre_to_uppercase;
+	 number_of_to_lowercase += other.number_of_to_lowercase;
+	 number_of_pre_to_lowercase += other.number_of_pre_to_lowercase;
+	 number_of_trim_spaces += other.number_of_trim_spaces;
+	 number_of_pre_trim_spaces += other.number_of_pre_trim_spaces;
+	 number_of_trim_spaces_left += other.number_of_trim_spaces_left;
+	 number_of_pre_trim_spaces_left += other.number_of_pre_trim_spaces_left;
+	 number_of_trim_spaces_rigth += other.number_of_trim_spaces_rigth;
+	 number_of_pre_trim_spaces_rigth += other.number_of_pre_trim_spaces_rigth;
+	 number_of_trim_set += other.number_of_trim_set;
+	 number_of_pre_trim_set += other.number_of_pre_trim_set;
+	 number_of_substr += other.number_of_substr;
+	 number_of_pre_substr += other.number_of_pre_substr;
+	 number_of_encodeattrstring += other.number_of_encodeattrstring;
+	 number_of_pre_encodeattrstring += other.number_of_pre_encodeattrstring;
+	 number_of_encodetextfragment += other.number_of_encodetextfragment;
+	 number_of_pre_encodetextfragment += other.number_of_pre_encodetextfragment;
+	 number_of_escapehtmltags += other.number_of_escapehtmltags;
+	 number_of_pre_escapehtmltags += other.number_of_pre_escapehtmltags;
+	 number_of_dfa_copies += other.number_of_dfa_copies;
+	 dfa_copy_bytes += other.dfa_copy_bytes;
+	 number_of_shared_clones += other.number_of_shared_clones;
+	 shared_clone_bytes += other.shared_clone_bytes;
+	 number_of_computed_verdicts += other.number_of_computed_verdicts;
+	 number_of_shared_verdicts += other.number_of_shared_verdicts;
+
+	{
+		std::lock_guard<std::mutex> other_lock(other.m_histogram_mutex);
+		std::lock_guard<std::mutex> lock(m_histogram_mutex);
+		for (auto& entry : other.operation_histograms) {
+			operation_histograms[entry.first].merge(entry.second);
+		}
+		for (auto& entry : other.depgraph_op_histograms) {
+			depgraph_op_histograms[entry.first].merge(entry.second);
+		}
+		for (auto& entry : other.depgraph_pre_op_histograms) {
+			depgraph_pre_op_histograms[entry.first].merge(entry.second);
+		}
+	}
+}
+
+boost::posix_time::time_duration PerfInfo::record_operation(const std::string& name, const boost::posix_time::ptime& start_time) {
+	boost::posix_time::time_duration elapsed = current_time() - start_time;
+	std::lock_guard<std::mutex> lock(m_histogram_mutex);
+	operation_histograms[name].add(elapsed.total_microseconds());
+	return elapsed;
+}
 
+void PerfInfo::record_depgraph_op(const std::string& name, const boost::posix_time::ptime& start_time) {
+	boost::posix_time::time_duration elapsed = current_time() - start_time;
+	std::lock_guard<std::mutex> lock(m_histogram_mutex);
+	depgraph_op_histograms[name].add(elapsed.total_microseconds());
+}
+
+void PerfInfo::record_depgraph_pre_op(const std::string& name, const boost::posix_time::ptime& start_time) {
+	boost::posix_time::time_duration elapsed = current_time() - start_time;
+	std::lock_guard<std::mutex> lock(m_histogram_mutex);
+	depgraph_pre_op_histograms[name].add(elapsed.total_microseconds());
 }
 
 void PerfInfo::reset() {
@@ -134,6 +391,36 @@ void PerfInfo::reset() {
 	number_of_substr = 0;
 	number_of_pre_substr = 0;
 
+	product_total_time = boost::posix_time::microseconds(0);
+	encodeattrstring_total_time = boost::posix_time::microseconds(0);
+	pre_encodeattrstring_total_time = boost::posix_time::microseconds(0);
+	encodetextfragment_total_time = boost::posix_time::microseconds(0);
+	pre_encodetextfragment_total_time = boost::posix_time::microseconds(0);
+	escapehtmltags_total_time = boost::posix_time::microseconds(0);
+	pre_escapehtmltags_total_time = boost::posix_time::microseconds(0);
+
+	num_of_product = 0;
+	number_of_encodeuricomponent = 0;
+	number_of_decodeuricomponent = 0;
+	number_of_encodeattrstring = 0;
+	number_of_pre_encodeattrstring = 0;
+	number_of_encodetextfragment = 0;
+	number_of_pre_encodetextfragment = 0;
+	number_of_escapehtmltags = 0;
+	number_of_pre_escapehtmltags = 0;
+	number_of_dfa_copies = 0;
+	dfa_copy_bytes = 0;
+	number_of_shared_clones = 0;
+	shared_clone_bytes = 0;
+	number_of_computed_verdicts = 0;
+	number_of_shared_verdicts = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_histogram_mutex);
+		operation_histograms.clear();
+		depgraph_op_histograms.clear();
+		depgraph_pre_op_histograms.clear();
+	}
 }
 
 
@@ -214,5 +501,56 @@ void PerfInfo::print_operations_info() {
 	cout << "\t pre_trim_set : #" << number_of_pre_trim_set << " : " << pre_trim_set_total_time.total_microseconds() << endl;
 	cout << "\t substr : #" << number_of_substr << " : " << substr_total_time.total_microseconds() << endl;
 	cout << "\t pre_substr : #" << number_of_pre_substr << " : " << pre_substr_total_time.total_microseconds() << endl;
+	cout << "\t dfa copies : #" << number_of_dfa_copies << " : bytes " << dfa_copy_bytes << endl;
+	cout << "\t shared clones (copies avoided) : #" << number_of_shared_clones << " : bytes " << shared_clone_bytes << endl;
+	cout << "\t attack verdicts computed : #" << number_of_computed_verdicts << " : shared #" << number_of_shared_verdicts << endl;
 }
 
+void PerfInfo::print_histograms(std::ostream& os) const {
+	std::lock_guard<std::mutex> lock(m_histogram_mutex);
+	os << endl << "\t Operation Latency Info (microseconds: count : p50 : p99 : max)" << endl;
+	std::map<std::string, LatencyHistogram> sorted(operation_histograms.begin(), operation_histograms.end());
+	for (auto& entry : sorted) {
+		os << "\t " << entry.first << " : #" << entry.second.count() << " : " << entry.second.percentile(50)
+		   << " : " << entry.second.percentile(99) << " : " << entry.second.max() << endl;
+	}
+	os << endl << "\t DepGraph Operation Latency Info (microseconds: count : p50 : p99 : max)" << endl;
+	sorted = std::map<std::string, LatencyHistogram>(depgraph_op_histograms.begin(), depgraph_op_histograms.end());
+	for (auto& entry : sorted) {
+		os << "\t " << entry.first << " : #" << entry.second.count() << " : " << entry.second.percentile(50)
+		   << " : " << entry.second.percentile(99) << " : " << entry.second.max() << endl;
+	}
+	sorted = std::map<std::string, LatencyHistogram>(depgraph_pre_op_histograms.begin(), depgraph_pre_op_histograms.end());
+	for (auto& entry : sorted) {
+		os << "\t pre " << entry.first << " : #" << entry.second.count() << " : " << entry.second.percentile(50)
+		   << " : " << entry.second.percentile(99) << " : " << entry.second.max() << endl;
+	}
+}
+
+void PerfInfo::print_histogram_csv(std::ostream& os, const std::string& category,
+                                   const std::unordered_map<std::string, LatencyHistogram>& histograms) {
+	std::map<std::string, LatencyHistogram> sorted(histograms.begin(), histograms.end());
+	for (auto& entry : sorted) {
+		// op names are quoted, they may contain commas
+		std::string name = entry.first;
+		std::string::size_type pos = 0;
+		while ((pos = name.find('"', pos)) != std::string::npos) {
+			name.insert(pos, 1, '"');
+			pos += 2;
+		}
+		os << category << ",\"" << name << "\","
+		   << entry.second.count() << ","
+		   << entry.second.total() << ","
+		   << entry.second.percentile(50) << ","
+		   << entry.second.percentile(99) << ","
+		   << entry.second.max() << endl;
+	}
+}
+
+void PerfInfo::write_csv(std::ostream& os) const {
+	std::lock_guard<std::mutex> lock(m_histogram_mutex);
+	os << "category,name,count,total_us,p50_us,p99_us,max_us" << endl;
+	print_histogram_csv(os, "operation", operation_histograms);
+	print_histogram_csv(os, "depgraph_op", depgraph_op_histograms);
+	print_histogram_csv(os, "depgraph_pre_op", depgraph_pre_op_histograms);
+}
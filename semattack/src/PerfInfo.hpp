@@ -26,25 +26,73 @@
 #ifndef PERFINFO_HPP_
 #define PERFINFO_HPP_
 
+#include <array>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+// Log-linear latency histogram in microseconds: exact below 16us, above
+// that each power of two is split into 8 buckets (at most 12.5% error)
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(long microseconds);
+    void merge(const LatencyHistogram& other);
+
+    unsigned long count() const { return m_count; }
+    long total() const { return m_total; }
+    long max() const { return m_max; }
+    // upper bound of the bucket containing the given percentile (0-100)
+    long percentile(double p) const;
+
+private:
+    static const int linear_buckets = 16;
+    static const int sub_buckets = 8;
+    static const int max_exponent = 40;
+    static const int num_buckets = linear_buckets + (max_exponent - 4) * sub_buckets;
+
+    static int bucket(long microseconds);
+    static long upper_bound(int bucket);
+
+    std::array<unsigned long, num_buckets> m_buckets;
+    unsigned long m_count;
+    long m_total;
+    long m_max;
+};
+
 class PerfInfo {
 public:
 
-    // Make PerfInfo a singleton
+    // Every thread records into its own PerfInfo, use getAggregate() to
+    // read the numbers of all threads
     static PerfInfo & getInstance() {
-        static PerfInfo instance;
+        static thread_local PerfInfo instance(true);
         return instance;
     }
 
+    // Sum of all live threads and of all threads which have exited. Only
+    // exact once the threads doing the analysis are idle or joined.
+    static PerfInfo & getAggregate();
+
 	 void reset();
+	 void merge(const PerfInfo& other);
+
+	 // adds the time since start_time to the histogram for name and returns it
+	 boost::posix_time::time_duration record_operation(const std::string& name, const boost::posix_time::ptime& start_time);
+	 void record_depgraph_op(const std::string& name, const boost::posix_time::ptime& start_time);
+	 void record_depgraph_pre_op(const std::string& name, const boost::posix_time::ptime& start_time);
 
 	 boost::posix_time::ptime current_time();
 
 	 void print_validation_extraction_info();
 	 void print_sanitization_extraction_info();
 	 void print_operations_info();
+	 void print_histograms(std::ostream& os) const;
+	 // machine readable version of the histograms
+	 void write_csv(std::ostream& os) const;
 
 	 void calculate_total_validation_extraction_time();
 	 void calculate_total_sanitization_length_extraction_time();
@@ -165,11 +213,35 @@ public:
     unsigned int number_of_pre_encodetextfragment;
     unsigned int number_of_escapehtmltags;
     unsigned int number_of_pre_escapehtmltags;
+
+//    DFA copies made and avoided by sharing DFAs between clones
+    unsigned long number_of_dfa_copies;
+    unsigned long dfa_copy_bytes;
+    unsigned long number_of_shared_clones;
+    unsigned long shared_clone_bytes;
+
+//    Attack pattern verdicts computed and reused within a group of results
+    unsigned long number_of_computed_verdicts;
+    unsigned long number_of_shared_verdicts;
+
+//    Latency histograms of stranger operations and depgraph operations
+    std::unordered_map<std::string, LatencyHistogram> operation_histograms;
+    std::unordered_map<std::string, LatencyHistogram> depgraph_op_histograms;
+    std::unordered_map<std::string, LatencyHistogram> depgraph_pre_op_histograms;
 protected:
     virtual ~PerfInfo();
 
 private:
-    PerfInfo();
+    explicit PerfInfo(bool shard);
+    // totals of the shards of threads which have exited
+    static PerfInfo & getRetired();
+    static void print_histogram_csv(std::ostream& os, const std::string& category,
+                                    const std::unordered_map<std::string, LatencyHistogram>& histograms);
+
+    // shards register themselves so they can be aggregated
+    bool m_shard;
+    // guards the histograms, which are read by getAggregate()
+    mutable std::mutex m_histogram_mutex;
     PerfInfo(PerfInfo const &)  = delete;
     void operator=(PerfInfo const &) = delete;
 
@@ -0,0 +1,162 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * PostImageCache.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#include "PostImageCache.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Bump when the analysis or the key changes in a way that alters post-images
+static const char* CACHE_VERSION = "v2";
+static const char* CACHE_EXTENSION = ".bdd";
+
+// FNV-1a, keys are kept on disk so they must not depend on the standard
+// library or the run, unlike std::hash
+static unsigned long long stableHash(const std::string& s)
+{
+  unsigned long long h = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+PostImageCache::PostImageCache(const fs::path& dir, unsigned long max_bytes)
+  : m_dir(dir)
+  , m_max_bytes(max_bytes)
+  , m_hits(0)
+  , m_misses(0)
+  , m_stores(0)
+  , m_evictions(0)
+{
+  fs::create_directories(m_dir);
+}
+
+PostImageCache::~PostImageCache()
+{
+}
+
+std::string PostImageCache::getKey(const Metadata& metadata, const std::string& input_field_name,
+                                   const StrangerAutomaton* input, bool concat) const
+{
+  if (!metadata.is_initialized() || input == nullptr) {
+    return "";
+  }
+  std::stringstream ss;
+  ss << CACHE_VERSION << "_" << std::hex
+     << (unsigned int) metadata.get_sanitizer_hash() << "_"
+     << stableHash(input_field_name) << "_"
+     << input->getFingerprint() << "_"
+     << (concat ? "c" : "n");
+  return ss.str();
+}
+
+fs::path PostImageCache::getPath(const std::string& key) const
+{
+  return m_dir / fs::path(key + CACHE_EXTENSION);
+}
+
+StrangerAutomaton* PostImageCache::load(const std::string& key)
+{
+  fs::path path = getPath(key);
+  boost::system::error_code ec;
+  if (key.empty() || !fs::exists(path, ec)) {
+    m_misses++;
+    return nullptr;
+  }
+  StrangerAutomaton* postImage = StrangerAutomaton::importFromFile(path.string());
+  if (postImage == nullptr || postImage->isNull()) {
+    delete postImage;
+    m_misses++;
+    return nullptr;
+  }
+  // The modification time orders the entries for eviction
+  fs::last_write_time(path, std::time(nullptr), ec);
+  m_hits++;
+  return postImage;
+}
+
+/**
+ * Entries are written to a temporary file first and renamed, so other
+ * threads or processes sharing the directory never read a partial entry.
+ */
+void PostImageCache::store(const std::string& key, const StrangerAutomaton* postImage)
+{
+  if (key.empty() || postImage == nullptr || postImage->isNull()) {
+    return;
+  }
+  std::stringstream tmp_name;
+  tmp_name << key << ".tmp." << std::this_thread::get_id();
+  fs::path tmp = m_dir / fs::path(tmp_name.str());
+  postImage->exportToFile(tmp.string());
+  boost::system::error_code ec;
+  fs::rename(tmp, getPath(key), ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return;
+  }
+  m_stores++;
+}
+
+void PostImageCache::evict()
+{
+  if (m_max_bytes == 0) {
+    return;
+  }
+  // (last use, size, path) of every entry
+  std::vector<std::tuple<std::time_t, unsigned long, fs::path> > entries;
+  unsigned long total = 0;
+  boost::system::error_code ec;
+  for (fs::directory_iterator it(m_dir, ec), end; it != end; it.increment(ec)) {
+    const fs::path& path = it->path();
+    if (!fs::is_regular_file(path, ec) || path.extension() != CACHE_EXTENSION) {
+      continue;
+    }
+    unsigned long size = fs::file_size(path, ec);
+    entries.push_back(std::make_tuple(fs::last_write_time(path, ec), size, path));
+    total += size;
+  }
+  std::sort(entries.begin(), entries.end());
+  for (auto& entry : entries) {
+    if (total <= m_max_bytes) {
+      break;
+    }
+    if (fs::remove(std::get<2>(entry), ec)) {
+      total -= std::get<1>(entry);
+      m_evictions++;
+    }
+  }
+}
+
+void PostImageCache::printStatus(std::ostream& os) const
+{
+  os << "# Post-image cache hits --> misses --> stored --> evicted" << std::endl;
+  os << "# " << getHits() << " --> " << getMisses()
+     << " --> " << getStores() << " --> " << getEvictions() << std::endl;
+}
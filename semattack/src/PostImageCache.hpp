@@ -0,0 +1,83 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * PostImageCache.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef POST_IMAGE_CACHE_HPP_
+#define POST_IMAGE_CACHE_HPP_
+
+#include <atomic>
+#include <ostream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "StrangerAutomaton.hpp"
+#include "depgraph/Metadata.hpp"
+
+namespace fs = boost::filesystem;
+
+// Directory of post-images which survives between runs. Entries are keyed
+// by the sanitizer hash of the dependency graph together with everything
+// else the forward analysis depends on: the input field, the input
+// automaton and the concat option.
+class PostImageCache {
+
+public:
+  // A max_bytes of zero disables eviction
+  PostImageCache(const fs::path& dir, unsigned long max_bytes);
+  virtual ~PostImageCache();
+
+  // Returns an empty key if the metadata carries no sanitizer hash
+  std::string getKey(const Metadata& metadata, const std::string& input_field_name,
+                     const StrangerAutomaton* input, bool concat) const;
+
+  // Returns the cached post-image owned by the caller, or nullptr on a miss
+  StrangerAutomaton* load(const std::string& key);
+
+  void store(const std::string& key, const StrangerAutomaton* postImage);
+
+  // Removes the least recently used entries until the cache fits max_bytes
+  void evict();
+
+  unsigned int getHits() const { return m_hits; }
+  unsigned int getMisses() const { return m_misses; }
+  unsigned int getStores() const { return m_stores; }
+  unsigned int getEvictions() const { return m_evictions; }
+
+  void printStatus(std::ostream& os) const;
+
+private:
+  PostImageCache(const PostImageCache&) = delete;
+  PostImageCache& operator=(const PostImageCache&) = delete;
+
+  fs::path getPath(const std::string& key) const;
+
+  fs::path m_dir;
+  unsigned long m_max_bytes;
+  std::atomic<unsigned int> m_hits;
+  std::atomic<unsigned int> m_misses;
+  std::atomic<unsigned int> m_stores;
+  std::atomic<unsigned int> m_evictions;
+};
+
+#endif /* POST_IMAGE_CACHE_HPP_ */
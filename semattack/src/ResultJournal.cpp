@@ -0,0 +1,206 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * ResultJournal.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#include "ResultJournal.hpp"
+#include "FieldCodec.hpp"
+
+#include <iostream>
+#include <sstream>
+
+// Bump when the format of the entries changes
+static const char* JOURNAL_VERSION = "v1";
+static const char* JOURNAL_FILE = "journal.txt";
+static const char* JOURNAL_END = "end";
+
+JournalEntry::JournalEntry()
+  : file()
+  , has_sanitizer_hash(false)
+  , sanitizer_hash(0)
+  , error(AnalysisError::None)
+  , post_image()
+  , fingerprint(0)
+  , contexts()
+  , payloads()
+{
+}
+
+ResultJournal::ResultJournal()
+  : m_dir()
+  , m_os()
+  , m_mutex()
+  , m_entries()
+  , m_appended(0)
+{
+}
+
+ResultJournal::~ResultJournal()
+{
+}
+
+void ResultJournal::open(const fs::path& dir, const std::string& configuration, bool resume)
+{
+  m_dir = dir;
+  m_entries.clear();
+  if (resume) {
+    load(configuration);
+  }
+  if (m_entries.empty()) {
+    // Start over, the post-images of an earlier run are not needed
+    boost::system::error_code ec;
+    fs::remove_all(m_dir, ec);
+    fs::create_directories(m_dir);
+    m_os.open((m_dir / fs::path(JOURNAL_FILE)).string(), std::ofstream::out | std::ofstream::trunc);
+    FieldCodec::writeString(m_os, JOURNAL_VERSION);
+    FieldCodec::writeString(m_os, configuration);
+    m_os << std::endl;
+  } else {
+    m_os.open((m_dir / fs::path(JOURNAL_FILE)).string(), std::ofstream::out | std::ofstream::app);
+  }
+}
+
+/**
+ * Reads the entries up to the first one which does not parse, and cuts the
+ * file there so new entries are not appended after a torn one.
+ */
+void ResultJournal::load(const std::string& configuration)
+{
+  fs::path path(m_dir / fs::path(JOURNAL_FILE));
+  std::ifstream ifs(path.string(), std::ifstream::binary);
+  if (!ifs.is_open()) {
+    return;
+  }
+  if (FieldCodec::readString(ifs) != JOURNAL_VERSION || FieldCodec::readString(ifs) != configuration) {
+    std::cout << "Journal in " << m_dir.string() << " is from another configuration, starting over." << std::endl;
+    return;
+  }
+  std::streamoff valid = 0;
+  while (true) {
+    ifs >> std::ws;
+    if (!ifs.good()) {
+      break;
+    }
+    valid = ifs.tellg();
+    JournalEntry entry;
+    entry.file = FieldCodec::readString(ifs);
+    entry.has_sanitizer_hash = FieldCodec::readInt(ifs) != 0;
+    entry.sanitizer_hash = FieldCodec::readInt(ifs);
+    entry.error = static_cast<AnalysisError>(FieldCodec::readInt(ifs));
+    entry.post_image = FieldCodec::readString(ifs);
+    std::istringstream(FieldCodec::readString(ifs)) >> entry.fingerprint;
+    long n = FieldCodec::readInt(ifs);
+    for (long i = 0; ifs && i < n; i++) {
+      int context = FieldCodec::readInt(ifs);
+      entry.contexts.emplace_back(context, FieldCodec::readString(ifs));
+    }
+    n = FieldCodec::readInt(ifs);
+    for (long i = 0; ifs && i < n; i++) {
+      std::string payload = FieldCodec::readString(ifs);
+      entry.payloads.emplace_back(payload, FieldCodec::readString(ifs));
+    }
+    if (!ifs || FieldCodec::readString(ifs) != JOURNAL_END) {
+      break;
+    }
+    m_entries[entry.file] = entry;
+    valid = -1;
+  }
+  ifs.close();
+  if (valid > 0) {
+    std::cout << "Dropping torn entry at the end of " << path.string() << std::endl;
+    boost::system::error_code ec;
+    fs::resize_file(path, valid, ec);
+  }
+  if (!m_entries.empty()) {
+    std::cout << "Loaded " << m_entries.size() << " results from " << path.string() << std::endl;
+  }
+}
+
+const JournalEntry* ResultJournal::find(const fs::path& file) const
+{
+  auto search = m_entries.find(file.string());
+  return (search != m_entries.end()) ? &search->second : nullptr;
+}
+
+std::string ResultJournal::exportPostImage(const StrangerAutomaton* postImage)
+{
+  fs::path name = fs::unique_path("post_image_%%%%-%%%%-%%%%-%%%%.bdd");
+  postImage->exportToFile((m_dir / name).string());
+  return name.string();
+}
+
+StrangerAutomaton* ResultJournal::importPostImage(const std::string& name, unsigned long long fingerprint)
+{
+  fs::path path = m_dir / fs::path(name);
+  boost::system::error_code ec;
+  if (name.empty() || !fs::exists(path, ec)) {
+    return nullptr;
+  }
+  StrangerAutomaton* postImage = StrangerAutomaton::importFromFile(path.string());
+  if (postImage != nullptr && (postImage->isNull() || postImage->getFingerprint() != fingerprint)) {
+    delete postImage;
+    postImage = nullptr;
+  }
+  return postImage;
+}
+
+/**
+ * The fingerprint is written as a string, FieldCodec integers are signed.
+ * Each entry ends with a marker and is flushed, so a run which is killed
+ * leaves at most one torn entry behind.
+ */
+void ResultJournal::append(const JournalEntry& entry)
+{
+  std::stringstream ss;
+  FieldCodec::writeString(ss, entry.file);
+  FieldCodec::writeInt(ss, entry.has_sanitizer_hash);
+  FieldCodec::writeInt(ss, entry.sanitizer_hash);
+  FieldCodec::writeInt(ss, static_cast<int>(entry.error));
+  FieldCodec::writeString(ss, entry.post_image);
+  FieldCodec::writeString(ss, std::to_string(entry.fingerprint));
+  FieldCodec::writeInt(ss, entry.contexts.size());
+  for (auto& context : entry.contexts) {
+    FieldCodec::writeInt(ss, context.first);
+    FieldCodec::writeString(ss, context.second);
+  }
+  FieldCodec::writeInt(ss, entry.payloads.size());
+  for (auto& payload : entry.payloads) {
+    FieldCodec::writeString(ss, payload.first);
+    FieldCodec::writeString(ss, payload.second);
+  }
+  FieldCodec::writeString(ss, JOURNAL_END);
+  ss << '\n';
+
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_os.is_open()) {
+    return;
+  }
+  m_os << ss.str();
+  m_os.flush();
+  m_appended++;
+}
+
+void ResultJournal::printStatus(std::ostream& os) const
+{
+  os << "# Journal entries loaded --> appended" << std::endl;
+  os << "# " << getLoaded() << " --> " << getAppended() << std::endl;
+}
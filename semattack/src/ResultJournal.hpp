@@ -0,0 +1,108 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * ResultJournal.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef RESULT_JOURNAL_HPP_
+#define RESULT_JOURNAL_HPP_
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "StrangerAutomaton.hpp"
+#include "exceptions/AnalysisError.hpp"
+
+namespace fs = boost::filesystem;
+
+// A finished result as recorded in the journal. The backward analyses are
+// kept as written by BackwardAnalysisResult::writeSummary, an empty payload
+// summary means the payload had no analysis.
+struct JournalEntry {
+    JournalEntry();
+
+    std::string file;
+    bool has_sanitizer_hash;
+    int sanitizer_hash;
+    AnalysisError error;
+    // File name of the post-image in the journal directory, empty if the
+    // forward analysis failed
+    std::string post_image;
+    unsigned long long fingerprint;
+    std::vector<std::pair<int, std::string> > contexts;
+    std::vector<std::pair<std::string, std::string> > payloads;
+};
+
+// Append-only record of the finished results of a multiattack run, so an
+// interrupted run can be resumed without analysing them again. Each entry
+// is flushed as soon as it is written, a torn entry at the end of the file
+// is dropped when the journal is opened again. Post-images are stored next
+// to the journal, one file per group of equivalent post-images.
+class ResultJournal {
+
+public:
+  ResultJournal();
+  virtual ~ResultJournal();
+
+  // Starts a journal in dir. With resume, the entries of an earlier run are
+  // kept if it used the same configuration, otherwise the journal starts
+  // empty.
+  void open(const fs::path& dir, const std::string& configuration, bool resume);
+  bool isOpen() const { return m_os.is_open(); }
+
+  // The entry of an earlier run for the dot file, or nullptr. Entries are
+  // only read while the journal is open, so this needs no locking.
+  const JournalEntry* find(const fs::path& file) const;
+  unsigned int getLoaded() const { return m_entries.size(); }
+
+  // Writes the post-image to a new file and returns its name
+  std::string exportPostImage(const StrangerAutomaton* postImage);
+  // Returns the post-image owned by the caller, or nullptr if the file is
+  // missing or does not have the expected fingerprint
+  StrangerAutomaton* importPostImage(const std::string& name, unsigned long long fingerprint);
+
+  void append(const JournalEntry& entry);
+  unsigned int getAppended() const { return m_appended; }
+
+  void printStatus(std::ostream& os) const;
+
+private:
+  ResultJournal(const ResultJournal&) = delete;
+  ResultJournal& operator=(const ResultJournal&) = delete;
+
+  void load(const std::string& configuration);
+
+  fs::path m_dir;
+  std::ofstream m_os;
+  std::mutex m_mutex;
+  std::map<std::string, JournalEntry> m_entries;
+  std::atomic<unsigned int> m_appended;
+};
+
+#endif /* RESULT_JOURNAL_HPP_ */
@@ -28,12 +28,18 @@
 
 #include "SemAttack.hpp"
 #include "AttackPatterns.hpp"
+#include "AttackPatternRegistry.hpp"
+#include "FieldCodec.hpp"
 #include "exceptions/StrangerException.hpp"
 
-PerfInfo& SemAttack::perfInfo = PerfInfo::getInstance();
+thread_local PerfInfo& SemAttack::perfInfo = PerfInfo::getInstance();
 
 namespace fs = boost::filesystem;
 
+// Payloads are generated for each function and solidus option
+static const std::vector<std::string> payload_functions = { "taintfoxLog(\"xss\")", "taintfoxLog('xss')", "taintfoxLog`xss`" };
+static const std::vector<bool> payload_use_solidus = { false, true };
+
 CombinedAnalysisResult::CombinedAnalysisResult(const fs::path& target_dep_graph_file_name,
                                                DepGraph target_dep_graph_,
                                                const std::string& input_field_name,
@@ -47,6 +53,7 @@ CombinedAnalysisResult::CombinedAnalysisResult(const fs::path& target_dep_graph_
   , m_done(false)
   , m_metadataAnalysisMap()
   , m_stringAnalysisMap()
+  , m_group_verdicts()
 {
   m_metadata.push_back(target_dep_graph_.get_metadata());
 }
@@ -78,6 +85,41 @@ BackwardAnalysisResult* CombinedAnalysisResult::addBackwardAnalysis(AttackContex
   return bw;
 }
 
+void CombinedAnalysisResult::addBackwardAnalysis(AttackContext context, BackwardAnalysisResult* bw)
+{
+  if (!m_bwAnalysisMap.insert(std::make_pair(context, bw)).second) {
+    delete bw;
+  }
+}
+
+void CombinedAnalysisResult::addPayloadAnalysis(const std::string& payload, BackwardAnalysisResult* bw)
+{
+  if (!m_stringAnalysisMap.insert(std::make_pair(payload, bw)).second) {
+    delete bw;
+  }
+}
+
+bool CombinedAnalysisResult::hasPayloadAnalysis(const std::string& payload) const
+{
+  return m_stringAnalysisMap.find(payload) != m_stringAnalysisMap.end();
+}
+
+void CombinedAnalysisResult::setGroupVerdicts(const std::shared_ptr<GroupVerdicts>& verdicts)
+{
+  if (verdicts) {
+    verdicts->addMember();
+  }
+  m_group_verdicts = verdicts;
+}
+
+std::shared_ptr<AttackVerdict> CombinedAnalysisResult::getVerdict(const std::string& pattern)
+{
+  if (m_group_verdicts) {
+    return m_group_verdicts->getVerdict(pattern);
+  }
+  return std::make_shared<AttackVerdict>();
+}
+
 bool CombinedAnalysisResult::hasBackwardanalysisResult(AttackContext context) const
 {
   auto search = m_bwAnalysisMap.find(context);
@@ -87,6 +129,12 @@ bool CombinedAnalysisResult::hasBackwardanalysisResult(AttackContext context) co
   return false;
 }
 
+const BackwardAnalysisResult* CombinedAnalysisResult::getBackwardAnalysis(AttackContext context) const
+{
+  auto search = m_bwAnalysisMap.find(context);
+  return (search != m_bwAnalysisMap.end()) ? search->second : nullptr;
+}
+
 BackwardAnalysisResult* CombinedAnalysisResult::doBackwardAnalysisForPayload(const std::string& payload, const fs::path& output_dir, bool computePreImage, bool singletonIntersection, bool outputDotfiles, bool attack_forward)
 {
   if (payload.empty()) {
@@ -105,7 +153,8 @@ BackwardAnalysisResult* CombinedAnalysisResult::doBackwardAnalysisForPayload(con
       StrangerAutomaton* a = StrangerAutomaton::makeContainsString(payload);
       //a->toDotAscii(1);
       bw = new BackwardAnalysisResult(m_fwAnalysis, a, payload);
-      bw->doAnalysis(computePreImage, singletonIntersection, attack_forward);
+      std::shared_ptr<AttackVerdict> verdict = getVerdict(payload);
+      bw->doAnalysis(computePreImage, singletonIntersection, attack_forward, verdict.get());
       if (bw && outputDotfiles) {
         bw->writeResultsToFile(output_dir);
       }
@@ -124,16 +173,14 @@ void CombinedAnalysisResult::doMetadataSpecificAnalysis(const fs::path& output_d
 {
   // Create a specific payload for each metadata entry
   unsigned int i = 0;
-  static std::vector<std::string> functions = { "taintfoxLog(\"xss\")", "taintfoxLog('xss')", "taintfoxLog`xss`" };
-  static std::vector<bool> use_solidus = { false, true };
   const std::string file = getFileName();
   m_atLeastOnePayloadVulnerable = false;
   m_allPayloadsVulnerable = true;
   m_allPayloadsErrored = true;
   for (const Metadata &m : m_metadata) {
     std::vector<BackwardAnalysisResult*> bws;
-    for (auto& f : functions) {
-      for (bool b : use_solidus) {
+    for (auto& f : payload_functions) {
+      for (bool b : payload_use_solidus) {
         BackwardAnalysisResult* bw = nullptr;
         // Normal payload
         std::string payload = m.generate_exploit_from_scratch(f, b);
@@ -176,11 +223,29 @@ void CombinedAnalysisResult::doMetadataSpecificAnalysis(const fs::path& output_d
   }
 }
 
+std::vector<std::string> CombinedAnalysisResult::getPayloads() const
+{
+  std::vector<std::string> payloads;
+  std::set<std::string> seen;
+  for (const Metadata &m : m_metadata) {
+    for (auto& f : payload_functions) {
+      for (bool b : payload_use_solidus) {
+        for (auto& payload : { m.generate_exploit_from_scratch(f, b), m.generate_attribute_exploit_from_scratch(f, b) }) {
+          if (!payload.empty() && seen.insert(payload).second) {
+            payloads.push_back(payload);
+          }
+        }
+      }
+    }
+  }
+  return payloads;
+}
+
 void CombinedAnalysisResult::printHeader(std::ostream& os, const std::vector<AttackContext>& contexts) const
 {
   for (auto c : contexts) {
     os << AttackContextHelper::getName(c);
-    os << ", inclusion, post, pre, ";
+    os << ", inclusion, post, pre, error, ";
   }
 }
 
@@ -214,7 +279,7 @@ bool CombinedAnalysisResult::hasAtLeastOneBypass() const {
 void CombinedAnalysisResult::printGeneratedPayloadHeader(std::ostream& os) {
   // Headers
   os << "filename,name,";
-  os << "sanitized,inclusion,post,pre,";
+  os << "sanitized,inclusion,post,pre,error,";
   os << "one_vulnerable,all_vulnerable,";
   os << "exploits_equal,";
   os << "preimage_exploit,";
@@ -368,14 +433,203 @@ bool CombinedAnalysisResult::isFilterContained(const AttackContext& context) con
 void CombinedAnalysisResult::finishAnalysis()
 {
   getFwAnalysis().finishAnalysis();
+  if (m_group_verdicts) {
+    m_group_verdicts->releaseMember();
+    m_group_verdicts.reset();
+  }
   m_done = true;
 }
 
+AttackVerdict::AttackVerdict()
+  : m_mutex()
+  , m_computed(false)
+  , m_intersection(nullptr)
+  , m_isErrored(true)
+  , m_isSafe(false)
+  , m_isDisjoint(false)
+  , m_isContained(false)
+  , m_intersection_example()
+{
+}
+
+AttackVerdict::~AttackVerdict()
+{
+  delete m_intersection;
+  m_intersection = nullptr;
+}
+
+/**
+ * Holds the lock while computing, so other members of the group wait for
+ * the result instead of computing it again. If the computation throws the
+ * verdict stays open and the next caller tries again.
+ */
+void AttackVerdict::compute(const SemAttack* attack, const StrangerAutomaton* postImage,
+                            const StrangerAutomaton* attackPattern)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_computed) {
+    SemAttack::perfInfo.number_of_shared_verdicts++;
+    return;
+  }
+  m_isErrored = true;
+  m_isSafe = false;
+  m_isDisjoint = false;
+  m_isContained = false;
+  // Most patterns do not intersect the post-image, the product search
+  // answers that without building the intersection
+  if (postImage != nullptr && attackPattern != nullptr && !postImage->isNull() && !attackPattern->isNull() &&
+      !postImage->checkIntersection(attackPattern)) {
+    m_isErrored = false;
+    m_isSafe = true;
+    m_isDisjoint = true;
+    m_computed = true;
+    SemAttack::perfInfo.number_of_computed_verdicts++;
+    return;
+  }
+  StrangerAutomaton* intersection = attack->computeAttackPatternOverlap(postImage, attackPattern);
+  if ((intersection) && (!intersection->isNull())) {
+    m_isErrored = false;
+    m_isSafe = intersection->checkEmptyString();
+    if (!m_isSafe) {
+      m_isContained = postImage->checkInclusion(attackPattern);
+      // Cache examples for printing
+      m_intersection_example = intersection->generateSatisfyingExample();
+    }
+  }
+  m_intersection = intersection;
+  m_computed = true;
+  SemAttack::perfInfo.number_of_computed_verdicts++;
+}
+
+bool AttackVerdict::setDisjoint()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_computed) {
+    return false;
+  }
+  m_isErrored = false;
+  m_isSafe = true;
+  m_isDisjoint = true;
+  m_isContained = false;
+  m_computed = true;
+  return true;
+}
+
+StrangerAutomaton* AttackVerdict::cloneIntersection()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_intersection == nullptr) {
+    return nullptr;
+  }
+  return m_intersection->deepClone();
+}
+
+bool AttackVerdict::writeSummary(std::ostream& os, const std::string& intersection_file)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  FieldCodec::writeInt(os, m_computed);
+  if (!m_computed) {
+    return false;
+  }
+  FieldCodec::writeInt(os, m_isErrored);
+  FieldCodec::writeInt(os, m_isSafe);
+  FieldCodec::writeInt(os, m_isDisjoint);
+  FieldCodec::writeInt(os, m_isContained);
+  FieldCodec::writeString(os, m_intersection_example);
+  bool exported = m_intersection != nullptr && !intersection_file.empty();
+  if (exported) {
+    m_intersection->exportToFile(intersection_file);
+  }
+  FieldCodec::writeString(os, exported ? intersection_file : "");
+  return exported;
+}
+
+/**
+ * A verdict whose intersection cannot be read back stays open, so it is
+ * computed again rather than used without its intersection.
+ */
+std::string AttackVerdict::readSummary(std::istream& is)
+{
+  if (FieldCodec::readInt(is) == 0) {
+    return "";
+  }
+  bool errored = FieldCodec::readInt(is) != 0;
+  bool safe = FieldCodec::readInt(is) != 0;
+  bool disjoint = FieldCodec::readInt(is) != 0;
+  bool contained = FieldCodec::readInt(is) != 0;
+  std::string example = FieldCodec::readString(is);
+  std::string intersection_file = FieldCodec::readString(is);
+
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_computed) {
+    return intersection_file;
+  }
+  StrangerAutomaton* intersection = nullptr;
+  if (!intersection_file.empty()) {
+    intersection = StrangerAutomaton::importFromFile(intersection_file);
+    if (intersection == nullptr || intersection->isNull()) {
+      delete intersection;
+      return intersection_file;
+    }
+  } else if (!errored && !safe) {
+    // The pre-image needs the intersection
+    return intersection_file;
+  }
+  m_isErrored = errored;
+  m_isSafe = safe;
+  m_isDisjoint = disjoint;
+  m_isContained = contained;
+  m_intersection_example = example;
+  m_intersection = intersection;
+  m_computed = true;
+  return intersection_file;
+}
+
+bool AttackVerdict::isComputed()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_computed;
+}
+
+GroupVerdicts::GroupVerdicts()
+  : m_mutex()
+  , m_verdicts()
+  , m_members(0)
+{
+}
+
+void GroupVerdicts::addMember()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_members++;
+}
+
+void GroupVerdicts::releaseMember()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_members > 0) {
+    m_members--;
+  }
+  if (m_members == 0) {
+    m_verdicts.clear();
+  }
+}
+
+std::shared_ptr<AttackVerdict> GroupVerdicts::getVerdict(const std::string& pattern)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  std::shared_ptr<AttackVerdict>& verdict = m_verdicts[pattern];
+  if (!verdict) {
+    verdict = std::make_shared<AttackVerdict>();
+  }
+  return verdict;
+}
+
 BackwardAnalysisResult::BackwardAnalysisResult(
   ForwardAnalysisResult& fwResult, AttackContext context)
   : m_fwResult(fwResult)
   , m_name(AttackContextHelper::getName(context))
-  , m_attack(AttackPatterns::getAttackPatternForContext(context))
+  , m_attack(AttackPatternRegistry::getInstance().getAttackPattern(context))
   , m_context(context)
   , m_intersection(nullptr)
   , m_preimage(nullptr)
@@ -383,6 +637,7 @@ BackwardAnalysisResult::BackwardAnalysisResult(
   , m_error(AnalysisError::None)
   , m_isErrored(true)
   , m_isSafe(false)
+  , m_isDisjoint(false)
   , m_isContained(false)
 {
 }
@@ -396,8 +651,27 @@ BackwardAnalysisResult::BackwardAnalysisResult(
   , m_intersection(nullptr)
   , m_preimage(nullptr)
   , m_post_attack(nullptr)
+  , m_error(AnalysisError::None)
   , m_isErrored(true)
   , m_isSafe(false)
+  , m_isDisjoint(false)
+  , m_isContained(false)
+{
+}
+
+BackwardAnalysisResult::BackwardAnalysisResult(
+  ForwardAnalysisResult& fwResult, const std::string& name, AnalysisError error)
+  : m_fwResult(fwResult)
+  , m_name(name)
+  , m_attack(nullptr)
+  , m_context(AttackContext::None)
+  , m_intersection(nullptr)
+  , m_preimage(nullptr)
+  , m_post_attack(nullptr)
+  , m_error(error)
+  , m_isErrored(true)
+  , m_isSafe(false)
+  , m_isDisjoint(false)
   , m_isContained(false)
 {
 }
@@ -407,30 +681,69 @@ BackwardAnalysisResult::~BackwardAnalysisResult()
   finishAnalysis();
 }
 
-void BackwardAnalysisResult::doAnalysis(bool computePreImage, bool singletonIntersection, bool doPostAttack)
+void BackwardAnalysisResult::writeSummary(std::ostream& os) const
+{
+  FieldCodec::writeString(os, m_name);
+  FieldCodec::writeInt(os, static_cast<int>(m_error));
+  FieldCodec::writeInt(os, m_isErrored);
+  FieldCodec::writeInt(os, m_isSafe);
+  FieldCodec::writeInt(os, m_isDisjoint);
+  FieldCodec::writeInt(os, m_isContained);
+  FieldCodec::writeString(os, m_intersection_example);
+  FieldCodec::writeString(os, m_preimage_example);
+  FieldCodec::writeString(os, m_post_attack_example);
+}
+
+BackwardAnalysisResult* BackwardAnalysisResult::readSummary(ForwardAnalysisResult& fwResult, std::istream& is)
+{
+  std::string name = FieldCodec::readString(is);
+  AnalysisError error = static_cast<AnalysisError>(FieldCodec::readInt(is));
+  BackwardAnalysisResult* bw = new BackwardAnalysisResult(fwResult, name, error);
+  bw->m_isErrored = FieldCodec::readInt(is) != 0;
+  bw->m_isSafe = FieldCodec::readInt(is) != 0;
+  bw->m_isDisjoint = FieldCodec::readInt(is) != 0;
+  bw->m_isContained = FieldCodec::readInt(is) != 0;
+  bw->m_intersection_example = FieldCodec::readString(is);
+  bw->m_preimage_example = FieldCodec::readString(is);
+  bw->m_post_attack_example = FieldCodec::readString(is);
+  return bw;
+}
+
+void BackwardAnalysisResult::doAnalysis(bool computePreImage, bool singletonIntersection, bool doPostAttack,
+                                        AttackVerdict* verdict)
 {
   const StrangerAutomaton* postImage = m_fwResult.getPostImage();
-  m_intersection = this->getAttack()->computeAttackPatternOverlap(postImage, m_attack);
-  m_isErrored = true;
-  m_isSafe = false;
-  m_isContained = false;
-  if ((m_intersection) && (!m_intersection->isNull())) {
-    m_isErrored = false;
+  AttackVerdict own_verdict;
+  if (verdict == nullptr) {
+    verdict = &own_verdict;
+  }
+  try {
+    verdict->compute(this->getAttack(), postImage, m_attack);
+    m_intersection = verdict->cloneIntersection();
+  } catch (StrangerException const &e) {
+    // e.g. the budget of this task ran out, the verdict stays open for
+    // the other members of the group
+    m_isErrored = true;
+    m_error = e.getError();
+    throw;
+  }
+  m_isErrored = verdict->isErrored();
+  m_isSafe = verdict->isSafe();
+  m_isDisjoint = verdict->isDisjoint();
+  m_isContained = verdict->isContained();
+  if (!m_isErrored) {
     if (this->isVulnerable()) {
       // Only compute BW analysis if vulnerable
-      m_isSafe = false;
-      m_isContained = postImage->checkInclusion(m_attack);
-      // Cache examples for printing
-      m_intersection_example = m_intersection->generateSatisfyingExample();
+      m_intersection_example = verdict->get_intersection_example();
       if (computePreImage) {
         try {
           AnalysisResult result;
           if (singletonIntersection) {
             StrangerAutomaton* singleton = m_intersection->generateSatisfyingSingleton();
-            result = this->getAttack()->computePreImage(singleton, m_fwResult.getFwAnalysisResult());
+            result = this->getAttack()->computePreImage(singleton, m_fwResult.computeFwAnalysisResult());
             delete singleton;
           } else {
-            result = this->getAttack()->computePreImage(m_intersection, m_fwResult.getFwAnalysisResult());
+            result = this->getAttack()->computePreImage(m_intersection, m_fwResult.computeFwAnalysisResult());
           }
           const StrangerAutomaton* preimage = this->getAttack()->getPreImage(result);
           if (preimage != nullptr) {
@@ -451,25 +764,22 @@ void BackwardAnalysisResult::doAnalysis(bool computePreImage, bool singletonInte
       } else {
         m_preimage_example = "N/A";
       }
-    } else {
-      m_isSafe = true;
-      if (doPostAttack) {
-        // Otherwise see what happens if attack pattern is used for a forward analysis
-        try {
-          AnalysisResult result = this->getAttack()->computeTargetFWAnalysis(m_attack);
-          const StrangerAutomaton* post = this->getAttack()->getPostImage(result);
-          if (post) {
-            m_post_attack = new StrangerAutomaton(post);
-            m_post_attack_example = m_post_attack->generateSatisfyingExample();
-          } else {
-            m_post_attack = nullptr;
-          }
-        } catch (StrangerException const &e) {
-          std::cout << "EXCEPTION caught in bw analysis: " << e.what() << std::endl;
-          m_isErrored = true;
-          m_error = e.getError();
-          throw;
+    } else if (doPostAttack) {
+      // Otherwise see what happens if attack pattern is used for a forward analysis
+      try {
+        AnalysisResult result = this->getAttack()->computeTargetFWAnalysis(m_attack);
+        const StrangerAutomaton* post = this->getAttack()->getPostImage(result);
+        if (post) {
+          m_post_attack = new StrangerAutomaton(post);
+          m_post_attack_example = m_post_attack->generateSatisfyingExample();
+        } else {
+          m_post_attack = nullptr;
         }
+      } catch (StrangerException const &e) {
+        std::cout << "EXCEPTION caught in bw analysis: " << e.what() << std::endl;
+        m_isErrored = true;
+        m_error = e.getError();
+        throw;
       }
     }
   }
@@ -521,6 +831,13 @@ void BackwardAnalysisResult::printResult(std::ostream& os, bool printHeader) con
       os << ",N/A,";
     }
   }
+  // An errored verdict does not always come with its cause
+  if (error && m_error == AnalysisError::None) {
+    os << AnalysisErrorHelper::getName(AnalysisError::Other);
+  } else {
+    os << AnalysisErrorHelper::getName(m_error);
+  }
+  os << ",";
 }
 
 void BackwardAnalysisResult::writeResultsToFile(const fs::path& dir) const
@@ -554,30 +871,6 @@ void BackwardAnalysisResult::writeResultsToFile(const fs::path& dir) const
   }
 }
 
-bool BackwardAnalysisResult::isErrored() const {
-  if (m_intersection == nullptr) {
-    return m_isErrored;
-  }
-  return m_intersection->isNull();
-}
-
-bool BackwardAnalysisResult::isSafe() const
-{
-  if (m_intersection == nullptr) {
-    return m_isSafe;
-  }
-  return (getIntersection()->isEmpty() || getIntersection()->checkEmptyString());
-}
-
-bool BackwardAnalysisResult::isContained() const
-{
-  const StrangerAutomaton* postImage = m_fwResult.getPostImage();
-  if ((postImage == nullptr || this->m_attack == nullptr)) {
-    return m_isContained;
-  }
-  return postImage->checkInclusion(this->m_attack);
-}
-
 ForwardAnalysisResult::ForwardAnalysisResult(const fs::path& target_dep_graph_file_name,
                                              const std::string& input_field_name,
                                              DepGraph target_dep_graph_,
@@ -585,8 +878,11 @@ ForwardAnalysisResult::ForwardAnalysisResult(const fs::path& target_dep_graph_fi
   : m_attack(new SemAttack(target_dep_graph_file_name, target_dep_graph_, input_field_name))
   , m_result()
   , m_error(AnalysisError::None)
-  , m_input(automaton->clone())
+  , m_input(automaton->deepClone())
   , m_postImage(nullptr)
+  , m_doConcat(false)
+  , m_from_cache(false)
+  , m_result_pending(false)
 {
 }
 
@@ -599,8 +895,21 @@ ForwardAnalysisResult::~ForwardAnalysisResult()
     m_postImage = nullptr;
   }
 }
-void ForwardAnalysisResult::doAnalysis(bool doConcat)
+void ForwardAnalysisResult::doAnalysis(bool doConcat, PostImageCache* cache)
 {
+  m_doConcat = doConcat;
+  std::string key;
+  if (cache != nullptr) {
+    key = cache->getKey(m_attack->getMetadata(), m_attack->getInputFieldName(), m_input, doConcat);
+    m_postImage = cache->load(key);
+    if (m_postImage != nullptr) {
+      // the backward analysis computes the node automata if it needs them
+      m_from_cache = true;
+      m_result_pending = true;
+      return;
+    }
+  }
+
   try {
     m_result = m_attack->computeTargetFWAnalysis(m_input, doConcat);
   } catch (StrangerException const &e) {
@@ -615,12 +924,40 @@ void ForwardAnalysisResult::doAnalysis(bool doConcat)
   const StrangerAutomaton* post = this->getAttack()->getPostImage(m_result);
   if (post) {
     m_postImage = post->clone();
+    if (cache != nullptr) {
+      cache->store(key, m_postImage);
+    }
   } else {
     m_error = AnalysisError::MonaException;
     m_postImage = nullptr;
   }
 }
 
+void ForwardAnalysisResult::setWorkerResult(StrangerAutomaton* postImage, AnalysisError error)
+{
+  delete m_postImage;
+  m_postImage = postImage;
+  m_error = error;
+  m_from_cache = false;
+  m_result_pending = false;
+}
+
+void ForwardAnalysisResult::setRestoredResult(StrangerAutomaton* postImage, AnalysisError error, bool doConcat)
+{
+  setWorkerResult(postImage, error);
+  m_doConcat = doConcat;
+  m_result_pending = (postImage != nullptr);
+}
+
+const AnalysisResult& ForwardAnalysisResult::computeFwAnalysisResult()
+{
+  if (m_result_pending) {
+    m_result_pending = false;
+    m_result = m_attack->computeTargetFWAnalysis(m_input, m_doConcat);
+  }
+  return m_result;
+}
+
 void ForwardAnalysisResult::writeResultsToFile(const fs::path& dir) const
 {
   fs::create_directories(dir);
@@ -651,6 +988,8 @@ SemAttack::SemAttack(const fs::path& target_dep_graph_file_name, DepGraph target
   , input_field_name(input_field_name)
   , m_print_dots(false)
   , m_print(true)
+  , m_free_dead_automata(false)
+  , m_keep_backward_nodes(true)
   , target_dep_graph(target_dep_graph_)
 {
 }
@@ -660,6 +999,8 @@ SemAttack::SemAttack(const std::string& target_dep_graph_file_name, DepGraph tar
   , input_field_name(input_field_name)
   , m_print_dots(false)
   , m_print(true)
+  , m_free_dead_automata(false)
+  , m_keep_backward_nodes(true)
   , target_dep_graph(target_dep_graph_)
 {
 }
@@ -736,9 +1077,12 @@ void SemAttack::printResults() const {
       DEBUG_AUTO(target_sink_auto);
     }
 
-    perfInfo.print_validation_extraction_info();
-    perfInfo.print_sanitization_extraction_info();
-    perfInfo.print_operations_info();
+    // Numbers of all analysis threads
+    PerfInfo& totalPerfInfo = PerfInfo::getAggregate();
+    totalPerfInfo.print_validation_extraction_info();
+    totalPerfInfo.print_sanitization_extraction_info();
+    totalPerfInfo.print_operations_info();
+    totalPerfInfo.print_histograms(cout);
 //    perfInfo.reset();
 }
 
@@ -782,6 +1126,7 @@ AnalysisResult SemAttack::computeTargetFWAnalysis(const StrangerAutomaton* input
     targetAnalysisResult.set(target_uninit_field_node->getID(), inputAuto->clone());
 
     ImageComputer targetAnalyzer(doConcat, false, inputAuto->clone());
+    targetAnalyzer.setFreeDeadAutomata(m_free_dead_automata, m_keep_backward_nodes);
 
     try {
         message("starting forward aalysis for target...");
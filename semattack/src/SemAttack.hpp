@@ -26,12 +26,16 @@
 #ifndef SEMATTACK_HPP_
 #define SEMATTACK_HPP_
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <boost/filesystem.hpp>
 #include "StrangerAutomaton.hpp"
 #include "AttackContext.hpp"
 #include "exceptions/AnalysisError.hpp"
 #include "ImageComputer.hpp"
+#include "PostImageCache.hpp"
 #include "SemRepairDebugger.hpp"
 #include "depgraph/DepGraph.hpp"
 #include "depgraph/Metadata.hpp"
@@ -75,10 +79,17 @@ public:
     
     void setPrintDots(bool print) { m_print_dots = print; }
     void setPrint(bool print) { m_print = print; }
+    // Free intermediate forward automata, see ImageComputer::setFreeDeadAutomata
+    void setFreeDeadAutomata(bool freeDead, bool keepBackwardNodes = true) {
+      m_free_dead_automata = freeDead;
+      m_keep_backward_nodes = keepBackwardNodes;
+    }
     
     std::string getFileName() const { return target_dep_graph_file_name.string(); }
     const fs::path& getFile() const { return target_dep_graph_file_name; }
-    static PerfInfo& perfInfo;
+    const std::string& getInputFieldName() const { return input_field_name; }
+    const Metadata& getMetadata() const { return target_dep_graph.get_metadata(); }
+    static thread_local PerfInfo& perfInfo;
 
 private:
     fs::path target_dep_graph_file_name;
@@ -97,6 +108,8 @@ private:
 
     bool m_print_dots;
     bool m_print;    
+    bool m_free_dead_automata;
+    bool m_keep_backward_nodes;
 };
 
 // Class containing all revelant forward analysis results
@@ -111,12 +124,21 @@ public:
         
     virtual ~ForwardAnalysisResult();
 
-    void doAnalysis(bool doConcat = false);
+    // Loads the post-image from the cache if it is given and has an entry
+    void doAnalysis(bool doConcat = false, PostImageCache* cache = nullptr);
 
     const SemAttack* getAttack() const { return m_attack; }
     SemAttack* getAttack() { return m_attack; }
     const StrangerAutomaton* getPostImage() const { return m_postImage; }
     const AnalysisResult& getFwAnalysisResult() const { return m_result; }
+    // As getFwAnalysisResult, but runs the analysis skipped by a cache hit
+    const AnalysisResult& computeFwAnalysisResult();
+    bool isFromCache() const { return m_from_cache; }
+    // Post-image computed by a worker process, the analysis result stays empty
+    void setWorkerResult(StrangerAutomaton* postImage, AnalysisError error);
+    // Post-image read from the journal of an earlier run, the analysis
+    // result is computed if a pre-image needs it
+    void setRestoredResult(StrangerAutomaton* postImage, AnalysisError error, bool doConcat);
     bool isErrored() const;
     AnalysisError getError() const { return m_error; };
 
@@ -129,6 +151,79 @@ private:
   AnalysisError m_error;
   StrangerAutomaton* m_input;
   StrangerAutomaton* m_postImage;
+  bool m_doConcat;
+  bool m_from_cache;
+  // the node automata of m_result have not been computed yet
+  bool m_result_pending;
+};
+
+// Intersection of a post-image with an attack pattern and the verdicts
+// derived from it. These only depend on the post-image, so all results
+// with an equivalent post-image can share them.
+class AttackVerdict {
+
+public:
+    AttackVerdict();
+    virtual ~AttackVerdict();
+
+    // The first call computes the verdict, later calls return immediately
+    void compute(const SemAttack* attack, const StrangerAutomaton* postImage,
+                 const StrangerAutomaton* attackPattern);
+
+    // Fills in the verdict for a pattern known not to intersect the
+    // post-image. Returns false if the verdict was already computed.
+    bool setDisjoint();
+
+    // Copy of the intersection owned by the caller, nullptr if there is none
+    StrangerAutomaton* cloneIntersection();
+
+    // Passes a computed verdict between processes, the intersection goes
+    // through intersection_file. writeSummary returns true if it wrote the
+    // file, readSummary keeps a verdict which is already computed and
+    // returns the file named in the summary for the caller to remove.
+    bool writeSummary(std::ostream& os, const std::string& intersection_file);
+    std::string readSummary(std::istream& is);
+    bool isComputed();
+
+    bool isErrored() const { return m_isErrored; }
+    bool isSafe() const { return m_isSafe; }
+    bool isDisjoint() const { return m_isDisjoint; }
+    bool isContained() const { return m_isContained; }
+    const std::string& get_intersection_example() const { return m_intersection_example; }
+
+private:
+    AttackVerdict(const AttackVerdict&) = delete;
+    AttackVerdict& operator=(const AttackVerdict&) = delete;
+
+    // Members of a group run in different threads and MONA automata must
+    // not be read concurrently, so the intersection is only used under lock
+    std::mutex m_mutex;
+    bool m_computed;
+    StrangerAutomaton* m_intersection;
+    bool m_isErrored;
+    bool m_isSafe;
+    // The intersection is empty, safe results may also accept the empty string
+    bool m_isDisjoint;
+    bool m_isContained;
+    std::string m_intersection_example;
+};
+
+// Verdicts for the members of one AutomatonGroup, keyed by the name of the
+// attack pattern. The verdicts are freed once the last member is finished.
+class GroupVerdicts {
+
+public:
+    GroupVerdicts();
+
+    void addMember();
+    void releaseMember();
+
+    std::shared_ptr<AttackVerdict> getVerdict(const std::string& pattern);
+
+private:
+    std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<AttackVerdict> > m_verdicts;
+    unsigned int m_members;
 };
 
 // Class containing all revelant backward analysis results
@@ -142,9 +237,21 @@ public:
     BackwardAnalysisResult(ForwardAnalysisResult& result,
                            const StrangerAutomaton* attack, const std::string& name);
 
+    // Errored result without automata, for an analysis which did not return
+    BackwardAnalysisResult(ForwardAnalysisResult& result,
+                           const std::string& name, AnalysisError error);
+
     virtual ~BackwardAnalysisResult();
 
-    void doAnalysis(bool computePreImage = true, bool singletonIntersection = false, bool doPostAttack = false);
+    // The verdicts and examples of a result computed in a worker process or
+    // read from the journal of an earlier run. Automata are not included.
+    void writeSummary(std::ostream& os) const;
+    static BackwardAnalysisResult* readSummary(ForwardAnalysisResult& result, std::istream& is);
+
+    // Takes the intersection verdicts from the given shared verdict, only
+    // the pre-image and post-attack image are computed for this graph
+    void doAnalysis(bool computePreImage = true, bool singletonIntersection = false, bool doPostAttack = false,
+                    AttackVerdict* verdict = nullptr);
     void finishAnalysis();
 
     const StrangerAutomaton* getPreImage() const { return m_preimage; }
@@ -152,10 +259,11 @@ public:
     const StrangerAutomaton* getAttackPattern() const { return m_attack; }
     const StrangerAutomaton* getAttackPostImage() const { return m_post_attack; }
 
-    bool isErrored() const;
+    bool isErrored() const { return m_isErrored; }
     AnalysisError getError() const { return m_error; }
-    bool isSafe() const;
-    bool isContained() const;
+    bool isSafe() const { return m_isSafe; }
+    bool isDisjoint() const { return m_isDisjoint; }
+    bool isContained() const { return m_isContained; }
     bool isVulnerable() const { return !isSafe(); }
 
     bool hasPostAttackImage() const { return m_post_attack != nullptr; }
@@ -188,6 +296,7 @@ private:
     AnalysisError m_error;
     bool m_isErrored;
     bool m_isSafe;
+    bool m_isDisjoint;
     bool m_isContained;
 
     std::string m_intersection_example;
@@ -209,9 +318,24 @@ public:
     bool operator< (const CombinedAnalysisResult &other) const;
     
     BackwardAnalysisResult* addBackwardAnalysis(AttackContext context);
+    // Adds a result computed elsewhere, ownership is taken
+    void addBackwardAnalysis(AttackContext context, BackwardAnalysisResult* bw);
+    void addPayloadAnalysis(const std::string& payload, BackwardAnalysisResult* bw);
+    bool hasPayloadAnalysis(const std::string& payload) const;
+    const std::map<std::string, BackwardAnalysisResult*>& getPayloadAnalyses() const { return m_stringAnalysisMap; }
     bool hasBackwardanalysisResult(AttackContext context) const;
+    const BackwardAnalysisResult* getBackwardAnalysis(AttackContext context) const;
+
+    // Share attack pattern verdicts with the other members of a group
+    void setGroupVerdicts(const std::shared_ptr<GroupVerdicts>& verdicts);
+    // Verdict shared with the group, or a new one if there is no group
+    std::shared_ptr<AttackVerdict> getVerdict(const std::string& pattern);
 
     void doMetadataSpecificAnalysis(const fs::path& output_dir, bool computePreImage = true, bool singletonIntersection = false, bool outputDotfiles = true, bool attack_forward = false);
+    // The payloads analysed by doMetadataSpecificAnalysis, in order
+    std::vector<std::string> getPayloads() const;
+    BackwardAnalysisResult* doBackwardAnalysisForPayload(const std::string& payload, const fs::path& output_dir,
+                                                         bool computePreImage, bool singletonIntersection, bool outputDotfiles, bool attack_forward);
 
     const SemAttack* getAttack() const { return m_fwAnalysis.getAttack(); }
     SemAttack* getAttack() { return m_fwAnalysis.getAttack(); }
@@ -253,8 +377,6 @@ public:
     bool isDone() const { return m_done; }
 
 private:
-    BackwardAnalysisResult* doBackwardAnalysisForPayload(const std::string& payload, const fs::path& output_dir,
-                                                         bool computePreImage, bool singletonIntersection, bool outputDotfiles, bool attack_forward);
     fs::path m_inputfile;
     std::string m_input_name;
     bool m_done;
@@ -268,6 +390,7 @@ private:
     std::map<const Metadata*, std::vector<BackwardAnalysisResult*> > m_metadataAnalysisMap;
     // Also keep track of which strings have been analysed
     std::map<std::string, BackwardAnalysisResult*> m_stringAnalysisMap;
+    std::shared_ptr<GroupVerdicts> m_group_verdicts;
     // Track if at least one BW analysis had an overlap 
     bool m_atLeastOnePayloadVulnerable;
     // Track if not all were successful
@@ -29,7 +29,7 @@
 #include "AttackPatterns.hpp"
 #include "exceptions/StrangerException.hpp"
 
-PerfInfo& SemAttackBw::perfInfo = PerfInfo::getInstance();
+thread_local PerfInfo& SemAttackBw::perfInfo = PerfInfo::getInstance();
 
 SemAttackBw::SemAttackBw(const string& target_dep_graph_file_name, const string& input_field_name)
   : enable_debug(true)
@@ -53,7 +53,7 @@ public:
 
     bool calculate_rejected_set = false;
 
-    static PerfInfo& perfInfo;
+    static thread_local PerfInfo& perfInfo;
 
 private:
     const StrangerAutomaton* sink_auto;
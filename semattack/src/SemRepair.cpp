@@ -25,7 +25,7 @@
 #include "ValidationImageComputer.hpp"
 #include "exceptions/StrangerException.hpp"
 
-PerfInfo& SemRepair::perfInfo = PerfInfo::getInstance();
+thread_local PerfInfo& SemRepair::perfInfo = PerfInfo::getInstance();
 
 SemRepair::SemRepair(string reference_dep_graph_file_name,string target_dep_graph_file_name, string input_field_name) {
 
@@ -24,20 +24,42 @@
  * Authors: Abdulbaki Aydin, Muath Alkhalaf
  */
 #include "StrangerAutomaton.hpp"
+#include "AnalysisBudget.hpp"
 #include "exceptions/StrangerException.hpp"
 
+#include <mutex>
+
 using namespace std;
 
+// MONA import and export use global state, every caller shares this lock
+static std::mutex io_mutex;
+
 StrangerAutomaton::StrangerAutomaton(DFA* dfa)
 {
 	init();
 	this->dfa = dfa;
+	if (dfa != NULL) {
+		this->dfa_ref = std::shared_ptr<DFA>(dfa, dfaFree);
+		// every operation ends here, so this is where a task over its budget
+		// is cancelled, dfa_ref frees the DFA if this throws
+		AnalysisBudget::check(dfa->ns, bdd_size(dfa->bddm));
+	}
 }
 
+/**
+ * The new automaton shares the DFA of other, nothing is copied. DFAs are never
+ * modified in place, getDfa() copies a shared DFA before handing it out.
+ */
 StrangerAutomaton::StrangerAutomaton(const StrangerAutomaton* other)
 {
-	init();        
-	this->dfa = dfaCopy(other->dfa);
+	init();
+	this->dfa = other->dfa;
+	this->dfa_ref = other->dfa_ref;
+	this->transitions_ref = std::atomic_load(&other->transitions_ref);
+	if (this->dfa != NULL) {
+		perfInfo->number_of_shared_clones++;
+		perfInfo->shared_clone_bytes += dfaBytes(this->dfa);
+	}
 }
 
 StrangerAutomaton::StrangerAutomaton()
@@ -48,16 +70,16 @@ void StrangerAutomaton::init()
 {
     top = false;
     bottom = false;
+    this->dfa = NULL;
     this->ID = -1;
     this->autoTraceID = traceID++;
 }
 
 StrangerAutomaton::~StrangerAutomaton()
 {
-    if (this->dfa != NULL ){
-        dfaFree(this->dfa);
-        this->dfa = NULL;
-    }
+    // the last automaton sharing the DFA frees it
+    this->dfa_ref.reset();
+    this->dfa = NULL;
 }
 
 // some static members
@@ -82,14 +104,69 @@ char StrangerAutomaton::slash = '/';
 
 bool StrangerAutomaton::coarseWidening = false;
 
-PerfInfo* StrangerAutomaton::perfInfo = &PerfInfo::getInstance();
+thread_local PerfInfo* StrangerAutomaton::perfInfo = &PerfInfo::getInstance();
 
 
+/**
+ * Gives write access to the DFA, so a DFA shared with other automata is
+ * copied first.
+ */
 DFA* StrangerAutomaton::getDfa()
 {
+    if (this->dfa != NULL && this->dfa_ref.use_count() > 1) {
+        this->dfa_ref = std::shared_ptr<DFA>(copyDfa(this->dfa), dfaFree);
+        this->dfa = this->dfa_ref.get();
+    }
+    // the caller may change the transitions
+    std::atomic_store(&this->transitions_ref, std::shared_ptr<TransitionTable>());
     return this->dfa;
 }
 
+/**
+ * Decodes the transitions of the automaton the first time a function model
+ * is applied to it. Automata are read by several threads, a table built by
+ * two of them at once is only built twice.
+ */
+StrangerAutomaton::TransitionScope::TransitionScope(const StrangerAutomaton* automaton)
+    : dfa(automaton->dfa)
+    , table()
+{
+    if (dfa == NULL) {
+        return;
+    }
+    table = std::atomic_load(&automaton->transitions_ref);
+    if (!table) {
+        table = std::shared_ptr<TransitionTable>(dfaBuildTransitionTable(dfa, num_ascii_track, indices_main),
+                                                 dfaFreeTransitionTable);
+        std::atomic_store(&automaton->transitions_ref, table);
+    }
+    dfaShareTransitionTable(dfa, table.get());
+}
+
+StrangerAutomaton::TransitionScope::~TransitionScope()
+{
+    if (dfa != NULL) {
+        dfaUnshareTransitionTable(dfa);
+    }
+}
+
+DFA* StrangerAutomaton::copyDfa(DFA* dfa)
+{
+    perfInfo->number_of_dfa_copies++;
+    perfInfo->dfa_copy_bytes += dfaBytes(dfa);
+    return dfaCopy(dfa);
+}
+
+/**
+ * Approximate heap size of a DFA: the final and transition arrays plus
+ * the BDD node table.
+ */
+unsigned long StrangerAutomaton::dfaBytes(const DFA* dfa)
+{
+    return (unsigned long) dfa->ns * (sizeof(int) + sizeof(bdd_ptr))
+        + (unsigned long) bdd_size(dfa->bddm) * 4 * sizeof(unsigned);
+}
+
 StrangerAutomaton* StrangerAutomaton::clone(int id) const
 {
 	debug(stringbuilder() << id << " = clone(" << this->ID << ")");
@@ -98,8 +175,8 @@ StrangerAutomaton* StrangerAutomaton::clone(int id) const
 	else if (isTop())
 		return makeTop(id);
         else {
-		debugToFile(stringbuilder() << "M[" << traceID << "] = dfaCopy(M["  << this->autoTraceID << "]);//" << id << " = clone(" << this->ID << ")");
-		StrangerAutomaton* retMe = new StrangerAutomaton(dfaCopy(this->dfa));
+		debugToFile(stringbuilder() << "M[" << traceID << "] = M["  << this->autoTraceID << "];//" << id << " = clone(" << this->ID << ")");
+		StrangerAutomaton* retMe = new StrangerAutomaton(this);
 		{
 			retMe->setID(id);
 			retMe->debugAutomaton();
@@ -113,6 +190,27 @@ StrangerAutomaton* StrangerAutomaton::clone() const
     return this->clone(-1);
 }
 
+/**
+ * Clones with a private copy of the DFA. MONA marks the nodes of a DFA
+ * while reading it, so an automaton which is read by other threads
+ * must not share its DFA.
+ */
+StrangerAutomaton* StrangerAutomaton::deepClone(int id) const
+{
+	if (isBottom() || isTop() || this->dfa == NULL) {
+		return clone(id);
+	}
+	debugToFile(stringbuilder() << "M[" << traceID << "] = dfaCopy(M["  << this->autoTraceID << "]);//" << id << " = deepClone(" << this->ID << ")");
+	StrangerAutomaton* retMe = new StrangerAutomaton(copyDfa(this->dfa));
+	retMe->setID(id);
+	return retMe;
+}
+
+StrangerAutomaton* StrangerAutomaton::deepClone() const
+{
+    return this->deepClone(-1);
+}
+
 
 
 /**
@@ -256,18 +354,65 @@ StrangerAutomaton* StrangerAutomaton::makeString(const std::string& s)
     return makeString(s, traceID);
 }
 
+/**
+ * Creates an automaton that accepts all strings containing the given
+ * string. The automaton is built directly from the KMP failure function of
+ * s, it has one state per prefix of s.
+ */
 StrangerAutomaton* StrangerAutomaton::makeContainsString(const std::string& s, int id)
 {
-    StrangerAutomaton* aut = makeString(s, id);
+    debug(stringbuilder() << id << " = makeContainsString(" << s << ")");
+    StrangerAutomaton* retMe = new StrangerAutomaton(
+        dfa_construct_contains_string(s.c_str(), num_ascii_track, indices_main));
+    {
+        retMe->setID(id);
+        retMe->debugAutomaton();
+    }
+    return retMe;
+}
+
+StrangerAutomaton* StrangerAutomaton::makeContainsString(const std::string& s)
+{
+    return makeContainsString(s, traceID);
+}
+
+/**
+ * Same language as makeContainsString, but from the concatenation of the
+ * string with S* on both sides. Only kept to compare both in containsbench.
+ */
+StrangerAutomaton* StrangerAutomaton::makeContainsStringByClosure(const std::string& s)
+{
+    StrangerAutomaton* aut = makeString(s);
     StrangerAutomaton* contained = new StrangerAutomaton(
         dfa_star_M_star(aut->dfa, num_ascii_track, indices_main));
     delete aut;
     return contained;
 }
 
-StrangerAutomaton* StrangerAutomaton::makeContainsString(const std::string& s)
+/**
+ * Creates an automaton that accepts all strings containing at least one of
+ * the given strings, built from their Aho-Corasick automaton. No strings
+ * give the empty language.
+ */
+StrangerAutomaton* StrangerAutomaton::makeContainsAnyString(const std::vector<std::string>& strings, int id)
 {
-    return makeContainsString(s, traceID);
+    debug(stringbuilder() << id << " = makeContainsAnyString(" << strings.size() << " strings)");
+    std::vector<char*> set;
+    for (const std::string& s : strings) {
+        set.push_back(const_cast<char*>(s.c_str()));
+    }
+    StrangerAutomaton* retMe = new StrangerAutomaton(
+        dfa_construct_contains_any(set.data(), set.size(), num_ascii_track, indices_main));
+    {
+        retMe->setID(id);
+        retMe->debugAutomaton();
+    }
+    return retMe;
+}
+
+StrangerAutomaton* StrangerAutomaton::makeContainsAnyString(const std::vector<std::string>& strings)
+{
+    return makeContainsAnyString(strings, traceID);
 }
 
 /**
@@ -627,7 +772,7 @@ StrangerAutomaton* StrangerAutomaton::closure(int id) {
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_closure_extrabit(this->dfa, num_ascii_track, indices_main));
-    perfInfo->closure_total_time += perfInfo->current_time() - start_time;
+    perfInfo->closure_total_time += perfInfo->record_operation("closure", start_time);
     perfInfo->num_of_closure++;
     
     retMe->setID(id);
@@ -825,7 +970,7 @@ StrangerAutomaton* StrangerAutomaton::complement(int id) const {
     
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_negate(this->dfa, num_ascii_track, indices_main));
-    perfInfo->complement_total_time += perfInfo->current_time() - start_time;
+    perfInfo->complement_total_time += perfInfo->record_operation("complement", start_time);
     perfInfo->num_of_complement++;
     
     
@@ -876,7 +1021,7 @@ StrangerAutomaton* StrangerAutomaton::union_(const StrangerAutomaton* otherAuto,
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_union_with_emptycheck(this->dfa, otherAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->union_total_time += perfInfo->current_time() - start_time;
+    perfInfo->union_total_time += perfInfo->record_operation("union", start_time);
     perfInfo->num_of_union++;
     
     
@@ -950,7 +1095,7 @@ StrangerAutomaton* StrangerAutomaton::intersect(const StrangerAutomaton* otherAu
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_intersect(this->dfa, otherAuto->dfa));
-    perfInfo->intersect_total_time += perfInfo->current_time() - start_time;
+    perfInfo->intersect_total_time += perfInfo->record_operation("intersect", start_time);
     perfInfo->num_of_intersect++;
     
     {
@@ -975,7 +1120,7 @@ StrangerAutomaton* StrangerAutomaton::productImpl(StrangerAutomaton* otherAuto,
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_product_impl(this->dfa, otherAuto->dfa));
-    perfInfo->product_total_time += perfInfo->current_time() - start_time;
+    perfInfo->product_total_time += perfInfo->record_operation("product", start_time);
     perfInfo->num_of_product++;
 
     {
@@ -1028,7 +1173,7 @@ StrangerAutomaton* StrangerAutomaton::preciseWiden(const StrangerAutomaton* othe
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaWiden(this->dfa, otherAuto->dfa));
-    perfInfo->precisewiden_total_time += perfInfo->current_time() - start_time;
+    perfInfo->precisewiden_total_time += perfInfo->record_operation("precisewiden", start_time);
     perfInfo->num_of_precisewiden++;
     
     {
@@ -1080,7 +1225,7 @@ StrangerAutomaton* StrangerAutomaton::coarseWiden(const StrangerAutomaton* other
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaWiden(this->dfa, otherAuto->dfa));
-    perfInfo->coarsewiden_total_time += perfInfo->current_time() - start_time;
+    perfInfo->coarsewiden_total_time += perfInfo->record_operation("coarsewiden", start_time);
     perfInfo->num_of_coarsewiden++;
     {
         retMe->setID(id);
@@ -1133,7 +1278,7 @@ StrangerAutomaton* StrangerAutomaton::concatenate(const StrangerAutomaton* other
     // dfa_concat_extrabit returns new dfa structure in memory so no need to
     // worry about the two dfas of this and auto
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_concat(this->dfa, otherAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->concat_total_time += perfInfo->current_time() - start_time;
+    perfInfo->concat_total_time += perfInfo->record_operation("concat", start_time);
     perfInfo->num_of_concat++;
 
     {
@@ -1191,7 +1336,7 @@ StrangerAutomaton* StrangerAutomaton::leftPreConcat(const StrangerAutomaton* rig
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_concat(this->dfa, rightSiblingAuto->dfa, 1, num_ascii_track, indices_main));
-    perfInfo->pre_concat_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_concat_total_time += perfInfo->record_operation("pre_concat", start_time);
     perfInfo->num_of_pre_concat++;
     {
         retMe->setID(id);
@@ -1241,7 +1386,7 @@ StrangerAutomaton* StrangerAutomaton::leftPreConcatConst(std::string rightSiblin
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_concat_const(this->dfa, rightSiblingString.c_str(), 1, num_ascii_track, indices_main));
-    perfInfo->const_pre_concat_total_time += perfInfo->current_time() - start_time;
+    perfInfo->const_pre_concat_total_time += perfInfo->record_operation("const_pre_concat", start_time);
     perfInfo->num_of_const_pre_concat++;
     
     
@@ -1292,7 +1437,7 @@ StrangerAutomaton* StrangerAutomaton::rightPreConcat(const StrangerAutomaton* le
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_concat(this->dfa, leftSiblingAuto->dfa, 2, num_ascii_track, indices_main));
-    perfInfo->pre_concat_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_concat_total_time += perfInfo->record_operation("pre_concat", start_time);
     perfInfo->num_of_pre_concat++;
     {
         retMe->setID(id);
@@ -1342,7 +1487,7 @@ StrangerAutomaton* StrangerAutomaton::rightPreConcatConst(std::string leftSiblin
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_concat_const(this->dfa, leftSiblingString.c_str(), 2, num_ascii_track, indices_main));
-    perfInfo->const_pre_concat_total_time += perfInfo->current_time() - start_time;
+    perfInfo->const_pre_concat_total_time += perfInfo->record_operation("const_pre_concat", start_time);
     perfInfo->num_of_const_pre_concat++;
     
     {
@@ -1488,7 +1633,7 @@ StrangerAutomaton* StrangerAutomaton::reg_replace(const StrangerAutomaton* patte
     
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_replace_extrabit(subjectAuto->dfa, patternAuto->dfa, replaceStr.c_str(), num_ascii_track, indices_main));
-    perfInfo->replace_total_time += perfInfo->current_time() - start_time;
+    perfInfo->replace_total_time += perfInfo->record_operation("replace", start_time);
     perfInfo->num_of_replace++;
     
     {
@@ -1501,6 +1646,21 @@ StrangerAutomaton* StrangerAutomaton::reg_replace(const StrangerAutomaton* patte
     return retMe;
 }
 
+/**
+ * Builds the character map of translations for dfa_map_chars, size is the
+ * number of characters.
+ */
+static std::vector<unsigned char> translationMap(const std::map<char, char>& translations, size_t size)
+{
+    std::vector<unsigned char> map(size);
+    for (size_t c = 0; c < map.size(); c++) {
+        map[c] = (unsigned char) c;
+    }
+    for (auto const& translation : translations) {
+        map[(unsigned char) translation.first] = (unsigned char) translation.second;
+    }
+    return map;
+}
 
 StrangerAutomaton* StrangerAutomaton::general_replace(const StrangerAutomaton* patternAuto, const StrangerAutomaton* replaceAuto, const StrangerAutomaton* subjectAuto, int id) {
 
@@ -1533,10 +1693,17 @@ StrangerAutomaton* StrangerAutomaton::general_replace(const StrangerAutomaton* p
         //std::cout << patternAuto->isEmpty() << ", " << patternStr.length() << ", " <<  replaceStr.length() << std::endl;
         if ( ((patternStr.length() == 0) && (patternAuto->isEmpty())) || (replaceStr == patternStr)) {
           retMe = new StrangerAutomaton(subjectAuto);
+        } else if ((patternStr.length() == 1) && (replaceStr.length() == 1)) {
+          // Single character to single character, a character translation
+          std::map<char, char> translations = { { patternStr[0], replaceStr[0] } };
+          TransitionScope transitions(subjectAuto);
+          std::vector<unsigned char> map = translationMap(translations, 1 << num_ascii_track);
+          retMe = new StrangerAutomaton(dfa_map_chars(subjectAuto->dfa, num_ascii_track, indices_main, map.data()));
         } else if (((patternStr.length() == 1) ||  // Single character
                     ((patternStr.length() == 0) && (!patternAuto->isEmpty()))) // Single NULL character (e.g. \x00)
                    && (replaceStr.length() > 0)) { // Not deleting
           std::cout << "Trying: replace_char_with_string: 0x" << std::hex << static_cast<int>(patternStr[0]) << std::dec << " --> " << replaceStr << std::endl;
+          TransitionScope transitions(subjectAuto);
           retMe = new StrangerAutomaton(dfa_replace_char_with_string(subjectAuto->dfa, num_ascii_track, indices_main, patternStr[0], replaceStr.c_str()));
         } else {
           retMe = new StrangerAutomaton(dfa_replace_extrabit(subjectAuto->dfa, patternAuto->dfa, replaceStr.c_str(), num_ascii_track, indices_main));
@@ -1547,7 +1714,7 @@ StrangerAutomaton* StrangerAutomaton::general_replace(const StrangerAutomaton* p
     } else {
         retMe = new StrangerAutomaton(dfa_general_replace_extrabit(subjectAuto->dfa, patternAuto->dfa, replaceAuto->dfa, num_ascii_track, indices_main));
     }
-    perfInfo->replace_total_time += perfInfo->current_time() - start_time;
+    perfInfo->replace_total_time += perfInfo->record_operation("replace", start_time);
     perfInfo->num_of_replace++;
 
     {
@@ -1626,7 +1793,7 @@ StrangerAutomaton* StrangerAutomaton::str_replace(const StrangerAutomaton* searc
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_replace_extrabit(subjectAuto->dfa,searchAuto->dfa, replaceStr.c_str(), num_ascii_track, indices_main));
-    perfInfo->replace_total_time += perfInfo->current_time() - start_time;
+    perfInfo->replace_total_time += perfInfo->record_operation("replace", start_time);
     perfInfo->num_of_replace++;
     
     {
@@ -1665,7 +1832,7 @@ StrangerAutomaton* StrangerAutomaton::str_replace_once(const StrangerAutomaton*
     StrangerAutomaton* retMe = new StrangerAutomaton(
         dfa_replace_once_extrabit(subjectAuto->dfa, str->dfa, replaceStr.c_str(), num_ascii_track, indices_main)
         );
-    perfInfo->replace_total_time += perfInfo->current_time() - start_time;
+    perfInfo->replace_total_time += perfInfo->record_operation("replace", start_time);
     perfInfo->num_of_replace++;
 
     if (retMe->isNull()) {
@@ -1727,7 +1894,7 @@ StrangerAutomaton* StrangerAutomaton::preReplace(const StrangerAutomaton* search
     debugToFile(stringbuilder() << "M[" << (traceID) << "] = dfa_pre_replace_str(M[" << this->autoTraceID << "], M[" << searchAuto->autoTraceID << "], \"" << replaceString << "\" , NUM_ASCII_TRACKS, indices_main);//"<<id << " = preReplace("  << this->ID <<  ", " << searchAuto->ID << ")");
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_replace_str(this->dfa, searchAuto->dfa, replaceString.c_str(), num_ascii_track, indices_main));
-    perfInfo->pre_replace_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_replace_total_time += perfInfo->record_operation("pre_replace", start_time);
     perfInfo->num_of_pre_replace++;
 
     if (retMe->isNull()) {
@@ -1773,7 +1940,7 @@ StrangerAutomaton* StrangerAutomaton::preReplaceOnce(const StrangerAutomaton* se
     debugToFile(stringbuilder() << "M[" << (traceID) << "] = dfa_pre_replace_str(M[" << this->autoTraceID << "], M[" << searchAuto->autoTraceID << "], \"" << replaceString << "\" , NUM_ASCII_TRACKS, indices_main);//"<<id << " = preReplace("  << this->ID <<  ", " << searchAuto->ID << ")");
     boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_replace_once_str(this->dfa, searchAuto->dfa, replaceString.c_str(), num_ascii_track, indices_main));
-    perfInfo->pre_replace_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_replace_total_time += perfInfo->record_operation("pre_replace", start_time);
     perfInfo->num_of_pre_replace++;
 
     if (retMe->isNull()) {
@@ -1872,7 +2039,7 @@ StrangerAutomaton* StrangerAutomaton::restrictLengthByUnaryAutomaton(const Stran
  *            purposes only
  * @return
  */
-bool StrangerAutomaton::checkIntersection(const StrangerAutomaton* otherAuto, int id1, int id2) {
+bool StrangerAutomaton::checkIntersection(const StrangerAutomaton* otherAuto, int id1, int id2) const {
     std::string debugStr = stringbuilder() << "checkIntersection("  << this->ID <<  ", " << otherAuto->ID << ") = ";
     
     if (this->isTop() || otherAuto->isTop()){
@@ -1908,7 +2075,7 @@ bool StrangerAutomaton::checkIntersection(const StrangerAutomaton* otherAuto, in
  * @param auto
  * @return
  */
-bool StrangerAutomaton::checkIntersection(const StrangerAutomaton* otherAuto) {
+bool StrangerAutomaton::checkIntersection(const StrangerAutomaton* otherAuto) const {
     return this->checkIntersection(otherAuto, -1, -1);
 }
 
@@ -2025,6 +2192,18 @@ bool StrangerAutomaton::checkEquivalence(const StrangerAutomaton* otherAuto) con
     return this->checkEquivalence(otherAuto, -1, -1);
 }
 
+/**
+ * Same result as checkEquivalence, but from the product of both
+ * implications. Only kept to compare both in equivbench.
+ */
+bool StrangerAutomaton::checkEquivalenceByProduct(const StrangerAutomaton* otherAuto) const {
+    if (this->isTop() || this->isBottom() || otherAuto->isTop() || otherAuto->isBottom() ||
+        this->isNull() || otherAuto->isNull()) {
+        return this->checkEquivalence(otherAuto);
+    }
+    return check_equivalence_product(this->dfa, otherAuto->dfa, num_ascii_track, indices_main) == 1;
+}
+
 /**
  * returns true (1) if {|w| < n: w elementOf L(M) && n elementOf Integers}
  * In other words length of all strings in the language is bounded by a value n
@@ -2085,6 +2264,21 @@ bool StrangerAutomaton::equals(const StrangerAutomaton* otherAuto) const {
     this->checkEquivalence(otherAuto);
 }
 
+/**
+ * returns a hash of the language of this automaton which is consistent
+ * with equals: equal automata always have the same fingerprint.
+ * Top and bottom only compare equal to themselves in checkEquivalence
+ * so they get their own fixed fingerprints.
+ */
+unsigned long long StrangerAutomaton::getFingerprint() const {
+    if (this->isTop()) {
+        return 1;
+    } else if (this->isBottom()) {
+        return 2;
+    }
+    return dfa_fingerprint(this->dfa);
+}
+
 /**
  * returns true if this auto is empty. i.e. returns true if
  * L(this auto) == phi (empty set)
@@ -2196,8 +2390,9 @@ StrangerAutomaton* StrangerAutomaton::toUpperCase(int id) const
 {
     debug(stringbuilder() << id <<  " = dfaToUpperCase("  << this->ID << ")");
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+	TransitionScope transitions(this);
 	StrangerAutomaton* retMe = new StrangerAutomaton(dfaToUpperCase(this->dfa, num_ascii_track, indices_main));
-	perfInfo->to_uppercase_total_time += perfInfo->current_time() - start_time;
+	perfInfo->to_uppercase_total_time += perfInfo->record_operation("to_uppercase", start_time);
 	perfInfo->number_of_to_uppercase++;
 
     retMe->setID(id);
@@ -2209,8 +2404,9 @@ StrangerAutomaton* StrangerAutomaton::toLowerCase(int id) const
     debug(stringbuilder() << id <<  " = dfaToLowerCase("  << this->ID << ")");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaToLowerCase(this->dfa, num_ascii_track, indices_main));
-	perfInfo->to_lowercase_total_time += perfInfo->current_time() - start_time;
+	perfInfo->to_lowercase_total_time += perfInfo->record_operation("to_lowercase", start_time);
 	perfInfo->number_of_to_lowercase++;
 
     retMe->setID(id);
@@ -2222,8 +2418,9 @@ StrangerAutomaton* StrangerAutomaton::preToUpperCase(int id) const {
     debug(stringbuilder() << id <<  " = dfaPreToUpperCase("  << this->ID << ")");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreToUpperCase(this->dfa, num_ascii_track, indices_main));
-	perfInfo->pre_to_uppercase_total_time += perfInfo->current_time() - start_time;
+	perfInfo->pre_to_uppercase_total_time += perfInfo->record_operation("pre_to_uppercase", start_time);
 	perfInfo->number_of_pre_to_uppercase++;
 
     retMe->setID(id);
@@ -2235,22 +2432,52 @@ StrangerAutomaton* StrangerAutomaton::preToLowerCase(int id) const {
     debug(stringbuilder() << id <<  " = dfaPreToLowerCase("  << this->ID << ")");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreToLowerCase(this->dfa, num_ascii_track, indices_main));
-	perfInfo->pre_to_lowercase_total_time += perfInfo->current_time() - start_time;
+	perfInfo->pre_to_lowercase_total_time += perfInfo->record_operation("pre_to_lowercase", start_time);
 	perfInfo->number_of_pre_to_lowercase++;
 
     retMe->setID(id);
     return retMe;
 }
 
+StrangerAutomaton* StrangerAutomaton::translateChars(const std::map<char, char>& translations, int id) const
+{
+    debug(stringbuilder() << id <<  " = dfa_map_chars("  << this->ID << ")");
+
+    boost::posix_time::ptime start_time = perfInfo->current_time();
+    std::vector<unsigned char> map = translationMap(translations, 1 << num_ascii_track);
+    TransitionScope transitions(this);
+    StrangerAutomaton* retMe = new StrangerAutomaton(dfa_map_chars(this->dfa, num_ascii_track, indices_main, map.data()));
+    perfInfo->record_operation("translate_chars", start_time);
+
+    retMe->setID(id);
+    return retMe;
+}
+
+StrangerAutomaton* StrangerAutomaton::preTranslateChars(const std::map<char, char>& translations, int id) const
+{
+    debug(stringbuilder() << id <<  " = dfa_pre_map_chars("  << this->ID << ")");
+
+    boost::posix_time::ptime start_time = perfInfo->current_time();
+    std::vector<unsigned char> map = translationMap(translations, 1 << num_ascii_track);
+    TransitionScope transitions(this);
+    StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_map_chars(this->dfa, num_ascii_track, indices_main, map.data()));
+    perfInfo->record_operation("pre_translate_chars", start_time);
+
+    retMe->setID(id);
+    return retMe;
+}
+
 StrangerAutomaton* StrangerAutomaton::trimSpaces(int id) const
 {
 
     debug(stringbuilder() << id <<  " = dfaTrim(' ', "  << this->ID << ")");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaTrim(this->dfa, ' ', num_ascii_track, indices_main));
-	perfInfo->trim_spaces_total_time += perfInfo->current_time() - start_time;
+	perfInfo->trim_spaces_total_time += perfInfo->record_operation("trim_spaces", start_time);
 	perfInfo->number_of_trim_spaces++;
     retMe->setID(id);
     return retMe;
@@ -2265,8 +2492,9 @@ StrangerAutomaton* StrangerAutomaton::trimSpacesLeft(int id) const {
     debug(stringbuilder() << id <<  " = dfaLeftTrim(' ', "  << this->ID << ")");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaLeftTrim(this->dfa, ' ', num_ascii_track, indices_main));
-	perfInfo->trim_spaces_left_total_time += perfInfo->current_time() - start_time;
+	perfInfo->trim_spaces_left_total_time += perfInfo->record_operation("trim_spaces_left", start_time);
 	perfInfo->number_of_trim_spaces_left++;
 
     retMe->setID(id);
@@ -2278,8 +2506,9 @@ StrangerAutomaton* StrangerAutomaton::trimSpacesRight(int id) const {
     debug(stringbuilder() << id <<  " = dfaRightTrim(' ', "  << this->ID << ")");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaRightTrim(this->dfa, ' ', num_ascii_track, indices_main));
-	perfInfo->trim_spaces_right_total_time += perfInfo->current_time() - start_time;
+	perfInfo->trim_spaces_right_total_time += perfInfo->record_operation("trim_spaces_right", start_time);
 	perfInfo->number_of_trim_spaces_rigth++;
 
     retMe->setID(id);
@@ -2291,6 +2520,7 @@ StrangerAutomaton* StrangerAutomaton::trim(char c, int id) const {
     debug(stringbuilder() << id <<  " = dfaTrim(" << this->ID << "," << c << ")");
 
 //    boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaTrim(this->dfa, c, num_ascii_track, indices_main));
 
     retMe->setID(id);
@@ -2301,6 +2531,7 @@ StrangerAutomaton* StrangerAutomaton::trimLeft(char c, int id) const {
     debug(stringbuilder() << id <<  " = dfaLeftTrim(" << this->ID << "," << c << ")");
 
 //	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaLeftTrim(this->dfa, c, num_ascii_track, indices_main));
 
 
@@ -2312,6 +2543,7 @@ StrangerAutomaton* StrangerAutomaton::trimRight(char c, int id) const {
     debug(stringbuilder() << id <<  " = dfaRightTrim(" << this->ID << "," << c << ")");
 
 //    boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaRightTrim(this->dfa, c, num_ascii_track, indices_main));
 
     retMe->setID(id);
@@ -2322,8 +2554,9 @@ StrangerAutomaton* StrangerAutomaton::trim(char chars[], int id) const {
     debug(stringbuilder() << id <<  " = dfaTrimSet(" << this->ID << ",chars )\n");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaTrimSet(this->dfa, chars, (int)strlen(chars), num_ascii_track, indices_main));
-	perfInfo->trim_set_total_time += perfInfo->current_time() - start_time;
+	perfInfo->trim_set_total_time += perfInfo->record_operation("trim_set", start_time);
 	perfInfo->number_of_trim_set++;
 
     retMe->setID(id);
@@ -2341,12 +2574,13 @@ StrangerAutomaton* StrangerAutomaton::preTrimSpaces(int id) const
     debug(stringbuilder() << id <<  " = dfaPreTrim(" << this->ID << ",' ')\n");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreTrim(this->dfa, ' ', num_ascii_track, indices_main));
 //    StrangerAutomaton* a1 = new StrangerAutomaton(dfaPreTrim(retMe->dfa, '\n', num_ascii_track, indices_main));
 //    delete retMe;
 //    retMe = new StrangerAutomaton(dfaPreTrim(a1->dfa, '\t', num_ascii_track, indices_main));
 //    delete a1;
-    perfInfo->pre_trim_spaces_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_trim_spaces_total_time += perfInfo->record_operation("pre_trim_spaces", start_time);
 	perfInfo->number_of_pre_trim_spaces++;
 
     retMe->setID(id);
@@ -2360,8 +2594,9 @@ StrangerAutomaton* StrangerAutomaton::preTrimSpacesLeft(int id) const
     debug(stringbuilder() << id <<  " = dfaPreTrimLeft(" << this->ID << ",' ')\n");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreLeftTrim(this->dfa, ' ', num_ascii_track, indices_main));
-	perfInfo->pre_trim_spaces_left_total_time += perfInfo->current_time() - start_time;
+	perfInfo->pre_trim_spaces_left_total_time += perfInfo->record_operation("pre_trim_spaces_left", start_time);
 	perfInfo->number_of_pre_trim_spaces_left++;
 
     retMe->setID(id);
@@ -2373,8 +2608,9 @@ StrangerAutomaton* StrangerAutomaton::preTrimSpacesRigth(int id) const
     debug(stringbuilder() << id <<  " = dfaPreTrim(" << this->ID << ",' ')\n");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(this);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreRightTrim(this->dfa, ' ', num_ascii_track, indices_main));
-	perfInfo->pre_trim_spaces_rigth_total_time += perfInfo->current_time() - start_time;
+	perfInfo->pre_trim_spaces_rigth_total_time += perfInfo->record_operation("pre_trim_spaces_rigth", start_time);
 	perfInfo->number_of_pre_trim_spaces_rigth++;
     retMe->setID(id);
     return retMe;
@@ -2400,7 +2636,7 @@ StrangerAutomaton* StrangerAutomaton::substr(int start, int id) const  {
 
     StrangerAutomaton* retMe = this->substr_first_part(start, id);
 
-    perfInfo->substr_total_time += perfInfo->current_time() - start_time;
+    perfInfo->substr_total_time += perfInfo->record_operation("substr", start_time);
     perfInfo->number_of_substr++;
     return retMe;
 }
@@ -2428,7 +2664,7 @@ StrangerAutomaton* StrangerAutomaton::substr(int start, int length, int id) cons
         delete len2Auto;
         retMe = substring;
     }
-    perfInfo->substr_total_time += perfInfo->current_time() - start_time;
+    perfInfo->substr_total_time += perfInfo->record_operation("substr", start_time);
     perfInfo->number_of_substr++;
     return retMe;
 }
@@ -2461,7 +2697,7 @@ StrangerAutomaton* StrangerAutomaton::pre_substr(int start, int length, int id)
         delete left_side;
         delete left_middle;
     }
-    perfInfo->pre_substr_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_substr_total_time += perfInfo->record_operation("pre_substr", start_time);
     perfInfo->number_of_pre_substr++;
     return retMe;
 }
@@ -2485,7 +2721,7 @@ StrangerAutomaton* StrangerAutomaton::pre_substr(int start, int id) const  {
     retMe = left_side->concatenate(this,id);
     delete left_side;
 
-    perfInfo->pre_substr_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_substr_total_time += perfInfo->record_operation("pre_substr", start_time);
     perfInfo->number_of_pre_substr++;
     return retMe;
 }
@@ -2495,8 +2731,9 @@ StrangerAutomaton* StrangerAutomaton::addslashes(const StrangerAutomaton* subjec
     debug(stringbuilder() << id << " = addSlashes(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaAddSlashes(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->addslashes_total_time += perfInfo->current_time() - start_time;
+    perfInfo->addslashes_total_time += perfInfo->record_operation("addslashes", start_time);
     perfInfo->number_of_addslashes++;
 
 	retMe->ID = id;
@@ -2512,8 +2749,9 @@ StrangerAutomaton* StrangerAutomaton::pre_addslashes(const StrangerAutomaton* su
 	debug(stringbuilder() << id << " = pre_addSlashes(" << subjectAuto->ID << ");");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+	TransitionScope transitions(subjectAuto);
 	StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreAddSlashes(subjectAuto->dfa, num_ascii_track, indices_main));
-	perfInfo->pre_addslashes_total_time += perfInfo->current_time() - start_time;
+	perfInfo->pre_addslashes_total_time += perfInfo->record_operation("pre_addslashes", start_time);
 	perfInfo->number_of_pre_addslashes++;
 
 	retMe->ID = id;
@@ -2527,8 +2765,9 @@ StrangerAutomaton* StrangerAutomaton::encodeAttrString(const StrangerAutomaton*
     debug(stringbuilder() << id << " = encodeAttrString(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaEncodeAttrString(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->encodeattrstring_total_time += perfInfo->current_time() - start_time;
+    perfInfo->encodeattrstring_total_time += perfInfo->record_operation("encodeattrstring", start_time);
     perfInfo->number_of_encodeattrstring++;
 
     retMe->ID = id;
@@ -2542,8 +2781,9 @@ StrangerAutomaton* StrangerAutomaton::pre_encodeAttrString(const StrangerAutomat
     debug(stringbuilder() << id << " = pre_encodeAttrString(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreEncodeAttrString(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->pre_encodeattrstring_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_encodeattrstring_total_time += perfInfo->record_operation("pre_encodeattrstring", start_time);
     perfInfo->number_of_pre_encodeattrstring++;
 
     retMe->ID = id;
@@ -2557,8 +2797,9 @@ StrangerAutomaton* StrangerAutomaton::encodeTextFragment(const StrangerAutomaton
     debug(stringbuilder() << id << " = encodeTextFragment(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaEncodeTextFragment(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->encodetextfragment_total_time += perfInfo->current_time() - start_time;
+    perfInfo->encodetextfragment_total_time += perfInfo->record_operation("encodetextfragment", start_time);
     perfInfo->number_of_encodetextfragment++;
 
     retMe->ID = id;
@@ -2572,8 +2813,9 @@ StrangerAutomaton* StrangerAutomaton::pre_encodeTextFragment(const StrangerAutom
     debug(stringbuilder() << id << " = pre_encodeTextFragment(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreEncodeTextFragment(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->pre_encodetextfragment_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_encodetextfragment_total_time += perfInfo->record_operation("pre_encodetextfragment", start_time);
     perfInfo->number_of_pre_encodetextfragment++;
 
     retMe->ID = id;
@@ -2587,8 +2829,9 @@ StrangerAutomaton* StrangerAutomaton::escapeHtmlTags(const StrangerAutomaton* su
     debug(stringbuilder() << id << " = escapeHtmlTags(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaHtmlEscapeTags(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->escapehtmltags_total_time += perfInfo->current_time() - start_time;
+    perfInfo->escapehtmltags_total_time += perfInfo->record_operation("escapehtmltags", start_time);
     perfInfo->number_of_escapehtmltags++;
 
     retMe->ID = id;
@@ -2602,8 +2845,9 @@ StrangerAutomaton* StrangerAutomaton::pre_escapeHtmlTags(const StrangerAutomaton
     debug(stringbuilder() << id << " = pre_escapeHtmlTags(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreHtmlEscapeTags(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->pre_escapehtmltags_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_escapehtmltags_total_time += perfInfo->record_operation("pre_escapehtmltags", start_time);
     perfInfo->number_of_pre_escapehtmltags++;
 
     retMe->ID = id;
@@ -2611,6 +2855,53 @@ StrangerAutomaton* StrangerAutomaton::pre_escapeHtmlTags(const StrangerAutomaton
     return retMe;
 }
 
+/**
+ * Builds the (1 << num_ascii_track) entry replacement table of escapes for
+ * dfa_replace_chars_with_strings, characters without an escape are NULL.
+ */
+static std::vector<const char*> escapeTable(const std::map<char, std::string>& escapes, size_t size)
+{
+    std::vector<const char*> replacements(size, nullptr);
+    for (auto const& escape : escapes) {
+        replacements[(unsigned char) escape.first] = escape.second.c_str();
+    }
+    return replacements;
+}
+
+StrangerAutomaton* StrangerAutomaton::escapeChars(const StrangerAutomaton* subjectAuto, const std::map<char, std::string>& escapes, int id)
+{
+
+    debug(stringbuilder() << id << " = escapeChars(" << subjectAuto->ID << ");");
+
+    boost::posix_time::ptime start_time = perfInfo->current_time();
+    std::vector<const char*> replacements = escapeTable(escapes, 1 << num_ascii_track);
+    StrangerAutomaton* retMe = new StrangerAutomaton(dfa_replace_chars_with_strings(subjectAuto->dfa, num_ascii_track, indices_main, replacements.data()));
+    perfInfo->record_operation("escape_chars", start_time);
+
+    if (retMe->isNull()) {
+        delete retMe;
+        throw StrangerException(AnalysisError::InvalidArgument, "escapeChars: the escape strings are not prefix free");
+    }
+    retMe->ID = id;
+    retMe->debugAutomaton();
+    return retMe;
+}
+
+StrangerAutomaton* StrangerAutomaton::pre_escapeChars(const StrangerAutomaton* subjectAuto, const std::map<char, std::string>& escapes, int id)
+{
+
+    debug(stringbuilder() << id << " = pre_escapeChars(" << subjectAuto->ID << ");");
+
+    boost::posix_time::ptime start_time = perfInfo->current_time();
+    std::vector<const char*> replacements = escapeTable(escapes, 1 << num_ascii_track);
+    StrangerAutomaton* retMe = new StrangerAutomaton(dfa_pre_replace_chars_with_strings(subjectAuto->dfa, num_ascii_track, indices_main, replacements.data()));
+    perfInfo->record_operation("pre_escape_chars", start_time);
+
+    retMe->ID = id;
+    retMe->debugAutomaton();
+    return retMe;
+}
+
 StrangerAutomaton* StrangerAutomaton::htmlSpecialChars(const StrangerAutomaton* subjectAuto, string flag, int id)
 {
     hscflags_t _flag;
@@ -2628,8 +2919,9 @@ StrangerAutomaton* StrangerAutomaton::htmlSpecialChars(const StrangerAutomaton*
     debug(stringbuilder() << id << " = htmlSpecialChars(" << subjectAuto->ID << ");");
 
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaHtmlSpecialChars(subjectAuto->dfa, num_ascii_track, indices_main, _flag));
-    perfInfo->htmlspecialchars_total_time += perfInfo->current_time() - start_time;
+    perfInfo->htmlspecialchars_total_time += perfInfo->record_operation("htmlspecialchars", start_time);
 	perfInfo->number_of_htmlspecialchars++;
 
 	retMe->ID = id;
@@ -2654,8 +2946,9 @@ StrangerAutomaton* StrangerAutomaton::preHtmlSpecialChars(const StrangerAutomato
 
     debug(stringbuilder() << id << " = preHtmlSpecialChars(" << subjectAuto->ID << ");");
     boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreHtmlSpecialChars(subjectAuto->dfa, num_ascii_track, indices_main, _flag));
-    perfInfo->pre_htmlspecialchars_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_htmlspecialchars_total_time += perfInfo->record_operation("pre_htmlspecialchars", start_time);
     perfInfo->number_of_pre_htmlspecialchars++;
 
     retMe->ID = id;
@@ -2686,7 +2979,7 @@ StrangerAutomaton* StrangerAutomaton::stripslashes(const StrangerAutomaton* subj
     StrangerAutomaton *retMe = notSlashed->union_(slashedPre, id);
     delete slashedPre;
 
-    perfInfo->stripslashes_total_time += perfInfo->current_time() - start_time;
+    perfInfo->stripslashes_total_time += perfInfo->record_operation("stripslashes", start_time);
 	perfInfo->number_of_stripslashes++;
 
 
@@ -2703,7 +2996,7 @@ StrangerAutomaton* StrangerAutomaton::pre_stripslashes(const StrangerAutomaton*
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
     StrangerAutomaton *result = slashed->union_(subjectAuto, id);
-    perfInfo->pre_stripslashes_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_stripslashes_total_time += perfInfo->record_operation("pre_stripslashes", start_time);
 	perfInfo->number_of_pre_stripslashes++;
 
     delete slashed;
@@ -2715,8 +3008,9 @@ StrangerAutomaton* StrangerAutomaton::mysql_escape_string(const StrangerAutomato
     debug(stringbuilder() << id << " = mysql_escape_string(" << subjectAuto->ID << ");");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+    TransitionScope transitions(subjectAuto);
     StrangerAutomaton* retMe = new StrangerAutomaton(dfaMysqlEscapeString(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->mysql_escape_string_total_time += perfInfo->current_time() - start_time;
+    perfInfo->mysql_escape_string_total_time += perfInfo->record_operation("mysql_escape_string", start_time);
 	perfInfo->number_of_mysql_escape_string++;
 
 	retMe->ID = id;
@@ -2729,8 +3023,9 @@ StrangerAutomaton* StrangerAutomaton::pre_mysql_escape_string(const StrangerAuto
 	debug(stringbuilder() << id << " = pre_mysql_escape_string(" << subjectAuto->ID << ");");
 
 	boost::posix_time::ptime start_time = perfInfo->current_time();
+	TransitionScope transitions(subjectAuto);
 	StrangerAutomaton* retMe = new StrangerAutomaton(dfaPreMysqlEscapeString(subjectAuto->dfa, num_ascii_track, indices_main));
-    perfInfo->pre_mysql_escape_string_total_time += perfInfo->current_time() - start_time;
+    perfInfo->pre_mysql_escape_string_total_time += perfInfo->record_operation("pre_mysql_escape_string", start_time);
 	perfInfo->number_of_pre_mysql_escape_string++;
 
 
@@ -3033,13 +3328,19 @@ void StrangerAutomaton::toDotFileAscii(std::string file_name, int printSink) con
 void StrangerAutomaton::exportToFile(const std::string& file_name) const
 {
     if (this->dfa) {
+        const std::lock_guard<std::mutex> lock(io_mutex);
         dfaExportBddTable(this->dfa, file_name.c_str(), num_ascii_track);
     }
 }
 
 StrangerAutomaton* StrangerAutomaton::importFromFile(const std::string& file_name)
 {
-    return new StrangerAutomaton(dfaImportBddTable(file_name.c_str(), num_ascii_track));
+    DFA* dfa = nullptr;
+    {
+        const std::lock_guard<std::mutex> lock(io_mutex);
+        dfa = dfaImportBddTable(file_name.c_str(), num_ascii_track);
+    }
+    return new StrangerAutomaton(dfa);
 }
 
 int StrangerAutomaton::debugLevel = 0;
@@ -34,6 +34,8 @@
 #include "stranger/stranger.h"
 #undef export
 
+#include <map>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -47,6 +49,8 @@ public:
     virtual ~StrangerAutomaton();
     StrangerAutomaton* clone(int id) const;
     StrangerAutomaton* clone() const;
+    StrangerAutomaton* deepClone(int id) const;
+    StrangerAutomaton* deepClone() const;
     int getID() const;
     void setID(int id);
     DFA* getDfa();
@@ -58,6 +62,10 @@ public:
     static StrangerAutomaton* makeString(const std::string& s);
     static StrangerAutomaton* makeContainsString(const std::string& s, int id);
     static StrangerAutomaton* makeContainsString(const std::string& s);
+    // The star-concatenation makeContainsString used before, for containsbench
+    static StrangerAutomaton* makeContainsStringByClosure(const std::string& s);
+    static StrangerAutomaton* makeContainsAnyString(const std::vector<std::string>& strings, int id);
+    static StrangerAutomaton* makeContainsAnyString(const std::vector<std::string>& strings);
     static StrangerAutomaton* makeChar(char c, int id);
     static StrangerAutomaton* makeChar(char c);
     static StrangerAutomaton* makeCharRange(char from, char to, int id);
@@ -143,16 +151,19 @@ public:
     StrangerAutomaton* restrictLengthByUnaryAutomaton(const StrangerAutomaton* uL) const {
         return restrictLengthByUnaryAutomaton(uL, traceID);
     };
-    bool checkIntersection(const StrangerAutomaton* auto_, int id1, int id2);
-    bool checkIntersection(const StrangerAutomaton* auto_);
+    bool checkIntersection(const StrangerAutomaton* auto_, int id1, int id2) const;
+    bool checkIntersection(const StrangerAutomaton* auto_) const;
     bool checkInclusion(const StrangerAutomaton* auto_, int id1, int id2) const;
     bool checkInclusion(const StrangerAutomaton* auto_) const;
     bool checkEquivalence(const StrangerAutomaton* auto_, int id1, int id2) const;
     bool checkEquivalence(const StrangerAutomaton* auto_) const;
+    // The four product construction checkEquivalence used before, for equivbench
+    bool checkEquivalenceByProduct(const StrangerAutomaton* auto_) const;
     bool isLengthFinite() const;
     unsigned getMaxLength() const;
     unsigned getMinLength() const;
     bool equals(const StrangerAutomaton* other) const;
+    unsigned long long getFingerprint() const;
     bool checkEmptiness() const;
     bool isEmpty() const;
     bool isNull() const;
@@ -169,6 +180,12 @@ public:
     StrangerAutomaton* preToUpperCase() const { return preToUpperCase(traceID);};
     StrangerAutomaton* preToLowerCase(int id) const;
     StrangerAutomaton* preToLowerCase() const { return preToLowerCase(traceID);};
+    // Replaces every character with its entry in translations (as strtr
+    // with two strings does), characters without an entry are kept
+    StrangerAutomaton* translateChars(const std::map<char, char>& translations, int id) const;
+    StrangerAutomaton* translateChars(const std::map<char, char>& translations) const { return translateChars(translations, traceID);};
+    StrangerAutomaton* preTranslateChars(const std::map<char, char>& translations, int id) const;
+    StrangerAutomaton* preTranslateChars(const std::map<char, char>& translations) const { return preTranslateChars(translations, traceID);};
     StrangerAutomaton* trimSpaces(int id) const;
     StrangerAutomaton* trimSpacesLeft(int id) const;
     StrangerAutomaton* trimSpacesRight(int id) const;
@@ -229,6 +246,13 @@ public:
     static StrangerAutomaton* pre_escapeHtmlTags(const StrangerAutomaton* subjectAuto, int id);
     static StrangerAutomaton* pre_escapeHtmlTags(const StrangerAutomaton* subjectAuto){return pre_escapeHtmlTags(subjectAuto, traceID);};
 
+    // Replaces every character with an entry in escapes by its escape
+    // string in a single pass, the escape strings must be prefix free
+    static StrangerAutomaton* escapeChars(const StrangerAutomaton* subjectAuto, const std::map<char, std::string>& escapes, int id);
+    static StrangerAutomaton* escapeChars(const StrangerAutomaton* subjectAuto, const std::map<char, std::string>& escapes){return escapeChars(subjectAuto, escapes, traceID);};
+    static StrangerAutomaton* pre_escapeChars(const StrangerAutomaton* subjectAuto, const std::map<char, std::string>& escapes, int id);
+    static StrangerAutomaton* pre_escapeChars(const StrangerAutomaton* subjectAuto, const std::map<char, std::string>& escapes){return pre_escapeChars(subjectAuto, escapes, traceID);};
+
     static StrangerAutomaton* encodeURIComponent(const StrangerAutomaton* subjectAuto, int id);
     static StrangerAutomaton* encodeURIComponent(const StrangerAutomaton* subjectAuto){return encodeURIComponent(subjectAuto, traceID);};
     static StrangerAutomaton* decodeURIComponent(const StrangerAutomaton* subjectAuto, int id);
@@ -278,7 +302,7 @@ public:
         return bdd_size(this->dfa->bddm);
     }
 
-    static PerfInfo* perfInfo;
+    static thread_local PerfInfo* perfInfo;
 
     StrangerAutomaton* restrict(const StrangerAutomaton* otherAuto, int id){
         StrangerAutomaton* retMe = this->intersect(otherAuto);
@@ -329,6 +353,24 @@ public:
     };
     DFA* dfa;
 private:
+    // clones share the DFA, it is freed with the last of them
+    std::shared_ptr<DFA> dfa_ref;
+    // the transitions of the DFA decoded for the function models, built
+    // when the first model is applied and shared with later clones
+    mutable std::shared_ptr<TransitionTable> transitions_ref;
+
+    // Shares the decoded transitions of an automaton with the function
+    // models called by this thread while it is in scope
+    class TransitionScope {
+    public:
+        explicit TransitionScope(const StrangerAutomaton* automaton);
+        ~TransitionScope();
+    private:
+        DFA* dfa;
+        std::shared_ptr<TransitionTable> table;
+    };
+    static DFA* copyDfa(DFA* dfa);
+    static unsigned long dfaBytes(const DFA* dfa);
 
     int ID;
     int autoTraceID;
@@ -256,7 +256,7 @@ StrangerAutomaton* ValidationImageComputer::makePreImageForOpChild_ValidationCas
                 retMe = opAuto->union_(patternAuto, childNode->getID());
             }
 
-            perfInfo->pre_vlab_restrict_total_time += perfInfo->current_time() - start_time;
+            perfInfo->pre_vlab_restrict_total_time += perfInfo->record_operation("pre_vlab_restrict", start_time);
             perfInfo->number_of_pre_vlab_restrict++;
 
         } else {
@@ -409,6 +409,19 @@ StrangerAutomaton* ValidationImageComputer::makePreImageForOpChild_ValidationCas
             throw StrangerException(stringbuilder() << "SNH: child node (" << childNode->getID() << ") of preg_replace (" << opNode->getID() << ") is not in backward path,\ncheck implementation: "
                                                                                                                                                               "makeBackwardAutoForOpChild_ValidationPhase()");
         }
+    } else if (opName == "escape_chars") {
+        // an annotated replace of a character class, see DepGraph::parseStream
+        if (successors.size() != 3 || !childNode->equals(successors[2])) {
+            throw StrangerException(stringbuilder() << "SNH: child node (" << childNode->getID() << ") of escape_chars (" << opNode->getID() << ") is not in backward path");
+        }
+        StrangerAutomaton* sigmaStar = StrangerAutomaton::makeAnyString(opNode->getID());
+        StrangerAutomaton* forward = StrangerAutomaton::escapeChars(sigmaStar, opNode->getEscapes(), opNode->getID());
+        StrangerAutomaton* intersection = opAuto->intersect(forward, childNode->getID());
+        retMe = StrangerAutomaton::pre_escapeChars(intersection, opNode->getEscapes(), childNode->getID());
+        delete sigmaStar;
+        delete forward;
+        delete intersection;
+
     }  else if (opName == "substr"){
 
         if (successors.size() != 3) {
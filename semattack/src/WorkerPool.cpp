@@ -0,0 +1,272 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * WorkerPool.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#include "WorkerPool.hpp"
+#include "StringBuilder.hpp"
+#include "exceptions/StrangerException.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+WorkerPool::WorkerPool(unsigned int workers, Handler handler)
+  : m_mutex()
+  , m_cv()
+  , m_fds(workers, -1)
+  , m_busy(workers, false)
+  , m_spawn_mutex()
+  , m_control(-1)
+  , m_spawner(-1)
+  , m_crashes(0)
+{
+  int control[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, control) != 0) {
+    throw StrangerException(AnalysisError::Other,
+                            stringbuilder() << "Cannot create worker control socket: " << strerror(errno));
+  }
+  std::cout.flush();
+  m_spawner = fork();
+  if (m_spawner < 0) {
+    throw StrangerException(AnalysisError::Other,
+                            stringbuilder() << "Cannot fork worker spawner: " << strerror(errno));
+  }
+  if (m_spawner == 0) {
+    close(control[0]);
+    runSpawner(control[1], handler);
+    _exit(0);
+  }
+  close(control[1]);
+  m_control = control[0];
+  for (unsigned int i = 0; i < workers; i++) {
+    spawn(i);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  // Workers and the spawner exit once their socket is closed
+  for (int fd : m_fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  m_fds.clear();
+  if (m_control >= 0) {
+    close(m_control);
+    m_control = -1;
+  }
+  if (m_spawner > 0) {
+    waitpid(m_spawner, nullptr, 0);
+    m_spawner = -1;
+  }
+}
+
+/**
+ * Creates the socket pair of a worker and hands one end to the spawner,
+ * which forks the worker with it.
+ */
+void WorkerPool::spawn(unsigned int worker)
+{
+  const std::lock_guard<std::mutex> lock(m_spawn_mutex);
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    std::cerr << "Cannot create worker socket: " << strerror(errno) << std::endl;
+    m_fds[worker] = -1;
+    return;
+  }
+  char byte = 0;
+  struct iovec iov = { &byte, 1 };
+  char buf[CMSG_SPACE(sizeof(int))];
+  memset(buf, 0, sizeof(buf));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = buf;
+  msg.msg_controllen = sizeof(buf);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fds[1], sizeof(int));
+  if (sendmsg(m_control, &msg, MSG_NOSIGNAL) != 1) {
+    std::cerr << "Cannot start worker: " << strerror(errno) << std::endl;
+    close(fds[0]);
+    fds[0] = -1;
+  }
+  close(fds[1]);
+  m_fds[worker] = fds[0];
+}
+
+bool WorkerPool::call(const std::string& request, std::string& reply, int preferred, int& worker)
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    int size = m_busy.size();
+    m_cv.wait(lock, [&]() {
+      if (preferred >= 0 && preferred < size) {
+        return !m_busy[preferred];
+      }
+      for (int i = 0; i < size; i++) {
+        if (!m_busy[i]) {
+          return true;
+        }
+      }
+      return false;
+    });
+    worker = preferred;
+    if (worker < 0 || worker >= size) {
+      for (worker = 0; m_busy[worker]; worker++) {
+      }
+    }
+    m_busy[worker] = true;
+  }
+
+  int fd = m_fds[worker];
+  bool replied = (fd >= 0) && sendFrame(fd, request) && receiveFrame(fd, reply);
+  if (!replied) {
+    // The worker is gone, the request goes down with it
+    m_crashes++;
+    if (fd >= 0) {
+      close(fd);
+    }
+    spawn(worker);
+  }
+
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_busy[worker] = false;
+  }
+  m_cv.notify_all();
+  return replied;
+}
+
+void WorkerPool::runSpawner(int control, const Handler& handler)
+{
+  // Workers are reaped automatically, the pool notices their death on
+  // their socket
+  signal(SIGCHLD, SIG_IGN);
+  while (true) {
+    char byte;
+    struct iovec iov = { &byte, 1 };
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+    if (recvmsg(control, &msg, 0) <= 0) {
+      break;
+    }
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(control);
+      signal(SIGCHLD, SIG_DFL);
+      runWorker(fd, handler);
+      std::cout.flush();
+      _exit(0);
+    }
+    close(fd);
+  }
+  close(control);
+}
+
+void WorkerPool::runWorker(int fd, const Handler& handler)
+{
+  std::string request;
+  while (receiveFrame(fd, request)) {
+    std::string reply = handler(request);
+    std::cout.flush();
+    if (!sendFrame(fd, reply)) {
+      break;
+    }
+  }
+  close(fd);
+}
+
+/**
+ * Frames are the length followed by the data, both ends run on the same
+ * machine so the length is sent in host byte order.
+ */
+bool WorkerPool::sendFrame(int fd, const std::string& data)
+{
+  uint64_t size = data.size();
+  std::string frame(reinterpret_cast<const char*>(&size), sizeof(size));
+  frame += data;
+  const char* pos = frame.data();
+  size_t left = frame.size();
+  while (left > 0) {
+    ssize_t sent = send(fd, pos, left, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    pos += sent;
+    left -= sent;
+  }
+  return true;
+}
+
+bool WorkerPool::receiveFrame(int fd, std::string& data)
+{
+  uint64_t size = 0;
+  char* pos = reinterpret_cast<char*>(&size);
+  size_t left = sizeof(size);
+  bool header = true;
+  while (true) {
+    while (left > 0) {
+      ssize_t received = recv(fd, pos, left, 0);
+      if (received < 0 && errno == EINTR) {
+        continue;
+      }
+      if (received <= 0) {
+        return false;
+      }
+      pos += received;
+      left -= received;
+    }
+    if (!header) {
+      return true;
+    }
+    header = false;
+    data.assign(size, '\0');
+    pos = &data[0];
+    left = size;
+  }
+}
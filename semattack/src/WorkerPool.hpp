@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * WorkerPool.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef WORKER_POOL_HPP_
+#define WORKER_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+// Handles requests in forked worker processes, so an assertion or a crash
+// in MONA only loses the request which caused it. The workers are forked
+// by a spawner process which is created before any other thread is
+// started, so every worker, including the replacement of a crashed one,
+// starts from that state. Requests and replies are strings sent over a
+// socket pair per worker, their fields are written with FieldCodec.
+class WorkerPool {
+
+public:
+  // Runs in the worker, turns a request into a reply
+  typedef std::function<std::string(const std::string&)> Handler;
+
+  WorkerPool(unsigned int workers, Handler handler);
+  ~WorkerPool();
+
+  // Sends the request to a free worker, to the preferred one if it is
+  // given. Returns false if the worker died before replying, it has been
+  // replaced by a new one when this returns. worker is set to the worker
+  // which took the request.
+  bool call(const std::string& request, std::string& reply, int preferred, int& worker);
+
+  unsigned int getSize() const { return m_fds.size(); }
+  unsigned int getCrashes() const { return m_crashes; }
+
+private:
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  void spawn(unsigned int worker);
+
+  static void runSpawner(int control, const Handler& handler);
+  static void runWorker(int fd, const Handler& handler);
+  static bool sendFrame(int fd, const std::string& data);
+  static bool receiveFrame(int fd, std::string& data);
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::vector<int> m_fds;
+  std::vector<bool> m_busy;
+  std::mutex m_spawn_mutex;
+  int m_control;
+  pid_t m_spawner;
+  std::atomic<unsigned int> m_crashes;
+};
+
+#endif /* WORKER_POOL_HPP_ */
@@ -0,0 +1,218 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * CompactDepGraph.cpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#include "CompactDepGraph.hpp"
+#include "DepGraph.hpp"
+
+#include <climits>
+#include <utility>
+
+CompactDepGraph::CompactDepGraph(const DepGraph& graph)
+  : m_nodes()
+  , m_dense_index()
+  , m_sparse_index()
+  , m_succ_offsets()
+  , m_succ()
+  , m_pred_offsets()
+  , m_pred()
+  , m_scc_id()
+  , m_sccs()
+{
+  int n = graph.nodes.size();
+  m_nodes.reserve(n);
+  // node ids of parsed graphs are small and dense
+  m_dense_index.assign(2 * n + 64, -1);
+  for (auto& entry : graph.nodes) {
+    int id = entry.first;
+    if (id >= 0 && id < (int) m_dense_index.size()) {
+      m_dense_index[id] = m_nodes.size();
+    } else {
+      m_sparse_index[id] = m_nodes.size();
+    }
+    m_nodes.push_back(entry.second);
+  }
+
+  // Forward adjacency, in edge order
+  m_succ_offsets.assign(n + 1, 0);
+  std::vector<int> pred_count(n, 0);
+  for (auto& entry : graph.edges) {
+    int from = indexOf(entry.first);
+    m_succ_offsets[from + 1] = entry.second.size();
+  }
+  for (int i = 0; i < n; i++) {
+    m_succ_offsets[i + 1] += m_succ_offsets[i];
+  }
+  m_succ.resize(m_succ_offsets[n]);
+  for (auto& entry : graph.edges) {
+    int from = indexOf(entry.first);
+    int pos = m_succ_offsets[from];
+    for (auto to : entry.second) {
+      m_succ[pos++] = indexOf(to);
+    }
+  }
+
+  // Reverse adjacency, a predecessor is listed once even with parallel edges
+  std::vector<int> last_pred(n, -1);
+  for (int from = 0; from < n; from++) {
+    for (const int* it = succBegin(from); it != succEnd(from); ++it) {
+      if (last_pred[*it] != from) {
+        last_pred[*it] = from;
+        pred_count[*it]++;
+      }
+    }
+  }
+  m_pred_offsets.assign(n + 1, 0);
+  for (int i = 0; i < n; i++) {
+    m_pred_offsets[i + 1] = m_pred_offsets[i] + pred_count[i];
+  }
+  m_pred.resize(m_pred_offsets[n]);
+  std::vector<int> fill(m_pred_offsets.begin(), m_pred_offsets.end() - 1);
+  last_pred.assign(n, -1);
+  for (int from = 0; from < n; from++) {
+    for (const int* it = succBegin(from); it != succEnd(from); ++it) {
+      if (last_pred[*it] != from) {
+        last_pred[*it] = from;
+        m_pred[fill[*it]++] = from;
+      }
+    }
+  }
+
+  calculateSCCs();
+}
+
+int CompactDepGraph::indexOf(int id) const
+{
+  if (id >= 0 && id < (int) m_dense_index.size()) {
+    return m_dense_index[id];
+  }
+  auto search = m_sparse_index.find(id);
+  return (search != m_sparse_index.end()) ? search->second : -1;
+}
+
+std::vector<DepGraphNode*> CompactDepGraph::getSuccessors(const DepGraphNode* node) const
+{
+  std::vector<DepGraphNode*> retMe;
+  int index = indexOf(node);
+  if (index >= 0) {
+    retMe.reserve(succEnd(index) - succBegin(index));
+    for (const int* it = succBegin(index); it != succEnd(index); ++it) {
+      retMe.push_back(m_nodes[*it]);
+    }
+  }
+  return retMe;
+}
+
+std::vector<DepGraphNode*> CompactDepGraph::getPredecessors(const DepGraphNode* node) const
+{
+  std::vector<DepGraphNode*> retMe;
+  int index = indexOf(node);
+  if (index >= 0) {
+    retMe.reserve(predEnd(index) - predBegin(index));
+    for (const int* it = predBegin(index); it != predEnd(index); ++it) {
+      retMe.push_back(m_nodes[*it]);
+    }
+  }
+  return retMe;
+}
+
+/**
+ * Tarjan's algorithm with an explicit stack of dfs frames, so deep graphs
+ * do not overflow the call stack. Nodes are visited in the same order as
+ * the recursive version in DepGraph used to, which gives the same
+ * component ids and member order.
+ */
+void CompactDepGraph::calculateSCCs()
+{
+  int n = size();
+  std::vector<int> lowlink(n, 0);
+  std::vector<char> used(n, 0);
+  std::vector<char> is_component_root(n, 0);
+  std::vector<int> process_stack;
+  // node and position of its next successor
+  std::vector<std::pair<int, int> > frames;
+  int time_count = 0;
+
+  m_scc_id.assign(n, -1);
+  for (int start = 0; start < n; start++) {
+    if (used[start]) {
+      continue;
+    }
+    frames.push_back(std::make_pair(start, m_succ_offsets[start]));
+    lowlink[start] = time_count++;
+    used[start] = 1;
+    is_component_root[start] = 1;
+    process_stack.push_back(start);
+
+    while (!frames.empty()) {
+      int u = frames.back().first;
+      int pos = frames.back().second;
+      if (pos < m_succ_offsets[u + 1]) {
+        int v = m_succ[pos];
+        if (!used[v]) {
+          // descend, the edge is finished when v returns
+          frames.push_back(std::make_pair(v, m_succ_offsets[v]));
+          lowlink[v] = time_count++;
+          used[v] = 1;
+          is_component_root[v] = 1;
+          process_stack.push_back(v);
+          continue;
+        }
+        if (lowlink[u] > lowlink[v]) {
+          lowlink[u] = lowlink[v];
+          is_component_root[u] = 0;
+        }
+        frames.back().second++;
+        continue;
+      }
+
+      frames.pop_back();
+      if (is_component_root[u]) {
+        std::vector<int> component;
+        int k;
+        do {
+          k = process_stack.back();
+          process_stack.pop_back();
+          component.push_back(k);
+          lowlink[k] = INT_MAX;
+        } while (k != u);
+        // only keep the components with more than one node
+        if (component.size() > 1) {
+          int scc_id = m_nodes[u]->getID();
+          for (int member : component) {
+            m_scc_id[member] = scc_id;
+          }
+          m_sccs[scc_id] = component;
+        }
+      }
+      if (!frames.empty()) {
+        int parent = frames.back().first;
+        if (lowlink[parent] > lowlink[u]) {
+          lowlink[parent] = lowlink[u];
+          is_component_root[parent] = 0;
+        }
+        frames.back().second++;
+      }
+    }
+  }
+}
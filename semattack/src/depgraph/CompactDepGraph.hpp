@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * CompactDepGraph.hpp
+ *
+ * Copyright (C) 2022 SAP SE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+#ifndef COMPACT_DEPGRAPH_HPP_
+#define COMPACT_DEPGRAPH_HPP_
+
+#include <map>
+#include <vector>
+
+#include "DepGraphNode.hpp"
+
+class DepGraph;
+
+// Immutable compressed sparse row copy of the edges of a DepGraph with
+// forward and reverse adjacency. Nodes are numbered densely in the order of
+// their ids; successors keep the order of the edges (operand order), the
+// predecessors of a node are listed once each, in the order of their ids.
+class CompactDepGraph {
+
+public:
+  explicit CompactDepGraph(const DepGraph& graph);
+
+  int size() const { return (int) m_nodes.size(); }
+
+  // Dense index of a node id, or -1 if the node is not in the graph
+  int indexOf(int id) const;
+  int indexOf(const DepGraphNode* node) const { return indexOf(node->getID()); }
+  DepGraphNode* nodeAt(int index) const { return m_nodes[index]; }
+
+  const int* succBegin(int index) const { return m_succ.data() + m_succ_offsets[index]; }
+  const int* succEnd(int index) const { return m_succ.data() + m_succ_offsets[index + 1]; }
+  const int* predBegin(int index) const { return m_pred.data() + m_pred_offsets[index]; }
+  const int* predEnd(int index) const { return m_pred.data() + m_pred_offsets[index + 1]; }
+
+  std::vector<DepGraphNode*> getSuccessors(const DepGraphNode* node) const;
+  std::vector<DepGraphNode*> getPredecessors(const DepGraphNode* node) const;
+
+  // Components with more than one node, identified by the id of the node
+  // where Tarjan's algorithm found them
+  int getSCCID(int index) const { return m_scc_id[index]; }
+  bool isSCCElement(int index) const { return m_scc_id[index] >= 0; }
+  const std::map<int, std::vector<int> >& getSCCs() const { return m_sccs; }
+
+private:
+  void calculateSCCs();
+
+  std::vector<DepGraphNode*> m_nodes;
+  // ids in [0, m_dense_index.size()) are looked up directly
+  std::vector<int> m_dense_index;
+  std::map<int, int> m_sparse_index;
+
+  std::vector<int> m_succ_offsets;
+  std::vector<int> m_succ;
+  std::vector<int> m_pred_offsets;
+  std::vector<int> m_pred;
+
+  std::vector<int> m_scc_id;
+  std::map<int, std::vector<int> > m_sccs;
+};
+
+#endif /* COMPACT_DEPGRAPH_HPP_ */
@@ -25,6 +25,8 @@
 
 #include "DepGraph.hpp"
 #include "RegExpNode.hpp"
+#include <cctype>
+#include <cstring>
 using namespace std;
 
 DepGraph::DepGraph() : metadata() {
@@ -47,6 +49,7 @@ DepGraph::DepGraph(const DepGraph& other)  : metadata(other.metadata) {
     this->labelloc = other.labelloc;
     this->scc_components = other.scc_components;
     this->scc_map = other.scc_map;
+    this->compact = other.compact;
 }
 
 DepGraph& DepGraph::operator=(const DepGraph &other) {
@@ -62,6 +65,7 @@ DepGraph& DepGraph::operator=(const DepGraph &other) {
     this->scc_components = other.scc_components;
     this->scc_map = other.scc_map;
     this->metadata = other.metadata;
+    this->compact = other.compact;
     return *this;
 }
 
@@ -74,31 +78,18 @@ int DepGraph::currentSccID = 0;
 int DepGraph::currentOrder = 0;
 
 NodesList DepGraph::getPredecessors(const DepGraphNode* node) const {
-    NodesList retMe;
-	for (EdgesMapConstIterator it = edges.begin(); it != edges.end(); ++it) {
-		const DepGraphNode* from = it->first;
-		NodesList toList = it->second;
-		NodesListIterator it2 = std::find_if(toList.begin(), toList.end(), std::bind2nd(NodeEqual(), node));
-		if (it2 != toList.end()) {
-			retMe.push_back(const_cast<DepGraphNode*>(from));
-		}
-	}
-	return retMe;
+	return getCompactGraph().getPredecessors(node);
 }
 
 NodesList DepGraph::getSuccessors(const DepGraphNode* node) const {
-    NodesList retMe;
-	EdgesMapConstIterator it = edges.find(node);
-	if (it != edges.end()) {
-		NodesList toList = it->second;
-        retMe = NodesList(toList.size());
-        copy(toList.begin(), toList.end(), retMe.begin());
-//		for (NodesListConstIterator it2 = toList.begin(); it2 != toList.end(); ++it2){
-//			const DepGraphNode* pNode = *it2;
-//			retMe.push_back(pNode);
-//		}
+	return getCompactGraph().getSuccessors(node);
+}
+
+const CompactDepGraph& DepGraph::getCompactGraph() const {
+	if (!compact) {
+		compact = std::make_shared<const CompactDepGraph>(*this);
 	}
-	return retMe;
+	return *compact;
 }
 
 OpNodesList DepGraph::getFuncsNodes(const std::vector<std::string> funcsNames) {
@@ -210,6 +201,7 @@ void DepGraph::addEdge(DepGraphNode* from, DepGraphNode* to) {
 		throw runtime_error("Adding an edge with from/to that does not exist before");
 	}
 	this->edges[from].push_back(to);
+	this->compact.reset();
 }
 
 //  *********************************************************************************
@@ -221,6 +213,7 @@ DepGraphNode* DepGraph::addNode(DepGraphNode* node) {
 		throw runtime_error(stringbuilder() << "Can not add Node with ID " << node->getID() << " to dep graph. It already exists.");
 	}
 	this->nodes[node->getID()] = node;
+	this->compact.reset();
 	return node;
 }
 
@@ -237,18 +230,38 @@ bool DepGraph::containsNode(const DepGraphNode* node) {
 	return (it != nodes.end());
 }
 
+/**
+ * Replaces every non-overlapping occurrence of search in str, scanning
+ * left to right (same semantics as boost::regex_replace on a literal).
+ */
+static void replaceLiteral(std::string& str, const std::string& search, const std::string& replace)
+{
+    std::string::size_type pos = str.find(search);
+    if (pos == std::string::npos)
+        return;
+    std::string result;
+    result.reserve(str.size());
+    std::string::size_type last = 0;
+    while (pos != std::string::npos) {
+        result.append(str, last, pos - last);
+        result.append(replace);
+        last = pos + search.size();
+        pos = str.find(search, last);
+    }
+    result.append(str, last, std::string::npos);
+    str.swap(result);
+}
+
 std::string DepGraph::escapeLiteral(const std::string& litValue)
 {
     std::string result = litValue;
     //if we are not parsing a regular expression then remove escaping
     //surprisingly, dot special chars (\,") are also special to our
     // regular expression engine
-    static boost::regex bsDQuote("\\\\\"");//this will match \"
-    std::string newStr = "\"";
-    result = boost::regex_replace(result, bsDQuote, newStr);
-    static boost::regex bsBs("\\\\\\\\");//this will match \\ (do not remove this text. Really unless you remove the two backslashes)
-    newStr = "\\";
-    result = boost::regex_replace(result, bsBs, newStr);
+    //this will replace \" by "
+    replaceLiteral(result, "\\\"", "\"");
+    //this will replace \\ by a single backslash
+    replaceLiteral(result, "\\\\", "\\");
     return result;
 }
 
@@ -274,91 +287,321 @@ DepGraph DepGraph::parseString(const std::string& str) {
     return DepGraph::parseStream(ss);
 }
 
+/*
+ * Hand-written matchers for the line grammar produced by the dot exporter.
+ * Each of them accepts exactly the strings the former boost::regex
+ * expressions accepted, noted above every function, but without
+ * backtracking or allocating match results.
+ */
+
+// \s
+static inline bool isDotSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// \d
+static inline bool isDotDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// [\.\w]
+static inline bool isMetadataKeyChar(char c)
+{
+    return c == '.' || c == '_' || std::isalnum(static_cast<unsigned char>(c));
+}
+
+static inline bool startsWith(const std::string& str, const char* prefix, std::string::size_type len)
+{
+    return str.size() >= len && str.compare(0, len, prefix, len) == 0;
+}
+
+static inline bool endsWith(const std::string& str, const char* suffix, std::string::size_type len)
+{
+    return str.size() >= len && str.compare(str.size() - len, len, suffix, len) == 0;
+}
+
+/**
+ * Matches "n(\d+)" at pos, storing the start and length of the digits.
+ * Returns the position after the digits or npos.
+ */
+static std::string::size_type matchNodeRef(const std::string& line, std::string::size_type pos,
+                                           std::string::size_type& numStart, std::string::size_type& numLen)
+{
+    if (pos >= line.size() || line[pos] != 'n')
+        return std::string::npos;
+    numStart = ++pos;
+    while (pos < line.size() && isDotDigit(line[pos]))
+        pos++;
+    numLen = pos - numStart;
+    return numLen == 0 ? std::string::npos : pos;
+}
+
+/**
+ * ^\s*n(\d+)\s\[(.*)\];$
+ */
+static bool matchNodeLine(const std::string& line, int& nodeID, std::string& description)
+{
+    std::string::size_type pos = 0, numStart, numLen;
+    while (pos < line.size() && isDotSpace(line[pos]))
+        pos++;
+    pos = matchNodeRef(line, pos, numStart, numLen);
+    if (pos == std::string::npos || pos + 1 >= line.size() || !isDotSpace(line[pos]) || line[pos + 1] != '[')
+        return false;
+    pos += 2;
+    if (line.size() < pos + 2 || !endsWith(line, "];", 2))
+        return false;
+    nodeID = std::stoi(line.substr(numStart, numLen)) - 1;
+    description.assign(line, pos, line.size() - 2 - pos);
+    return true;
+}
+
+/**
+ * ^\s*n(\d+)\s->\sn(\d+)(\[(.*)\])?;$
+ */
+static bool matchEdgeLine(const std::string& line, int& fromNodeID, int& toNodeID)
+{
+    std::string::size_type pos = 0, fromStart, fromLen, toStart, toLen;
+    while (pos < line.size() && isDotSpace(line[pos]))
+        pos++;
+    pos = matchNodeRef(line, pos, fromStart, fromLen);
+    if (pos == std::string::npos || pos + 4 > line.size() || !isDotSpace(line[pos])
+        || line[pos + 1] != '-' || line[pos + 2] != '>' || !isDotSpace(line[pos + 3]))
+        return false;
+    pos = matchNodeRef(line, pos + 4, toStart, toLen);
+    if (pos == std::string::npos)
+        return false;
+    std::string::size_type rest = line.size() - pos;
+    if (!(rest == 1 && line[pos] == ';') && !(rest >= 3 && line[pos] == '[' && endsWith(line, "];", 2)))
+        return false;
+    fromNodeID = std::stoi(line.substr(fromStart, fromLen)) - 1;
+    toNodeID = std::stoi(line.substr(toStart, toLen)) - 1;
+    return true;
+}
+
+/**
+ * shape=(.+), label="(.+)"
+ * The greedy shape group ends at the last ", label=\"" that still leaves a
+ * non-empty label.
+ */
+static bool matchNodeDescription(const std::string& description, std::string& shape, std::string& label)
+{
+    static const char labelKey[] = ", label=\"";
+    static const std::string::size_type labelKeyLen = sizeof(labelKey) - 1;
+    const std::string::size_type len = description.size();
+    if (!startsWith(description, "shape=", 6) || len < 6 + 1 + labelKeyLen + 2 || description[len - 1] != '"')
+        return false;
+    std::string::size_type pos = description.rfind(labelKey, len - 2 - labelKeyLen, labelKeyLen);
+    if (pos == std::string::npos || pos < 7)
+        return false;
+    shape.assign(description, 6, pos - 6);
+    label.assign(description, pos + labelKeyLen, len - 1 - pos - labelKeyLen);
+    return true;
+}
+
+/**
+ * Matches "<prefix>(.+)" (or "<prefix>(.*)" if allowEmpty) against the
+ * whole label and stores the group in value.
+ */
+static bool matchLabel(const std::string& label, const char* prefix, bool allowEmpty, std::string& value)
+{
+    const std::string::size_type len = std::strlen(prefix);
+    if (!startsWith(label, prefix, len) || (!allowEmpty && label.size() == len))
+        return false;
+    value.assign(label, len, std::string::npos);
+    return true;
+}
+
+/**
+ * ^//[^$]*$ followed by ^// ([\.\w]+): (.+)
+ * Comments containing a '$' anywhere are not treated as metadata.
+ */
+static bool matchMetadataLine(const std::string& line, std::string& key, std::string& value)
+{
+    if (!startsWith(line, "// ", 3) || line.find('$') != std::string::npos)
+        return false;
+    std::string::size_type pos = 3;
+    while (pos < line.size() && isMetadataKeyChar(line[pos]))
+        pos++;
+    if (pos == 3 || pos + 2 >= line.size() || line[pos] != ':' || line[pos + 1] != ' ')
+        return false;
+    key.assign(line, 3, pos - 3);
+    value.assign(line, pos + 2, std::string::npos);
+    return true;
+}
+
+/**
+ * (.): (\d+)(, (.): (\d+))*
+ * The characters escaped by a function replacer, those with a count of zero
+ * are left out. Fails on keys longer than one character.
+ */
+static bool matchEscapedChars(const std::string& list, std::string& chars)
+{
+    std::string::size_type pos = 0;
+    chars.clear();
+    while (pos + 3 < list.size() && list[pos + 1] == ':' && list[pos + 2] == ' ' && isDotDigit(list[pos + 3])) {
+        char c = list[pos];
+        std::string::size_type digits = pos + 3;
+        pos = digits;
+        while (pos < list.size() && isDotDigit(list[pos]))
+            pos++;
+        if (list.find_first_not_of('0', digits) < pos)
+            chars += c;
+        if (pos == list.size())
+            return !chars.empty();
+        if (list.compare(pos, 2, ", ") != 0)
+            return false;
+        pos += 2;
+    }
+    return false;
+}
+
+/**
+ * ^// Approximated Implementation for: +replace\((\[.+\])/g: 1, .* \[escapes\((.*)\), function_rhs: true\].*$
+ * A global replace of a character class with a function replacer, whose
+ * lookup table is not part of the dot file. pattern is set to the regular
+ * expression literal of the class, "/[...]/".
+ */
+static bool matchEscapesLine(const std::string& line, std::string& pattern, std::string& chars)
+{
+    static const char prefix[] = "// Approximated Implementation for: ";
+    static const std::string::size_type prefixLen = sizeof(prefix) - 1;
+    if (!startsWith(line, prefix, prefixLen))
+        return false;
+    std::string::size_type pos = line.find_first_not_of(' ', prefixLen);
+    if (pos == std::string::npos || line.compare(pos, 8, "replace(") != 0)
+        return false;
+    pos += 8;
+    std::string::size_type end = line.find("/g: 1, ", pos);
+    if (end == std::string::npos || end < pos + 2 || line[pos] != '[' || line[end - 1] != ']')
+        return false;
+    std::string::size_type list = line.find(" [escapes(", end);
+    if (list == std::string::npos)
+        return false;
+    list += 10;
+    std::string::size_type listEnd = line.find("), function_rhs: true]", list);
+    if (listEnd == std::string::npos || !matchEscapedChars(line.substr(list, listEnd - list), chars))
+        return false;
+    pattern = "/" + line.substr(pos, end - pos) + "/";
+    return true;
+}
+
+/**
+ * The escape strings of the characters escaped by an annotated replacer.
+ * The lookup table is not in the dot file, so only replacers whose
+ * characters all belong to a known table are modelled: those escaping <, >
+ * or & and otherwise only "'`/= produce HTML entities, those escaping only
+ * !'()* the percent encoding of RFC 3986. Returns false for all others,
+ * which keep their approximation. Both sets of strings are prefix free.
+ */
+static bool escapeStrings(const std::string& chars, std::map<char, std::string>& escapes)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    bool html = chars.find_first_of("<>&") != std::string::npos
+        && chars.find_first_not_of("<>&\"'`/=") == std::string::npos;
+    bool uri = chars.find_first_of("!()*") != std::string::npos
+        && chars.find_first_not_of("!'()*") == std::string::npos;
+    if (!html && !uri)
+        return false;
+    escapes.clear();
+    for (char c : chars) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (html) {
+            switch (c) {
+            case '<': escapes[c] = "&lt;"; break;
+            case '>': escapes[c] = "&gt;"; break;
+            case '&': escapes[c] = "&amp;"; break;
+            case '"': escapes[c] = "&quot;"; break;
+            default: escapes[c] = "&#" + std::to_string(u) + ";"; break;
+            }
+        } else {
+            escapes[c] = std::string("%") + hex[u >> 4] + hex[u & 0xf];
+        }
+    }
+    return true;
+}
+
+/**
+ * Turns the preg_replace ops approximating an annotated replacer, those
+ * replacing its character class with the empty literal, into escape_chars
+ * ops.
+ */
+static void useEscapeStrings(DepGraph& depGraph, const std::map<std::string, std::string>& escapedChars)
+{
+    for (DepGraphNode* node : depGraph.getNodes()) {
+        DepGraphOpNode* opNode = dynamic_cast<DepGraphOpNode*>(node);
+        if (opNode == nullptr || opNode->getName() != "preg_replace")
+            continue;
+        NodesList successors = depGraph.getSuccessors(opNode);
+        if (successors.size() != 3)
+            continue;
+        const DepGraphNormalNode* patternNode = dynamic_cast<const DepGraphNormalNode*>(successors[0]);
+        const DepGraphNormalNode* replaceNode = dynamic_cast<const DepGraphNormalNode*>(successors[1]);
+        if (patternNode == nullptr || replaceNode == nullptr
+            || dynamic_cast<RegExpNode*>(patternNode->getPlace()) == nullptr
+            || dynamic_cast<Literal*>(replaceNode->getPlace()) == nullptr
+            || !replaceNode->getPlace()->toString().empty())
+            continue;
+        auto it = escapedChars.find(patternNode->getPlace()->toString());
+        std::map<char, std::string> escapes;
+        if (it != escapedChars.end() && escapeStrings(it->second, escapes))
+            opNode->setEscapes(escapes);
+    }
+}
+
 DepGraph DepGraph::parseStream(std::istream &stream) {
     DepGraph depGraph;
 
     cout << endl << "\t------ inside parseStream :) " <<  " ------" << endl;
     // This is how a node line looks like
     //  n18 [shape=box, label="/home/muath/pixy_output/test/vuln01.php : 13\nVar: $www\nFunc: _main\nID: 17, SCCID: -1, order: -1\n\n"];
-    boost::smatch sm;
-    boost::regex regxNode("^\\s*n(\\d+)\\s\\[(.*)\\];$");
-    boost::regex regxEdge("^\\s*n(\\d+)\\s->\\sn(\\d+)(\\[(.*)\\])?;$");
-    //second group of regex node
-    boost::regex regxNodeDescription("shape=(.+), label=\"(.+)\"");
-    //second group of regex nodeDescription
-    boost::regex regxNodeUninit("Input: (.+)");
-    boost::regex regxNodeReturn("Return: (.+)");
-    boost::regex regxNodeVar("Var: (.+)");
-    boost::regex regxNodeLit("Lit: (.*)");
-    boost::regex regxNodeRegExp("RegExp: (.*)");
-    boost::regex regxNodeOp("(.+)");
-    boost::regex regxStrangerRegEx("/(.+)/");
-    boost::regex regxComment("^//[^$]*$");
-    boost::regex regxMetadata("^// ([\\.\\w]+): (.+)");
-    string nodeName;
+    // Lines are matched one at a time and never buffered, so memory does not
+    // grow with the size of the file.
     string nodeDescription;
-    string edge;
     int nodeID;
     int fromNodeID;
     int toNodeID;
-    string nodeType;
     string nodeLabel;
     string nodeShape;
     string varName;
     string litValue;
-    string opName;        
+    string key;
+    string value;
     string inputLine;
+    string pattern;
+    string chars;
+    // Class patterns of the annotated replacers with their escaped characters
+    map<string, string> escapedChars;
 
-    std::stringstream cout_local;
-    
     while (stream.good()) {
         getline(stream, inputLine);
-        cout_local << "\t parsing : " << inputLine << endl;
-        if (boost::regex_match(inputLine, sm, regxNode)){
+        if (matchNodeLine(inputLine, nodeID, nodeDescription)) {
 
             //process node
-            nodeID = std::stoi(sm[1]) - 1;
-            nodeDescription = sm[2];
-
-            if (boost::regex_match(nodeDescription, sm, regxNodeDescription)) {
-                nodeShape = sm[1];
-                nodeLabel = sm[2];
+            if (matchNodeDescription(nodeDescription, nodeShape, nodeLabel)) {
                 DepGraphNode* node = NULL;
-                if (boost::regex_match(nodeLabel, sm, regxNodeUninit)){
+                if (startsWith(nodeLabel, "Input: ", 7) && nodeLabel.size() > 7) {
                     node = new DepGraphUninitNode(nodeID, -1, -1);
                     depGraph.addNode(node);
-                } else if (boost::regex_match(nodeLabel, sm, regxNodeVar)){
-                    varName = sm[1];
-                    TacPlace* place = new Variable(varName, "noFunc");
-                    node = new DepGraphNormalNode("noFile", -1, nodeID, -1, -1, place);
-                    depGraph.addNode(node);
-                } else if (boost::regex_match(nodeLabel, sm, regxNodeReturn)){
-                    varName = sm[1];
+                } else if (matchLabel(nodeLabel, "Var: ", false, varName)
+                           || matchLabel(nodeLabel, "Return: ", false, varName)) {
                     TacPlace* place = new Variable(varName, "noFunc");
                     node = new DepGraphNormalNode("noFile", -1, nodeID, -1, -1, place);
                     depGraph.addNode(node);
-                } else if (boost::regex_match(nodeLabel, sm, regxNodeRegExp)){
-                    litValue = sm[1];
-                    cout_local << "RegExp litval:  " << litValue << endl;
+                } else if (matchLabel(nodeLabel, "RegExp: ", true, litValue)) {
                     TacPlace* place = new RegExpNode(litValue);
                     node = new DepGraphNormalNode("noFile", -1, nodeID, -1, -1, place);
                     depGraph.addNode(node);
-                } else if (boost::regex_match(nodeLabel, sm, regxNodeLit)){
-                    litValue = sm[1];
-                    cout_local << "litval original:  " << litValue << endl;
+                } else if (matchLabel(nodeLabel, "Lit: ", true, litValue)) {
                     litValue = DepGraph::escapeLiteral(litValue);
-                    cout_local << "result litval:  " << litValue << endl;
                     TacPlace* place = new Literal(litValue);
                     node = new DepGraphNormalNode("noFile", -1, nodeID, -1, -1, place);
                     depGraph.addNode(node);
-                } else if (boost::regex_match(nodeLabel, sm, regxNodeOp)){
-                    opName = sm[1];
-                    node = new DepGraphOpNode("noFile", -1, nodeID, -1, -1, opName, false);
+                } else {
+                    // the label is never empty here
+                    node = new DepGraphOpNode("noFile", -1, nodeID, -1, -1, nodeLabel, false);
                     depGraph.addNode(node);
-                    cout_local << "Op: " << opName << endl;
-                }
-                else {
-                    throw invalid_argument("error parsing the dependency graph dot file. Can not parse node label (type)");
                 }
                 DepGraphNormalNode* root;
                 if (nodeShape == "doubleoctagon" && (root = dynamic_cast<DepGraphNormalNode*>(node)) != NULL ) {
@@ -368,29 +611,52 @@ DepGraph DepGraph::parseStream(std::istream &stream) {
             } else {
                 throw invalid_argument("error parsing the dependency graph dot file. Can not parse node description");
             }
-        } else if (boost::regex_match(inputLine, sm, regxEdge)) {
+        } else if (matchEdgeLine(inputLine, fromNodeID, toNodeID)) {
             //process edge
-            fromNodeID = std::stoi(sm[1]) - 1;
-            toNodeID = std::stoi(sm[2]) - 1;
             DepGraphNode* fromNode = depGraph.getNode(fromNodeID);
             DepGraphNode* toNode = depGraph.getNode(toNodeID);
             depGraph.addEdge(fromNode, toNode);
-            cout_local << "Found edge: " << fromNodeID << "(" << fromNode << ") --> " << toNodeID << "(" << toNode << ")" << endl;
-        } else if (boost::regex_match(inputLine, sm, regxComment)) {
+        } else if (matchMetadataLine(inputLine, key, value)) {
             //process metadata
-            if(boost::regex_match(inputLine, sm, regxMetadata)) {
-                std::string key = sm[1];
-                std::string value = sm[2];
-                depGraph.metadata.set_field(key, value);
-            }
+            depGraph.metadata.set_field(key, value);
+        } else if (matchEscapesLine(inputLine, pattern, chars)) {
+            escapedChars[pattern] = chars;
         }
     }
 
+    if (!escapedChars.empty()) {
+        useEscapeStrings(depGraph, escapedChars);
+    }
     depGraph.calculateSCCs();
 
     return depGraph;
 }
 
+Metadata DepGraph::parseDotFileMetadata(const std::string& fname) {
+    Metadata metadata;
+    std::ifstream ifs;
+    try {
+        ifs.open(fname, std::ifstream::in);
+        string key;
+        string value;
+        string inputLine;
+        while (ifs.good()) {
+            getline(ifs, inputLine);
+            if (!startsWith(inputLine, "//", 2))
+                break;
+            if (matchMetadataLine(inputLine, key, value))
+                metadata.set_field(key, value);
+        }
+        ifs.close();
+        return metadata;
+    } catch (exception const &e) {
+        cerr << "Can not read metadata from file " << fname << ". Following exception happened:\n" << e.what();
+        if (ifs.is_open())
+            ifs.close();
+        throw;
+    }
+}
+
 DepGraph DepGraph::parsePixyDotFile(std::string fname) {
     DepGraph depGraph;
 
@@ -585,60 +851,24 @@ void DepGraph::dumpDot(string fname) const{
 }
 
 void DepGraph::calculateSCCs() {
-	int time_count = 0;
-	map<int, int> lowlink;
-	map<int, bool> used;
-	stack<int> process_stack;
-
-    for (auto node_ptr : getNodes()) {
-      if (!used[node_ptr->getID()]) {
-    	  dfsSCC(node_ptr, time_count, lowlink, used, process_stack);
-      }
-    }
+	const CompactDepGraph& graph = getCompactGraph();
+
+	scc_map.clear();
+	scc_components.clear();
+	for (auto& component : graph.getSCCs()) {
+		NodesList scc_component;
+		for (int index : component.second) {
+			scc_component.push_back(graph.nodeAt(index));
+			scc_map[graph.nodeAt(index)->getID()] = component.first;
+		}
+		scc_components[component.first] = scc_component;
+	}
 
 //    printSCCInfo();
 
     return;
 }
 
-void DepGraph::dfsSCC(DepGraphNode* node, int& time_count, map<int, int>& lowlink, map<int, bool>& used, stack<int>& process_stack) {
-	int u = node->getID();
-	lowlink[u] = time_count++;
-	used[u] = true;
-	process_stack.push(u);
-	bool is_component_root = true;
-
-	for (auto succ_node : getSuccessors(node)) {
-		int v = succ_node->getID();
-		if (!used[v])
-			dfsSCC(succ_node, time_count, lowlink, used, process_stack);
-		if (lowlink[u] > lowlink[v]) {
-			lowlink[u] = lowlink[v];
-			is_component_root = false;
-		}
-	}
-
-	if (is_component_root) {
-		int k;
-		vector<DepGraphNode* > scc_component;
-		while (true) {
-			k = process_stack.top();
-			process_stack.pop();
-			scc_component.push_back(getNode(k));
-			scc_map[k] = u;
-			lowlink[k] = INT_MAX;
-			if (k == u)
-				break;
-		}
-		// only keep the scc nodes that has more than 1 element
-		if (scc_component.size() > 1) {
-			scc_components[u] = scc_component;
-		} else {
-			scc_map.erase(k);
-		}
-	}
-}
-
 bool DepGraph::isSCCElement(const DepGraphNode* node) const {
 	return scc_map.find(node->getID()) != scc_map.end();
 }
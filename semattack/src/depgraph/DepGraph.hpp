@@ -32,8 +32,10 @@
 #include "DepGraphOpNode.hpp"
 #include "DepGraphNormalNode.hpp"
 #include "Metadata.hpp"
+#include "CompactDepGraph.hpp"
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <stack>
 #include <queue>
@@ -94,6 +96,10 @@ public:
     NodesList getPredecessors(const DepGraphNode* node) const;
     NodesList getSuccessors(const DepGraphNode* node) const;
 
+    // Adjacency arrays of the current nodes and edges, rebuilt on first use
+    // after the graph changed
+    const CompactDepGraph& getCompactGraph() const;
+
     DepGraphNormalNode* getRoot() {
         return this->root;
     };
@@ -159,6 +165,9 @@ public:
     static DepGraph parseDotFile(const std::string& fname);
     static DepGraph parseString(const std::string& s);
     static DepGraph parsePixyDotFile(std::string fname);
+    // reads only the leading comment block of a dot file, stops at the first
+    // line that is not a comment
+    static Metadata parseDotFileMetadata(const std::string& fname);
     
     std::string label;
     std::string labelloc;
@@ -188,7 +197,8 @@ protected:
 
 	Metadata metadata;
 
-	void dfsSCC(DepGraphNode* node, int& time_count, map<int, int>& lowlink, map<int, bool>& used, stack<int>& process_stack);
+	// CSR form of nodes and edges, reset whenever they change
+	mutable std::shared_ptr<const CompactDepGraph> compact;
 
 	void printSCCInfo();
 
@@ -197,6 +207,8 @@ protected:
 
 private:
         static std::string escapeLiteral(const std::string& litValue);
+
+        friend class CompactDepGraph;
 };
 
 // Like a Depgraph, but owns its node pointers (and deletes the in the descrutor)
@@ -25,16 +25,21 @@
 #define DEPGRAPHOPNODE_HPP_
 
 #include "DepGraphNode.hpp"
+#include <map>
 
 class DepGraphOpNode: public DepGraphNode {
 public:
 	DepGraphOpNode(std::string filename, int origLineno, int id, int order, int sccID, std::string opname, bool builtin) : DepGraphNode(filename, origLineno, id, order, sccID), name(opname), builtin(builtin){};
 	DepGraphOpNode(const DepGraphOpNode& other)
-			: DepGraphNode(other), name(other.name), builtin(other.builtin) {	};
+			: DepGraphNode(other), name(other.name), builtin(other.builtin), escapes(other.escapes) {	};
 	virtual ~DepGraphOpNode();
 	std::string dotNameShortest() const;
 	std::string getName() const {return this->name;};
 	bool isBuiltin() const {return this->builtin;};
+	// A replace whose function replacer escapes single characters becomes an
+	// escape_chars op with the escape string of each character
+	void setEscapes(const std::map<char, std::string>& escapes) {this->name = "escape_chars"; this->escapes = escapes;};
+	const std::map<char, std::string>& getEscapes() const {return this->escapes;};
 	bool equals (const DepGraphNode* compX) const;
 	std::string dotName() const;
 	std::string comparableName() const;
@@ -44,6 +49,7 @@ public:
 private:
     std::string name;
 	bool builtin;    // builtin function?
+	std::map<char, std::string> escapes;
 
 };
 
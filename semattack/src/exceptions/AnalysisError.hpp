@@ -42,6 +42,9 @@
   DO(InfiniteLength)                             \
   DO(InfiniteRegex)                             \
   DO(NotImplemented)                             \
+  DO(Timeout)                                    \
+  DO(ResourceLimit)                              \
+  DO(WorkerCrash)                                \
   DO(Other)
 
 #define MAKE_ENUM(VAR) VAR,
@@ -0,0 +1,191 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * main_contains_bench.cpp
+ *
+ * Copyright SAP SE. 2020-2022.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include "MultiAttack.hpp"
+#include "depgraph/DepGraph.hpp"
+
+using namespace std;
+using namespace boost;
+namespace po = boost::program_options;
+
+// The payloads generated for each metadata entry, as in SemAttack.cpp
+static const std::vector<std::string> payload_functions = { "taintfoxLog(\"xss\")", "taintfoxLog('xss')", "taintfoxLog`xss`" };
+static const std::vector<bool> payload_use_solidus = { false, true };
+
+/**
+ * Generates the exploit payloads from the metadata of up to max dot files
+ * below target and builds their "contains" automata with
+ * makeContainsString and with the star-concatenation it replaced. The
+ * payloads of each file are also combined with makeContainsAnyString and
+ * compared to the union of their closures. Every pair must be equivalent,
+ * any disagreement is reported.
+ */
+void contains_bench(const string& target, int max)
+{
+  std::vector<fs::path> paths = MultiAttack::getDotFilesInDir(target);
+  if (max > 0 && paths.size() > (size_t) max) {
+    paths.resize(max);
+  }
+
+  std::set<std::string> unique;
+  std::vector<std::vector<std::string> > groups;
+  for (auto const& path : paths) {
+    try {
+      Metadata metadata = DepGraph::parseDotFileMetadata(path.string());
+      std::vector<std::string> group;
+      for (auto& f : payload_functions) {
+        for (bool b : payload_use_solidus) {
+          std::string payload = metadata.generate_exploit_from_scratch(f, b);
+          if (!payload.empty()) {
+            group.push_back(payload);
+            unique.insert(payload);
+          }
+        }
+      }
+      if (!group.empty()) {
+        groups.push_back(group);
+      }
+    } catch (std::exception const &e) {
+    }
+  }
+  std::vector<std::string> payloads(unique.begin(), unique.end());
+  size_t longest = 0;
+  for (auto const& payload : payloads) {
+    longest = std::max(longest, payload.size());
+  }
+  cout << "Generated " << payloads.size() << " unique payloads from " << paths.size()
+       << " dependency graph files, the longest has " << longest << " characters." << endl;
+
+  std::vector<StrangerAutomaton*> closures;
+  auto start = std::chrono::steady_clock::now();
+  for (auto const& payload : payloads) {
+    closures.push_back(StrangerAutomaton::makeContainsStringByClosure(payload));
+  }
+  double closure_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<StrangerAutomaton*> direct;
+  start = std::chrono::steady_clock::now();
+  for (auto const& payload : payloads) {
+    direct.push_back(StrangerAutomaton::makeContainsString(payload));
+  }
+  double kmp_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  long mismatches = 0;
+  for (size_t i = 0; i < payloads.size(); i++) {
+    if (!closures[i]->checkEquivalence(direct[i])) {
+      cout << "Mismatch for payload: " << payloads[i] << endl;
+      mismatches++;
+    }
+  }
+  cout << "Payload mismatches: " << mismatches << endl;
+  cout << "Star-concatenation: " << closure_ms << " ms" << endl;
+  cout << "KMP construction: " << kmp_ms << " ms" << endl;
+  if (kmp_ms > 0) {
+    cout << "Speedup: " << closure_ms / kmp_ms << "x" << endl;
+  }
+
+  std::vector<StrangerAutomaton*> unions;
+  start = std::chrono::steady_clock::now();
+  for (auto const& group : groups) {
+    StrangerAutomaton* result = StrangerAutomaton::makeContainsStringByClosure(group[0]);
+    for (size_t i = 1; i < group.size(); i++) {
+      StrangerAutomaton* closure = StrangerAutomaton::makeContainsStringByClosure(group[i]);
+      StrangerAutomaton* combined = result->union_(closure);
+      delete closure;
+      delete result;
+      result = combined;
+    }
+    unions.push_back(result);
+  }
+  double union_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<StrangerAutomaton*> any;
+  start = std::chrono::steady_clock::now();
+  for (auto const& group : groups) {
+    any.push_back(StrangerAutomaton::makeContainsAnyString(group));
+  }
+  double aho_corasick_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  mismatches = 0;
+  for (size_t i = 0; i < groups.size(); i++) {
+    if (!unions[i]->checkEquivalence(any[i])) {
+      mismatches++;
+    }
+  }
+  cout << "Payload set mismatches: " << mismatches << " of " << groups.size() << endl;
+  cout << "Union of star-concatenations: " << union_ms << " ms" << endl;
+  cout << "Aho-Corasick construction: " << aho_corasick_ms << " ms" << endl;
+  if (aho_corasick_ms > 0) {
+    cout << "Speedup: " << union_ms / aho_corasick_ms << "x" << endl;
+  }
+
+  for (auto list : { &closures, &direct, &unions, &any }) {
+    for (auto a : *list) {
+      delete a;
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  try {
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+      ("help",         "produce help message")
+      ("target,t",     po::value<string>()->default_value("input"), "Path to a dependency graph file or a directory of them.")
+      ("number,n",     po::value<int>()->default_value(100), "Maximum number of depgraphs to read (0 for all)");
+
+    po::positional_options_description p;
+    p.add("target", 1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).
+              options(desc).positional(p).run(), vm);
+
+    if (vm.count("help"))
+    {
+      cout << desc << "\n";
+      return 0;
+    }
+
+    po::notify(vm);
+
+    contains_bench(vm["target"].as<string>(), vm["number"].as<int>());
+
+  } catch(std::exception& e) {
+    cerr << "Error: " << e.what() << "\n";
+    exit(EXIT_FAILURE);
+  }
+  catch(...)
+  {
+    cerr << "Unknown error!" << "\n";
+    return false;
+  }
+
+}
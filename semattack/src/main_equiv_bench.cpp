@@ -0,0 +1,158 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * main_equiv_bench.cpp
+ *
+ * Copyright SAP SE. 2020-2022.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <sstream>
+#include "MultiAttack.hpp"
+#include "SemAttack.hpp"
+#include "depgraph/DepGraph.hpp"
+
+using namespace std;
+using namespace boost;
+namespace po = boost::program_options;
+
+/**
+ * Computes the post-images of up to max dot files below target and compares
+ * every pair, and every post-image with a copy of itself, with
+ * checkEquivalence and with the product construction it replaced. Both
+ * must agree on every pair, any disagreement is reported.
+ */
+void equiv_bench(const string& target, const string& field_name, int max)
+{
+  std::vector<fs::path> paths = MultiAttack::getDotFilesInDir(target);
+  if (max > 0 && paths.size() > (size_t) max) {
+    paths.resize(max);
+  }
+  cout << "Computing post images of " << paths.size() << " dependency graph files." << endl;
+
+  std::vector<StrangerAutomaton*> postImages;
+  // The analysis is chatty, keep it out of the output
+  std::stringstream sink;
+  std::streambuf* cout_buf = cout.rdbuf(sink.rdbuf());
+  std::streambuf* cerr_buf = cerr.rdbuf(sink.rdbuf());
+  for (auto const& path : paths) {
+    try {
+      DepGraph graph = DepGraph::parseDotFile(path.string());
+      SemAttack attack(path.string(), graph, field_name);
+      attack.setPrint(false);
+      attack.init();
+      AnalysisResult result = attack.computeTargetFWAnalysis();
+      const StrangerAutomaton* postImage = attack.getPostImage(result);
+      if (postImage != nullptr && !postImage->isNull()) {
+        postImages.push_back(postImage->deepClone());
+      }
+    } catch (std::exception const &e) {
+    }
+    sink.str("");
+  }
+  cout.rdbuf(cout_buf);
+  cerr.rdbuf(cerr_buf);
+
+  std::vector<std::pair<const StrangerAutomaton*, const StrangerAutomaton*> > pairs;
+  std::vector<StrangerAutomaton*> copies;
+  for (size_t i = 0; i < postImages.size(); i++) {
+    copies.push_back(postImages[i]->deepClone());
+    pairs.emplace_back(postImages[i], copies.back());
+    for (size_t j = i + 1; j < postImages.size(); j++) {
+      pairs.emplace_back(postImages[i], postImages[j]);
+    }
+  }
+  cout << "Comparing " << pairs.size() << " pairs of " << postImages.size() << " post images." << endl;
+
+  std::vector<bool> expected;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& pair : pairs) {
+    expected.push_back(pair.first->checkEquivalenceByProduct(pair.second));
+  }
+  double product_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  long equal = 0;
+  long mismatches = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < pairs.size(); i++) {
+    bool result = pairs[i].first->checkEquivalence(pairs[i].second);
+    if (result) {
+      equal++;
+    }
+    if (result != expected[i]) {
+      mismatches++;
+    }
+  }
+  double union_find_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  cout << "Equivalent pairs: " << equal << ", mismatches: " << mismatches << endl;
+  cout << "Product construction: " << product_ms << " ms" << endl;
+  cout << "Union-find: " << union_find_ms << " ms" << endl;
+  if (union_find_ms > 0) {
+    cout << "Speedup: " << product_ms / union_find_ms << "x" << endl;
+  }
+
+  for (auto a : postImages) {
+    delete a;
+  }
+  for (auto a : copies) {
+    delete a;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  try {
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+      ("help",         "produce help message")
+      ("target,t",     po::value<string>()->default_value("input"), "Path to a dependency graph file or a directory of them.")
+      ("fieldname,f",  po::value<string>()->default_value("x"), "Name of the input field")
+      ("number,n",     po::value<int>()->default_value(100), "Maximum number of depgraphs to compute (0 for all)");
+
+    po::positional_options_description p;
+    p.add("target", 1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).
+              options(desc).positional(p).run(), vm);
+
+    if (vm.count("help"))
+    {
+      cout << desc << "\n";
+      return 0;
+    }
+
+    po::notify(vm);
+
+    equiv_bench(vm["target"].as<string>(), vm["fieldname"].as<string>(), vm["number"].as<int>());
+
+  } catch(std::exception& e) {
+    cerr << "Error: " << e.what() << "\n";
+    exit(EXIT_FAILURE);
+  }
+  catch(...)
+  {
+    cerr << "Unknown error!" << "\n";
+    return false;
+  }
+
+}
@@ -0,0 +1,167 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * main_model_bench.cpp
+ *
+ * Copyright SAP SE. 2020-2022.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include "MultiAttack.hpp"
+#include "SemAttack.hpp"
+#include "depgraph/DepGraph.hpp"
+
+using namespace std;
+using namespace boost;
+namespace po = boost::program_options;
+
+typedef std::function<StrangerAutomaton*(const StrangerAutomaton*)> Model;
+
+/**
+ * Computes the post-images of up to max dot files below target and applies
+ * each sanitizer function model to all of them. The time spent in every
+ * model is printed with the total number of states of its results, so the
+ * output of two builds can be compared for both speed and agreement.
+ */
+void model_bench(const string& target, const string& field_name, int max)
+{
+  std::vector<fs::path> paths = MultiAttack::getDotFilesInDir(target);
+  if (max > 0 && paths.size() > (size_t) max) {
+    paths.resize(max);
+  }
+  cout << "Computing post images of " << paths.size() << " dependency graph files." << endl;
+
+  std::vector<StrangerAutomaton*> postImages;
+  // The analysis is chatty, keep it out of the output
+  std::stringstream sink;
+  std::streambuf* cout_buf = cout.rdbuf(sink.rdbuf());
+  std::streambuf* cerr_buf = cerr.rdbuf(sink.rdbuf());
+  for (auto const& path : paths) {
+    try {
+      DepGraph graph = DepGraph::parseDotFile(path.string());
+      SemAttack attack(path.string(), graph, field_name);
+      attack.setPrint(false);
+      attack.init();
+      AnalysisResult result = attack.computeTargetFWAnalysis();
+      const StrangerAutomaton* postImage = attack.getPostImage(result);
+      if (postImage != nullptr && !postImage->isNull()) {
+        postImages.push_back(postImage->deepClone());
+      }
+    } catch (std::exception const &e) {
+    }
+    sink.str("");
+  }
+  cout.rdbuf(cout_buf);
+  cerr.rdbuf(cerr_buf);
+  cout << "Applying function models to " << postImages.size() << " post images." << endl;
+
+  StrangerAutomaton* lessThan = StrangerAutomaton::makeChar('<');
+  StrangerAutomaton* quote = StrangerAutomaton::makeChar('"');
+  const std::vector<std::pair<std::string, Model> > models = {
+    { "trim", [](const StrangerAutomaton* a) { return a->trimSpaces(); } },
+    { "pre_trim", [](const StrangerAutomaton* a) { return a->preTrimSpaces(); } },
+    { "strtoupper", [](const StrangerAutomaton* a) { return a->toUpperCase(); } },
+    { "strtolower", [](const StrangerAutomaton* a) { return a->toLowerCase(); } },
+    { "pre_strtolower", [](const StrangerAutomaton* a) { return a->preToLowerCase(); } },
+    { "strtr('\"', '\'')", [](const StrangerAutomaton* a) { return a->translateChars({ { '"', '\'' } }); } },
+    { "addslashes", [](const StrangerAutomaton* a) { return StrangerAutomaton::addslashes(a); } },
+    { "pre_addslashes", [](const StrangerAutomaton* a) { return StrangerAutomaton::pre_addslashes(a); } },
+    { "htmlspecialchars", [](const StrangerAutomaton* a) { return StrangerAutomaton::htmlSpecialChars(a, "ENT_QUOTES"); } },
+    { "pre_htmlspecialchars", [](const StrangerAutomaton* a) { return StrangerAutomaton::preHtmlSpecialChars(a, "ENT_QUOTES"); } },
+    { "escapeHtmlTags", [](const StrangerAutomaton* a) { return StrangerAutomaton::escapeHtmlTags(a); } },
+    { "encodeAttrString", [](const StrangerAutomaton* a) { return StrangerAutomaton::encodeAttrString(a); } },
+    { "str_replace('<')", [lessThan](const StrangerAutomaton* a) { return StrangerAutomaton::str_replace(lessThan, "&lt;", a); } },
+    { "str_replace('\"')", [quote](const StrangerAutomaton* a) { return StrangerAutomaton::str_replace(quote, "", a); } },
+  };
+
+  double total_ms = 0;
+  for (auto const& model : models) {
+    long states = 0;
+    long errors = 0;
+    double model_ms = 0;
+    for (auto postImage : postImages) {
+      auto start = std::chrono::steady_clock::now();
+      try {
+        StrangerAutomaton* result = model.second(postImage);
+        model_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        states += result->get_num_of_states();
+        delete result;
+      } catch (std::exception const &e) {
+        model_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        errors++;
+      }
+    }
+    total_ms += model_ms;
+    cout << model.first << ": " << model_ms << " ms, " << states << " states";
+    if (errors > 0) {
+      cout << ", " << errors << " errors";
+    }
+    cout << endl;
+  }
+  cout << "Total: " << total_ms << " ms" << endl;
+
+  delete lessThan;
+  delete quote;
+  for (auto a : postImages) {
+    delete a;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  try {
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+      ("help",         "produce help message")
+      ("target,t",     po::value<string>()->default_value("input"), "Path to a dependency graph file or a directory of them.")
+      ("fieldname,f",  po::value<string>()->default_value("x"), "Name of the input field")
+      ("number,n",     po::value<int>()->default_value(100), "Maximum number of depgraphs to read (0 for all)");
+
+    po::positional_options_description p;
+    p.add("target", 1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).
+              options(desc).positional(p).run(), vm);
+
+    if (vm.count("help"))
+    {
+      cout << desc << "\n";
+      return 0;
+    }
+
+    po::notify(vm);
+
+    model_bench(vm["target"].as<string>(), vm["fieldname"].as<string>(), vm["number"].as<int>());
+
+  } catch(std::exception& e) {
+    cerr << "Error: " << e.what() << "\n";
+    exit(EXIT_FAILURE);
+  }
+  catch(...)
+  {
+    cerr << "Unknown error!" << "\n";
+    return false;
+  }
+
+}
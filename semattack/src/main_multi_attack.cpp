@@ -37,7 +37,10 @@ namespace po = boost::program_options;
 
 void call_sem_attack(const string& target_name, const string& output_dir, const string& field_name, int max,
                      bool concats, bool singleton_intersection, bool preImage, bool encode, bool payload,
-                     bool attackPatterns, bool attack_forward, bool dotfiles)
+                     bool attackPatterns, bool attack_forward, bool dotfiles, bool liveness,
+                     const string& cache_dir, int cache_size, const string& timings_file,
+                     double timeout, unsigned long max_states, unsigned long max_bdd_nodes,
+                     unsigned int workers, bool resume)
 {
     try {
         cout << endl << "\t------ Starting Analysis for: " << field_name << " ------" << endl;
@@ -59,6 +62,16 @@ void call_sem_attack(const string& target_name, const string& output_dir, const
         attack.setPayloadAnalysis(payload);
         attack.setDoForwardAnalysisWithAttackPattern(attack_forward);
         attack.setDotFiles(dotfiles);
+        attack.setFreeDeadAutomata(liveness);
+        if (!cache_dir.empty()) {
+          attack.setPostImageCache(cache_dir, cache_size);
+        }
+        if (!timings_file.empty()) {
+          attack.setTimingsFile(timings_file);
+        }
+        attack.setBudget(AnalysisBudget(timeout, max_states, max_bdd_nodes));
+        attack.setWorkers(workers);
+        attack.setResume(resume);
 
         if (attackPatterns) {
           attack.addAttackPattern(AttackContext::LessThan);
@@ -132,7 +145,16 @@ int main(int argc, char *argv[]) {
           ("payload,y",    po::value<bool>()->default_value(true), "Use payload string attack patterns")
           ("attack,a",     po::value<bool>()->default_value(true), "Use fixed attack patterns")
           ("attackfw,k",   po::value<bool>()->default_value(false), "Do forward analysis with attack pattern if there is no intersection with post image")
-          ("dotfiles,d",   po::value<bool>()->default_value(true), "Output all dot output files to disk");
+          ("dotfiles,d",   po::value<bool>()->default_value(true), "Output all dot output files to disk")
+          ("liveness,l",   po::value<bool>()->default_value(false), "Free intermediate forward automata as soon as they are no longer needed")
+          ("cache,x",      po::value<string>()->default_value(""), "Directory to keep post images in between runs (disabled if empty)")
+          ("cachesize,z",  po::value<int>()->default_value(0), "Maximum size of the post image cache in MB (0 is unlimited)")
+          ("timings,T",    po::value<string>()->default_value(""), "File with per-file analysis times used to schedule expensive graphs first, rewritten after the run")
+          ("timeout,w",    po::value<double>()->default_value(0), "Seconds after which a forward or backward analysis task is cancelled (0 is unlimited)")
+          ("maxstates,M",  po::value<unsigned long>()->default_value(0), "Cancel a task which builds an automaton with more states (0 is unlimited)")
+          ("maxbddnodes,B", po::value<unsigned long>()->default_value(0), "Cancel a task which builds an automaton with more BDD nodes (0 is unlimited)")
+          ("workers,W",    po::value<unsigned int>()->default_value(0), "Number of worker processes, a crash only loses the graph being analysed (0 analyses in threads)")
+          ("resume,R",     po::value<bool>()->default_value(false), "Resume an interrupted run from the journal in the output directory");
 
         po::positional_options_description p;
         p.add("target", 1);
@@ -164,6 +186,14 @@ int main(int argc, char *argv[]) {
                << ", Fixed attack patterns: " << vm["payload"].as<bool>()
                << ", Do forward analysis with attack pattern if there is no intersection with post image: " << vm["attackfw"].as<bool>()
                << ", Output dot files: " << vm["dotfiles"].as<bool>()
+               << ", Free dead automata: " << vm["liveness"].as<bool>()
+               << ", Post image cache: " << vm["cache"].as<string>()
+               << ", Timings file: " << vm["timings"].as<string>()
+               << ", Task timeout: " << vm["timeout"].as<double>()
+               << ", Max states: " << vm["maxstates"].as<unsigned long>()
+               << ", Max BDD nodes: " << vm["maxbddnodes"].as<unsigned long>()
+               << ", Worker processes: " << vm["workers"].as<unsigned int>()
+               << ", Resume: " << vm["resume"].as<bool>()
                << "\n";
 
             call_sem_attack(vm["target"].as<string>(),
@@ -177,7 +207,16 @@ int main(int argc, char *argv[]) {
                             vm["payload"].as<bool>(),
                             vm["attack"].as<bool>(),
                             vm["attackfw"].as<bool>(),
-                            vm["dotfiles"].as<bool>()
+                            vm["dotfiles"].as<bool>(),
+                            vm["liveness"].as<bool>(),
+                            vm["cache"].as<string>(),
+                            vm["cachesize"].as<int>(),
+                            vm["timings"].as<string>(),
+                            vm["timeout"].as<double>(),
+                            vm["maxstates"].as<unsigned long>(),
+                            vm["maxbddnodes"].as<unsigned long>(),
+                            vm["workers"].as<unsigned int>(),
+                            vm["resume"].as<bool>()
               );
         }
         else {
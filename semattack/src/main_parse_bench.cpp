@@ -0,0 +1,143 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/*
+ * main_parse_bench.cpp
+ *
+ * Copyright SAP SE. 2020-2022.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the  Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335,
+ * USA.
+ *
+ * Authors: Thomas Barber
+ */
+
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include "MultiAttack.hpp"
+#include "depgraph/DepGraph.hpp"
+
+using namespace std;
+using namespace boost;
+namespace po = boost::program_options;
+
+/**
+ * Parses every dot file below target repeat times and reports the time spent
+ * in DepGraph::parseDotFile. The digest is computed over the toDot() output of
+ * all parsed graphs, so running the benchmark before and after a parser change
+ * shows whether both produce identical graphs. Files that fail to parse are
+ * counted and contribute a zero to the digest.
+ */
+void parse_bench(const string& target, int repeat)
+{
+  std::vector<fs::path> paths = MultiAttack::getDotFilesInDir(target);
+  cout << "Found " << paths.size() << " dependency graph files." << endl;
+
+  size_t digest = 0;
+  long nodes = 0;
+  long edges = 0;
+  long failed = 0;
+  std::chrono::nanoseconds total(0);
+  std::chrono::nanoseconds slowest(0);
+  fs::path slowest_path;
+
+  // parseStream announces every file on stdout and parse errors go to
+  // stderr, keep both out of the timing
+  std::stringstream sink;
+  std::streambuf* cout_buf = cout.rdbuf(sink.rdbuf());
+  std::streambuf* cerr_buf = cerr.rdbuf(sink.rdbuf());
+  for (int i = 0; i < repeat; i++) {
+    for (auto const& path : paths) {
+      size_t graph_hash = 0;
+      auto start = std::chrono::steady_clock::now();
+      try {
+        DepGraph graph = DepGraph::parseDotFile(path.string());
+        if (i == 0) {
+          nodes += graph.getNumOfNodes();
+          edges += graph.getNumOfEdges();
+          graph_hash = std::hash<std::string>()(graph.toDot());
+        }
+      } catch (std::exception const &e) {
+        if (i == 0) {
+          failed++;
+        }
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      total += elapsed;
+      if (elapsed > slowest) {
+        slowest = elapsed;
+        slowest_path = path;
+      }
+      if (i == 0) {
+        digest = digest * 31 + graph_hash;
+      }
+      sink.str("");
+    }
+  }
+  cout.rdbuf(cout_buf);
+  cerr.rdbuf(cerr_buf);
+
+  double total_ms = std::chrono::duration<double, std::milli>(total).count();
+  size_t parses = paths.size() * repeat;
+  cout << "Parsed " << paths.size() << " files " << repeat << " times ("
+       << nodes << " nodes, " << edges << " edges per pass, "
+       << failed << " files failed to parse)" << endl;
+  cout << "Total parse time: " << total_ms << " ms" << endl;
+  if (parses > 0) {
+    cout << "Average per file: " << total_ms / parses << " ms" << endl;
+    cout << "Slowest file: " << slowest_path.string() << " ("
+         << std::chrono::duration<double, std::milli>(slowest).count() << " ms)" << endl;
+  }
+  cout << "Graph digest: " << std::hex << digest << std::dec << endl;
+}
+
+int main(int argc, char *argv[]) {
+  try {
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+      ("help",       "produce help message")
+      ("target,t",   po::value<string>()->default_value("input"), "Path to a dependency graph file or a directory of them.")
+      ("repeat,r",   po::value<int>()->default_value(5), "Number of times every file is parsed");
+
+    po::positional_options_description p;
+    p.add("target", 1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).
+              options(desc).positional(p).run(), vm);
+
+    if (vm.count("help"))
+    {
+      cout << desc << "\n";
+      return 0;
+    }
+
+    po::notify(vm);
+
+    parse_bench(vm["target"].as<string>(), vm["repeat"].as<int>());
+
+  } catch(std::exception& e) {
+    cerr << "Error: " << e.what() << "\n";
+    exit(EXIT_FAILURE);
+  }
+  catch(...)
+  {
+    cerr << "Unknown error!" << "\n";
+    return false;
+  }
+
+}
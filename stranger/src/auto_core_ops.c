@@ -63,6 +63,199 @@ char *bintostr(unsigned long n, int k) {
   return str;
 }
 
+/*
+ * Packs the first var tracks of a path into a label. The trace is walked
+ * once, a track is found directly if indices are in order.
+ */
+PackedLabel packed_label(trace_descr trace, int var, int *indices) {
+  PackedLabel label = { 0, 0 };
+  trace_descr tp;
+  unsigned long long bit;
+  int j;
+  assert(var <= 64);
+  for (tp = trace; tp; tp = tp->next) {
+    j = tp->index;
+    if (j < 0 || j >= var || indices[j] != tp->index) {
+      for (j = 0; j < var && indices[j] != tp->index; j++)
+        ;
+      if (j == var)
+        continue;
+    }
+    bit = 1ULL << (var - 1 - j);
+    label.mask |= bit;
+    if (tp->value)
+      label.value |= bit;
+  }
+  return label;
+}
+
+PackedLabel packed_label_from_string(const char *str, int var) {
+  PackedLabel label = { 0, 0 };
+  unsigned long long bit;
+  int j;
+  assert(var <= 64);
+  for (j = 0; j < var; j++) {
+    bit = 1ULL << (var - 1 - j);
+    if (str[j] != 'X') {
+      label.mask |= bit;
+      if (str[j] == '1')
+        label.value |= bit;
+    }
+  }
+  return label;
+}
+
+//str must have room for var + 1 characters
+void packed_label_to_string(PackedLabel label, int var, char *str) {
+  unsigned long long bit;
+  int j;
+  for (j = 0; j < var; j++) {
+    bit = 1ULL << (var - 1 - j);
+    if (label.mask & bit)
+      str[j] = (label.value & bit) ? '1' : '0';
+    else
+      str[j] = 'X';
+  }
+  str[var] = '\0';
+}
+
+int packed_label_includes_any(PackedLabel label, const char *chars, int size) {
+  int i;
+  for (i = 0; i < size; i++)
+    if (packed_label_includes(label, chars[i]))
+      return 1;
+  return 0;
+}
+
+TransitionTable *dfaBuildTransitionTable(DFA *M, int var, int *indices) {
+  TransitionTable *table;
+  paths state_paths, pp;
+  unsigned count, size;
+  int i;
+
+  table = (TransitionTable *) malloc(sizeof(TransitionTable));
+  table->ns = M->ns;
+  table->var = var;
+  table->indices = NULL;
+  if (var > 0) {
+    table->indices = (int *) malloc(var * sizeof(int));
+    memcpy(table->indices, indices, var * sizeof(int));
+  }
+  table->first = (unsigned *) malloc((M->ns + 1) * sizeof(unsigned));
+  size = 2 * M->ns + 1;
+  table->to = (int *) malloc(size * sizeof(int));
+  table->labels = (PackedLabel *) malloc(size * sizeof(PackedLabel));
+  count = 0;
+  for (i = 0; i < M->ns; i++) {
+    table->first[i] = count;
+    state_paths = pp = make_paths(M->bddm, M->q[i]);
+    while (pp) {
+      if (count == size) {
+        size *= 2;
+        table->to = (int *) realloc(table->to, size * sizeof(int));
+        table->labels = (PackedLabel *) realloc(table->labels, size * sizeof(PackedLabel));
+      }
+      table->to[count] = pp->to;
+      table->labels[count] = packed_label(pp->trace, var, indices);
+      count++;
+      pp = pp->next;
+    }
+    kill_paths(state_paths);
+  }
+  table->first[M->ns] = count;
+  return table;
+}
+
+void dfaFreeTransitionTable(TransitionTable *table) {
+  if (table == NULL)
+    return;
+  free(table->indices);
+  free(table->first);
+  free(table->to);
+  free(table->labels);
+  free(table);
+}
+
+/*
+ * Tables shared for the automata a thread is working on, as models on
+ * different automata run in parallel. A table is either shared by the
+ * owner of its DFA or built by the outermost model acquiring a table for
+ * it, which frees it with its last release, so nested helpers decode each
+ * automaton of a chain of models only once.
+ */
+#define MAX_SHARED_TABLES 8
+typedef struct SharedTable_ {
+  DFA *dfa;
+  TransitionTable *table;
+  int users;
+  boolean owned;
+} SharedTable;
+static __thread SharedTable shared_tables[MAX_SHARED_TABLES];
+static __thread int num_shared_tables = 0;
+
+static void remove_shared_table(int i) {
+  num_shared_tables--;
+  for (; i < num_shared_tables; i++)
+    shared_tables[i] = shared_tables[i + 1];
+}
+
+void dfaShareTransitionTable(DFA *M, TransitionTable *table) {
+  if (num_shared_tables == MAX_SHARED_TABLES)
+    return;
+  shared_tables[num_shared_tables].dfa = M;
+  shared_tables[num_shared_tables].table = table;
+  shared_tables[num_shared_tables].users = 0;
+  shared_tables[num_shared_tables].owned = FALSE;
+  num_shared_tables++;
+}
+
+void dfaUnshareTransitionTable(DFA *M) {
+  int i;
+  for (i = num_shared_tables - 1; i >= 0; i--) {
+    if (shared_tables[i].dfa == M && !shared_tables[i].owned) {
+      remove_shared_table(i);
+      return;
+    }
+  }
+}
+
+TransitionTable *dfaAcquireTransitionTable(DFA *M, int var, int *indices) {
+  TransitionTable *table;
+  int i;
+  for (i = num_shared_tables - 1; i >= 0; i--) {
+    table = shared_tables[i].table;
+    if (shared_tables[i].dfa == M && table->ns == M->ns
+        && (var == 0 || (table->var == var
+                         && memcmp(table->indices, indices, var * sizeof(int)) == 0))) {
+      shared_tables[i].users++;
+      return table;
+    }
+  }
+  table = dfaBuildTransitionTable(M, var, indices);
+  if (num_shared_tables < MAX_SHARED_TABLES) {
+    shared_tables[num_shared_tables].dfa = M;
+    shared_tables[num_shared_tables].table = table;
+    shared_tables[num_shared_tables].users = 1;
+    shared_tables[num_shared_tables].owned = TRUE;
+    num_shared_tables++;
+  }
+  return table;
+}
+
+void dfaReleaseTransitionTable(TransitionTable *table) {
+  int i;
+  for (i = num_shared_tables - 1; i >= 0; i--) {
+    if (shared_tables[i].table == table) {
+      if (--shared_tables[i].users == 0 && shared_tables[i].owned) {
+        remove_shared_table(i);
+        dfaFreeTransitionTable(table);
+      }
+      return;
+    }
+  }
+  dfaFreeTransitionTable(table);
+}
+
 char *bintostrWithExtraBit(unsigned long n, int k) {
   char *str;
 
@@ -834,6 +1027,189 @@ DFA* dfa_construct_set_of_strings(char** set, int size, int var, int* indices){
   return result;
 }
 
+/*
+ * Symbol classes of the string matchers: every distinct character of the
+ * patterns gets a class, all other characters behave the same.
+ * cls maps a character to its class or -1, syms maps a class back to the
+ * character.
+ */
+static unsigned long matcher_symbol(char c, int var) {
+  unsigned long sym = (unsigned char) c;
+  if (var < 8)
+    sym &= (1UL << var) - 1;
+  return sym;
+}
+
+static void matcher_add_symbols(const char *s, int var, int *cls, unsigned long *syms, int *k) {
+  unsigned long sym;
+  for (; *s; s++) {
+    sym = matcher_symbol(*s, var);
+    if (cls[sym] < 0) {
+      cls[sym] = *k;
+      syms[(*k)++] = sym;
+    }
+  }
+}
+
+/*
+ * Builds the DFA of a string matcher from its transition table, which has
+ * one row of k classes per state. Characters outside of the classes lead
+ * back to state 0, so only transitions to other states are stored.
+ * Accepting states loop on every character as every extension of a string
+ * containing a pattern still contains it.
+ */
+static DFA *matcher_build(int ns, int *delta, char *accept, unsigned long *syms, int k, int var, int *indices) {
+  int i, j, n;
+  char *finals;
+  char *binChar;
+  DFA *result;
+  DFABuilder *b = dfaSetup(ns, var, indices);
+  finals = (char *) malloc((ns + 1) * sizeof(char));
+  for (i = 0; i < ns; i++) {
+    if (accept[i]) {
+      dfaAllocExceptions(b, 0);
+      dfaStoreState(b, i);
+      finals[i] = '+';
+      continue;
+    }
+    n = 0;
+    for (j = 0; j < k; j++)
+      if (delta[i * k + j] != 0)
+        n++;
+    dfaAllocExceptions(b, n);
+    for (j = 0; j < k; j++) {
+      if (delta[i * k + j] != 0) {
+        binChar = bintostr(syms[j], var);
+        dfaStoreException(b, delta[i * k + j], binChar);
+        free(binChar);
+      }
+    }
+    dfaStoreState(b, 0);
+    finals[i] = '-';
+  }
+  finals[ns] = '\0';
+  result = dfaBuild(b, finals);
+  free(finals);
+  return result;
+}
+
+DFA *dfa_construct_contains_string(const char *s, int var, int *indices) {
+  int cls[256];
+  unsigned long syms[256];
+  int k = 0;
+  int len = (int) strlen(s);
+  int *delta;
+  char *accept;
+  int q, x, j, c;
+  DFA *result;
+
+  for (j = 0; j < 256; j++)
+    cls[j] = -1;
+  matcher_add_symbols(s, var, cls, syms, &k);
+  delta = (int *) calloc((len + 1) * (k > 0 ? k : 1), sizeof(int));
+  accept = (char *) calloc(len + 1, sizeof(char));
+  accept[len] = 1;
+
+  // State q has matched the first q characters of s. Mismatches continue
+  // from x, the state reached by s[1..q-1], which is the failure link.
+  if (len > 0)
+    delta[cls[matcher_symbol(s[0], var)]] = 1;
+  x = 0;
+  for (q = 1; q < len; q++) {
+    c = cls[matcher_symbol(s[q], var)];
+    for (j = 0; j < k; j++)
+      delta[q * k + j] = delta[x * k + j];
+    delta[q * k + c] = q + 1;
+    x = delta[x * k + c];
+  }
+
+  result = matcher_build(len + 1, delta, accept, syms, k, var, indices);
+  free(delta);
+  free(accept);
+  return result;
+}
+
+DFA *dfa_construct_contains_any(char **set, int size, int var, int *indices) {
+  int cls[256];
+  unsigned long syms[256];
+  int k = 0;
+  int max_nodes = 1;
+  int nodes = 1;
+  int *delta;
+  int *fail;
+  int *queue;
+  char *accept;
+  int i, j, u, v, head, tail;
+  const char *s;
+  DFA *tmp, *result;
+
+  for (j = 0; j < 256; j++)
+    cls[j] = -1;
+  for (i = 0; i < size; i++) {
+    matcher_add_symbols(set[i], var, cls, syms, &k);
+    max_nodes += (int) strlen(set[i]);
+  }
+  if (k == 0)
+    k = 1;
+  delta = (int *) malloc(max_nodes * k * sizeof(int));
+  fail = (int *) calloc(max_nodes, sizeof(int));
+  queue = (int *) malloc(max_nodes * sizeof(int));
+  accept = (char *) calloc(max_nodes, sizeof(char));
+  for (j = 0; j < k; j++)
+    delta[j] = -1;
+
+  // Trie of the patterns, -1 marks a missing edge. A pattern is not
+  // extended past another one, as the shorter one already accepts.
+  for (i = 0; i < size; i++) {
+    u = 0;
+    for (s = set[i]; *s && !accept[u]; s++) {
+      j = cls[matcher_symbol(*s, var)];
+      if (delta[u * k + j] < 0) {
+        for (v = 0; v < k; v++)
+          delta[nodes * k + v] = -1;
+        delta[u * k + j] = nodes++;
+      }
+      u = delta[u * k + j];
+    }
+    accept[u] = 1;
+  }
+
+  // Breadth first, so the failure link of a node is complete before the
+  // node itself. Missing edges take the transition of the failure link.
+  head = tail = 0;
+  for (j = 0; j < k; j++) {
+    v = delta[j];
+    if (v < 0)
+      delta[j] = 0;
+    else
+      queue[tail++] = v;
+  }
+  while (head < tail) {
+    u = queue[head++];
+    for (j = 0; j < k; j++) {
+      v = delta[u * k + j];
+      if (v < 0) {
+        delta[u * k + j] = delta[fail[u] * k + j];
+      } else {
+        fail[v] = delta[fail[u] * k + j];
+        accept[v] |= accept[fail[v]];
+        queue[tail++] = v;
+      }
+    }
+  }
+
+  // Nodes below an accepting node are unreachable and patterns may share
+  // their suffixes, minimization removes both
+  tmp = matcher_build(nodes, delta, accept, syms, k, var, indices);
+  result = dfaMinimize(tmp);
+  dfaFree(tmp);
+  free(delta);
+  free(fail);
+  free(queue);
+  free(accept);
+  return result;
+}
+
 DFA *dfa_construct_string_extrabit(char *reg, int var, int *indices) {
   int i;
   char *finals;
@@ -2572,11 +2948,10 @@ void initial_visited_states(int *visited, int n) {
 // For each state reachable from sharp1, find its reachable_closure
 int exist_sharp1_path(DFA *M, int start, int var) {
   paths state_paths, pp;
-  trace_descr tp;
-  int j, sink;
-  int finalflag = 1;
+  int sink;
   int *indices = allocateAscIIIndexWithExtraBit(var);
   char *sharp1 = getSharp1WithExtraBit(var);
+  PackedLabel sharp1Label = packed_label_from_string(sharp1, var + 1);
   //printf("Get Sharp1 %s\n", sharp1);
   sink = find_sink(M);
   assert(sink>-1);
@@ -2593,22 +2968,7 @@ int exist_sharp1_path(DFA *M, int start, int var) {
       if (pp->to != sink) {
           //printf("State %d has path to state %d, value: ", start, pp->to);
         // Find the path that may contain 111111111 ( = 255 (+ extrabit) = sharp1)
-        for (j = 0; j < var + 1; j++) {
-          //the following for loop can be avoided if the indices are in order
-          for (tp = pp->trace; tp && (tp->index != j); tp = tp->next);
-          if (tp) {
-              //printf("%d", tp->value);
-            if (tp->value) {
-              if (sharp1[j] == '0')
-                finalflag = 0;
-            } else {
-              if (sharp1[j] == '1')
-                finalflag = 0;
-            }
-          }
-        }
-        //printf(" Finalflag: %d\n", finalflag);
-        if (finalflag != 0) {
+        if (packed_label_overlaps(packed_label(pp->trace, var + 1, indices), sharp1Label)) {
           free(indices);
           free(sharp1);
           int toState = pp->to;
@@ -2617,7 +2977,6 @@ int exist_sharp1_path(DFA *M, int start, int var) {
         }
       }
       pp = pp->next;
-      finalflag = 1;
     }
         kill_paths(state_paths);
   }
@@ -2631,14 +2990,15 @@ struct int_list_type *reachable_closure_delete(DFA *M, int start, int var,
                                                int *indices, int deleting) {
 
   paths state_paths, pp;
-  trace_descr tp;
+  PackedLabel label;
   int j, sink, current;
   // List of states which are transitioned to by sharp 0
   struct int_list_type *sharp1list = NULL;
   // States which transitioned to by sharp1
   struct int_list_type *sharp0list = NULL;
-  int finalflag = 1;
   char *sharp0 = getSharp0WithExtraBit(var);
+  PackedLabel sharp0Label = packed_label_from_string(sharp0, var + 1);
+  int *tracks = allocateAscIIIndexWithExtraBit(var);
   int *visited = (int *) malloc(M->ns * sizeof(int));
   for (j = 0; j < M->ns; j++)
     visited[j] = 0;
@@ -2662,20 +3022,8 @@ struct int_list_type *reachable_closure_delete(DFA *M, int start, int var,
           while (pp) {
               if (pp->to != sink) {
                   // Find the path that may contain 1 1111 1101 ( = 254 = sharp0)
-                  for (j = 0; j < var + 1; j++) {
-                      //the following for loop can be avoided if the indices are in order
-                      for (tp = pp->trace; tp && (tp->index != j); tp = tp->next);
-                      if (tp) {
-                          if (tp->value) {
-                              if (sharp0[j] == '0')
-                                  finalflag = 0;
-                          } else {
-                              if (sharp0[j] == '1')
-                                  finalflag = 0;
-                          }
-                      }
-                  }
-                  if (finalflag != 0) {
+                  label = packed_label(pp->trace, var + 1, tracks);
+                  if (packed_label_overlaps(label, sharp0Label)) {
                       if (current == start) {
 //                          printf("Ignoring direct transition from sharp1 to sharp0 (%d to %d)\n", current, pp->to);
                       } else {
@@ -2696,14 +3044,13 @@ struct int_list_type *reachable_closure_delete(DFA *M, int start, int var,
                       }
                   }
 
-                  for (tp = pp->trace; tp && (tp->index != var); tp = tp->next);
-                  if (((tp && tp->value) || !tp) && (visited[pp->to] == 0)) {
+                  // The bar is the last track
+                  if ((!(label.mask & 1) || (label.value & 1)) && (visited[pp->to] == 0)) {
 //                      printf("Found bar transition from %d to %d\n", current, pp->to);
                       barlist = enqueue(barlist, pp->to);
                   }
               }
               pp = pp->next;
-              finalflag = 1;
           }
           kill_paths(state_paths);
       }
@@ -2712,6 +3059,7 @@ struct int_list_type *reachable_closure_delete(DFA *M, int start, int var,
   free_ilt(sharp1list);
   free(visited);
   free(sharp0);
+  free(tracks);
   return sharp0list;
 }
 
@@ -2777,16 +3125,17 @@ char *getSpace(int k) {
 DFA *dfaRemoveSpace(DFA* M, int var, int* indices){
   DFA *result;
   paths state_paths, pp;
-  trace_descr tp;
-  int i, j, k;
+  PackedLabel label;
+  int i, k;
   char *exeps;
-  char *symbol;
   int *to_states;
   int sink;
   long max_exeps;
   char *statuces;
   char* lambda = getSpace(var);
+  unsigned long long space = packed_label_from_string(lambda, var).value;
 
+  free(lambda);
   max_exeps=1<<var; //maybe exponential
   sink=find_sink(M);
 
@@ -2798,10 +3147,8 @@ DFA *dfaRemoveSpace(DFA* M, int var, int* indices){
 
   DFABuilder *b = dfaSetup(M->ns, var, indices);
   exeps=(char *)malloc(max_exeps*(var+1)*sizeof(char));
-  symbol=(char *)malloc((var+1)*sizeof(char));
   to_states=(int *)malloc(max_exeps*sizeof(int));
   statuces=(char *)malloc((M->ns+1)*sizeof(char));
-  symbol[var]='\0';
   for (i = 0; i < M->ns; i++) {
     if(M->f[i]==1) statuces[i] = '+';
     else statuces[i]='-';
@@ -2810,23 +3157,11 @@ DFA *dfaRemoveSpace(DFA* M, int var, int* indices){
 
     while (pp) {
       if(pp->to!=sink){
-
-        for (j = 0; j < var;  j++) {
-          //the following for loop can be avoided if the indices are in order
-          for (tp = pp->trace; tp && (tp->index != indices[j]); tp =tp->next);
-
-          if (tp) {
-            if (tp->value) symbol[j]='1';
-            else symbol[j]='0';
-          }
-          else
-            symbol[j]='X';
-        }
-        if(isEqual2Lambda(symbol, lambda, var)){
+        label = packed_label(pp->trace, var, indices);
+        if(packed_label_equals(label, space, var)){
           statuces[i]='+';
         }else{
-          for(j = 0; j<var; j++) exeps[k*(var+1)+j]=symbol[j];
-          exeps[k*(var+1)+var]='\0';
+          packed_label_to_string(label, var, exeps+k*(var+1));
           to_states[k]=pp->to;
           k++;
         }
@@ -2845,7 +3180,6 @@ DFA *dfaRemoveSpace(DFA* M, int var, int* indices){
   result = dfaBuild(b, statuces);
   if(_FANG_DFA_DEBUG) dfaPrintVerbose(result);
   free(exeps);
-  free(symbol);
   free(to_states);
   free(statuces);
 
@@ -3272,17 +3606,285 @@ DFA *M1;int var;int *indices; {
     return result;
 }
 
-int check_intersection(M1, M2, var, indices)
-  DFA *M1;DFA *M2;int var;int *indices; {
-  DFA *M;
-  int result;
-  M = dfa_intersect(M1, M2);
-  result = 1 - check_emptiness(M, var, indices);
-  dfaFree(M);
+/*
+ * On-the-fly product search for the yes/no checks. The product of up to
+ * PRODUCT_MAX automata is explored breadth first from the start states and
+ * the search stops as soon as the reach function of the check reports a
+ * product state, so the product is never built, minimized or turned into
+ * an example. A state tuple is packed into one key in mixed radix.
+ */
+#define PRODUCT_MAX 3
+#define PRODUCT_EMPTY (~0ULL)
+
+typedef struct product_search product_search;
+
+struct product_search {
+  int n;
+  DFA *M[PRODUCT_MAX];
+  // Called for every product state reached, returns 1 to stop the search
+  int (*reach)(product_search *ps, int *states);
+  // Wanted status of each component for product_reach_wanted
+  int want[PRODUCT_MAX];
+  unsigned long long *set;
+  unsigned long set_size;
+  unsigned long set_used;
+  // Union-find over the states of M[0] followed by those of M[1] for
+  // product_reach_equivalent
+  int *parent;
+  unsigned long long *queue;
+  unsigned long queue_size;
+  unsigned long head;
+  unsigned long tail;
+};
+
+static unsigned long product_slot(unsigned long long key, unsigned long size) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return (unsigned long) (key & (size - 1));
+}
+
+static unsigned long long product_key(product_search *ps, int *states) {
+  unsigned long long key = 0;
+  int i;
+  for (i = 0; i < ps->n; i++)
+    key = key * (unsigned long long) ps->M[i]->ns + (unsigned long long) states[i];
+  return key;
+}
+
+static void product_queue(product_search *ps, unsigned long long key) {
+  if (ps->tail == ps->queue_size) {
+    ps->queue_size *= 2;
+    ps->queue = (unsigned long long *) realloc(ps->queue, ps->queue_size * sizeof(unsigned long long));
+  }
+  ps->queue[ps->tail++] = key;
+}
+
+/*
+ * Adds the key to the visited set, returns 0 if it was already there
+ */
+static int product_visit(product_search *ps, unsigned long long key) {
+  unsigned long i, j;
+  unsigned long long *old;
+  unsigned long old_size;
+
+  if (!ps->set) {
+    ps->set_size = 1024;
+    ps->set_used = 0;
+    ps->set = (unsigned long long *) malloc(ps->set_size * sizeof(unsigned long long));
+    for (i = 0; i < ps->set_size; i++)
+      ps->set[i] = PRODUCT_EMPTY;
+  }
+  if (2 * (ps->set_used + 1) > ps->set_size) {
+    old = ps->set;
+    old_size = ps->set_size;
+    ps->set_size *= 2;
+    ps->set = (unsigned long long *) malloc(ps->set_size * sizeof(unsigned long long));
+    for (i = 0; i < ps->set_size; i++)
+      ps->set[i] = PRODUCT_EMPTY;
+    for (i = 0; i < old_size; i++) {
+      if (old[i] == PRODUCT_EMPTY)
+        continue;
+      for (j = product_slot(old[i], ps->set_size); ps->set[j] != PRODUCT_EMPTY; j = (j + 1) & (ps->set_size - 1));
+      ps->set[j] = old[i];
+    }
+    free(old);
+  }
+  for (j = product_slot(key, ps->set_size); ps->set[j] != PRODUCT_EMPTY; j = (j + 1) & (ps->set_size - 1)) {
+    if (ps->set[j] == key)
+      return 0;
+  }
+  ps->set[j] = key;
+  ps->set_used++;
+  return 1;
+}
+
+/*
+ * Stops at the first product state whose components all have the wanted
+ * status, every other new state is queued for expansion.
+ */
+static int product_reach_wanted(product_search *ps, int *states) {
+  unsigned long long key = product_key(ps, states);
+  int i;
+
+  if (!product_visit(ps, key))
+    return 0;
+  for (i = 0; i < ps->n; i++) {
+    if (ps->M[i]->f[states[i]] != ps->want[i])
+      break;
+  }
+  if (i == ps->n)
+    return 1;
+  product_queue(ps, key);
+  return 0;
+}
+
+static int product_find(int *parent, int s) {
+  while (parent[s] != s) {
+    parent[s] = parent[parent[s]];
+    s = parent[s];
+  }
+  return s;
+}
+
+/*
+ * Hopcroft and Karp: states of M[0] and M[1] reached by the same string
+ * are merged, and only a pair which is not merged yet is expanded. Stops
+ * at a pair where one state accepts and the other rejects. M[2] is the
+ * filter of dfa_negate, strings with reserved characters are ignored.
+ */
+static int product_reach_equivalent(product_search *ps, int *states) {
+  int a, b;
+
+  if (ps->M[2]->f[states[2]] != 1)
+    return 0;
+  a = product_find(ps->parent, states[0]);
+  b = product_find(ps->parent, ps->M[0]->ns + states[1]);
+  if (a == b)
+    return 0;
+  if (ps->M[0]->f[states[0]] != 0 && ps->M[1]->f[states[1]] != 0 &&
+      ps->M[0]->f[states[0]] != ps->M[1]->f[states[1]])
+    return 1;
+  ps->parent[a] = b;
+  product_queue(ps, product_key(ps, states));
+  return 0;
+}
+
+/*
+ * Walks the transition BDDs of all components together, splitting on the
+ * lowest variable tested by any of them, and reaches the product state at
+ * each combination of leaves.
+ */
+static int product_step(product_search *ps, bdd_ptr *p) {
+  bdd_ptr next[PRODUCT_MAX];
+  int states[PRODUCT_MAX];
+  unsigned index = 0;
+  int i, branch, split = 0;
+
+  for (i = 0; i < ps->n; i++) {
+    if (!bdd_is_leaf(ps->M[i]->bddm, p[i])) {
+      if (!split || bdd_ifindex(ps->M[i]->bddm, p[i]) < index)
+        index = bdd_ifindex(ps->M[i]->bddm, p[i]);
+      split = 1;
+    }
+  }
+  if (!split) {
+    for (i = 0; i < ps->n; i++)
+      states[i] = bdd_leaf_value(ps->M[i]->bddm, p[i]);
+    return ps->reach(ps, states);
+  }
+  for (branch = 0; branch < 2; branch++) {
+    for (i = 0; i < ps->n; i++) {
+      if (!bdd_is_leaf(ps->M[i]->bddm, p[i]) && bdd_ifindex(ps->M[i]->bddm, p[i]) == index)
+        next[i] = branch ? bdd_else(ps->M[i]->bddm, p[i]) : bdd_then(ps->M[i]->bddm, p[i]);
+      else
+        next[i] = p[i];
+    }
+    if (product_step(ps, next))
+      return 1;
+  }
+  return 0;
+}
+
+static void product_init(product_search *ps, int n, DFA **M, int (*reach)(product_search *, int *)) {
+  int i;
+  ps->n = n;
+  for (i = 0; i < n; i++)
+    ps->M[i] = M[i];
+  ps->reach = reach;
+  ps->set = NULL;
+  ps->set_size = 0;
+  ps->set_used = 0;
+  ps->parent = NULL;
+  ps->queue_size = 256;
+  ps->queue = (unsigned long long *) malloc(ps->queue_size * sizeof(unsigned long long));
+  ps->head = ps->tail = 0;
+}
+
+/*
+ * returns 1 if the reach function stopped the search
+ */
+static int product_explore(product_search *ps) {
+  bdd_ptr p[PRODUCT_MAX];
+  int states[PRODUCT_MAX];
+  unsigned long long key;
+  int i, found;
+
+  for (i = 0; i < ps->n; i++)
+    states[i] = ps->M[i]->s;
+  found = ps->reach(ps, states);
+  while (!found && ps->head < ps->tail) {
+    key = ps->queue[ps->head++];
+    for (i = ps->n - 1; i >= 0; i--) {
+      p[i] = ps->M[i]->q[key % (unsigned long long) ps->M[i]->ns];
+      key /= (unsigned long long) ps->M[i]->ns;
+    }
+    found = product_step(ps, p);
+  }
+
+  free(ps->set);
+  free(ps->parent);
+  free(ps->queue);
+  return found;
+}
+
+/*
+ * returns 1 if a string leads every M[i] to a state with status want[i]
+ * (1 accepting, -1 rejecting)
+ */
+static int product_reachable(int n, DFA **M, int *want) {
+  product_search ps;
+  int i;
+
+  product_init(&ps, n, M, product_reach_wanted);
+  for (i = 0; i < n; i++)
+    ps.want[i] = want[i];
+  return product_explore(&ps);
+}
+
+/*
+ * returns 1 if L(M1) and L(M2) share a string, stops at the first one
+ */
+int check_intersection(DFA *M1, DFA *M2, int var, int *indices) {
+  DFA *M[2];
+  int want[2] = { 1, 1 };
+
+  if (!M1 || !M2) {
+    return 0;
+  }
+  M[0] = M1;
+  M[1] = M2;
+  return product_reachable(2, M, want);
+}
+
+int check_equivalence(DFA *M1, DFA *M2, int var, int *indices) {
+  product_search ps;
+  DFA *M[3];
+  int result, i;
+
+  if (M1 == M2) {
+      return 1;
+  }
+  if (!M1 || !M2) {
+      return 0;
+  }
+  M[0] = M1;
+  M[1] = M2;
+  M[2] = dfaAllStringASCIIExceptReserveWords(var, indices);
+  product_init(&ps, 3, M, product_reach_equivalent);
+  ps.parent = (int *) malloc((M1->ns + M2->ns) * sizeof(int));
+  for (i = 0; i < M1->ns + M2->ns; i++)
+    ps.parent[i] = i;
+  result = 1 - product_explore(&ps);
+  dfaFree(M[2]);
   return result;
 }
 
-int check_equivalence(M1, M2, var, indices)
+/*
+ * check_equivalence by building both implications, their intersection and
+ * its negation, kept as the reference for equivbench
+ */
+int check_equivalence_product(M1, M2, var, indices)
   DFA *M1;DFA *M2;int var;int *indices; {
   DFA *M[4];
   int result, i;
@@ -3310,18 +3912,99 @@ int check_equivalence(M1, M2, var, indices)
  * returns true if M2 includes M1 i.e.
  * L(M1) subset_of L(M2)
  */
-int check_inclusion(M1, M2, var, indices)
-  DFA *M1;DFA *M2;int var;int *indices; {
-  DFA *M, *tmp;
+int check_inclusion(DFA *M1, DFA *M2, int var, int *indices) {
+  DFA *M[3];
+  int want[3] = { 1, -1, 1 };
   int result;
-  tmp = dfa_negate(M2, var, indices);
-  M = dfa_intersect(M1, tmp);
-  dfaFree(tmp); tmp = NULL;
-  result = check_emptiness(M, var, indices);
-  dfaFree(M);
+
+  if (!M1) {
+    return 1;
+  }
+  if (!M2) {
+    return check_emptiness(M1, var, indices);
+  }
+  // A string of M1 rejected by M2, as in dfa_negate reserved characters
+  // do not count
+  M[0] = M1;
+  M[1] = M2;
+  M[2] = dfaAllStringASCIIExceptReserveWords(var, indices);
+  result = 1 - product_reachable(3, M, want);
+  dfaFree(M[2]);
   return result;
 }
 
+#define FINGERPRINT_SEED  14695981039346656037ULL
+#define FINGERPRINT_PRIME 1099511628211ULL
+
+static unsigned long long fingerprint_mix(unsigned long long h, unsigned long long v) {
+  h ^= v;
+  h *= FINGERPRINT_PRIME;
+  h ^= (h >> 32);
+  return h;
+}
+
+/*
+ * Hashes the transition BDD of one state, visiting then before else.
+ * Leaves are hashed by the canonical (BFS) number of their target state,
+ * which is assigned and queued the first time the state is reached.
+ */
+static unsigned long long fingerprint_bdd(bdd_manager *bddm, bdd_ptr p, unsigned long long h,
+                                          int *canon, int *queue, int *tail) {
+  int s;
+  if (bdd_is_leaf(bddm, p)) {
+    s = bdd_leaf_value(bddm, p);
+    if (canon[s] == -1) {
+      canon[s] = *tail;
+      queue[(*tail)++] = s;
+    }
+    h = fingerprint_mix(h, 'L');
+    return fingerprint_mix(h, (unsigned long long) canon[s]);
+  }
+  h = fingerprint_mix(h, 'N');
+  h = fingerprint_mix(h, (unsigned long long) bdd_ifindex(bddm, p));
+  h = fingerprint_bdd(bddm, bdd_then(bddm, p), h, canon, queue, tail);
+  return fingerprint_bdd(bddm, bdd_else(bddm, p), h, canon, queue, tail);
+}
+
+/*
+ * returns a hash of the language of M, i.e.
+ * L(M1) == L(M2) implies dfa_fingerprint(M1) == dfa_fingerprint(M2)
+ * The minimal DFA is renumbered in BFS order from the start state and the
+ * (reduced, hence canonical) transition BDDs are hashed in that order.
+ * Different fingerprints mean different languages, equal fingerprints
+ * still need check_equivalence to rule out a collision.
+ */
+unsigned long long dfa_fingerprint(DFA *M) {
+  DFA *min;
+  int *canon, *queue;
+  int head = 0, tail = 0, i, s;
+  unsigned long long h = FINGERPRINT_SEED;
+
+  if (!M) {
+    return 0;
+  }
+
+  min = dfaMinimize(M);
+  canon = (int *) malloc(min->ns * sizeof(int));
+  queue = (int *) malloc(min->ns * sizeof(int));
+  for (i = 0; i < min->ns; i++)
+    canon[i] = -1;
+
+  canon[min->s] = 0;
+  queue[tail++] = min->s;
+  h = fingerprint_mix(h, (unsigned long long) min->ns);
+  while (head < tail) {
+    s = queue[head++];
+    h = fingerprint_mix(h, (unsigned long long) (min->f[s] + 2));
+    h = fingerprint_bdd(min->bddm, min->q[s], h, canon, queue, &tail);
+  }
+
+  free(canon);
+  free(queue);
+  dfaFree(min);
+  return h;
+}
+
 /**
  * converts mona binary char representation into an ascii char
  * Example: input: "01000001" --> output: 'A'
@@ -3449,18 +4132,7 @@ int checkOnlyEmptyString(DFA *M, int var, int* indices){
 
 
 int isTransitionIncludeChar(const char *str, char target, int var){
-  int i;
-  boolean result;
-  result = TRUE;
-  char* targetS = bintostr(target, var);
-  for(i=0; i<var; i++){
-    if(str[i]!='X' && str[i]!=targetS[i]){
-      result = FALSE;
-      break;
-    }
-  }
-  free(targetS);
-  return result;
+  return packed_label_includes(packed_label_from_string(str, var), target);
 }
 
 
@@ -3468,10 +4140,8 @@ int isTransitionIncludeChar(const char *str, char target, int var){
  * checks if string element_of L(M)
  */
 int checkMembership(DFA* M, char* string, int var, int* indices){
-  int length, i, j, endState;
+  int length, i, endState;
   paths state_paths, pp;
-  trace_descr tp;
-  char* symbol;
   boolean found;
 
   assert(string != NULL);
@@ -3481,28 +4151,13 @@ int checkMembership(DFA* M, char* string, int var, int* indices){
   if (length == 0)
     return checkEmptyString(M);
 
-  symbol = (char *) malloc((var + 1) * sizeof(char));
   endState = M->s;
 
   for (i = 0; i < length; i++){
     found = FALSE;
     state_paths = pp = make_paths(M->bddm, M->q[endState]);
     while (pp) {
-        for (j = 0; j < var; j++) {
-          //the following for loop can be avoided if the indices are in order
-          for (tp = pp->trace; tp && (tp->index != indices[j]); tp
-              = tp->next)
-            ;
-          if (tp) {
-            if (tp->value)
-              symbol[j] = '1';
-            else
-              symbol[j] = '0';
-          } else
-            symbol[j] = 'X';
-        }
-        symbol[var] = '\0';
-        if (isTransitionIncludeChar(symbol, string[i], var)){
+        if (packed_label_includes(packed_label(pp->trace, var, indices), string[i])){
           endState = pp->to;
           found = TRUE;
           break;
@@ -3514,8 +4169,6 @@ int checkMembership(DFA* M, char* string, int var, int* indices){
     assert(found);
   }
 
-  free(symbol);
-
   return ((M->f[endState])==1) ? 1 : 0;;
 }
 
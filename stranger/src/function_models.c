@@ -437,50 +437,28 @@ void transition_print_ilt(struct transition_list_type *list) {
 */
 struct transition_list_type *getTransitionRelationMatrix(DFA* M, char *lambda,
                                                          int var, int* indices) {
-    paths state_paths, pp;
-    trace_descr tp;
-    int j;
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, indices);
     int sink = find_sink(M);
-    char *symbol = (char *) malloc((var+1)*sizeof(char));
+    unsigned long long lambdaChar = packed_label_from_string(lambda, var).value;
     struct transition_list_type *finallist = NULL;
+    unsigned t;
     int i;
     for (i = 0; i < M->ns; i++) {
-
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
-
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[j] = '\0';
-                if (isIncludeLambda(symbol, lambda, var)) {
-                    finallist = transition_enqueue(finallist, i, pp->to);
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                if (packed_label_includes(table->labels[t], lambdaChar)) {
+                    finallist = transition_enqueue(finallist, i, table->to[t]);
                 }
 
             }
-            pp = pp->next;
-        } //end while
-
-        kill_paths(state_paths);
+        }
     }
+    dfaReleaseTransitionTable(table);
 
 //	printf("list of states reachable on \\s:");
 //	transition_print_ilt(finallist);
 //	printf("\n");
 
-    free(symbol);
     return finallist;
 }
 
@@ -539,10 +517,11 @@ DFA *dfaRightTrim(DFA *M, char c, int var, int *oldindices) {
 
     int *indices = oldindices; //indices is updated if you need to add auxiliary bits
 
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table;
+    PackedLabel label;
 
     int i, j, z, k;
+    unsigned t;
 
     char *exeps;
     int *to_states;
@@ -559,8 +538,10 @@ DFA *dfaRightTrim(DFA *M, char c, int var, int *oldindices) {
     char *symbol;
 
 
+    table = dfaAcquireTransitionTable(M, var, indices);
     states = states_reach_accept_lambda(M, lambda, var, indices);
     if (states == NULL ){
+        dfaReleaseTransitionTable(table);
         free(lambda);
         return dfaCopy(M);
     }
@@ -598,38 +579,24 @@ DFA *dfaRightTrim(DFA *M, char c, int var, int *oldindices) {
 
     // for each original state
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[var] = '\0';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 // first copy to original destination without removing lambda
-                to_states[k] = pp->to;
+                to_states[k] = table->to[t];
                 for (j = 0; j < var; j++)
                     exeps[k * (len + 1) + j] = symbol[j];
                 exeps[k * (len + 1) + var] = '0';
                 exeps[k * (len + 1) + len] = '\0';
                 k++;
 
-                split_char = check_value(states, pp->to);
+                split_char = check_value(states, table->to[t]);
                 if (split_char == TRUE) {
                     // second copy to new accept state after removing lambda
-                    if (!isIncludeLambda(symbol, lambda, var)) {
+                    if (!packed_label_includes(label, c)) {
                         // no lambda send as it is
                         to_states[k] = new_accept_state; // destination new accept state
                         for (j = 0; j < var; j++)
@@ -656,17 +623,15 @@ DFA *dfaRightTrim(DFA *M, char c, int var, int *oldindices) {
                     }
                 }
             }
-            pp = pp->next;
-        } //end while
+        } //end for
 
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--)
             dfaStoreException(b, to_states[k], exeps + k * (len + 1));
         dfaStoreState(b, new_sink);
         statuces[i] = '-';
-
-        kill_paths(state_paths);
     } // end for each original state
+    dfaReleaseTransitionTable(table);
 
     // add new accept state
     dfaAllocExceptions(b, 0);
@@ -726,10 +691,11 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
     char* lambda = bintostr(c, var);
     int *indices = oldIndices; //indices is updated if you need to add auxiliary bits
     
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table;
+    PackedLabel label;
     
     int i, j, k, z;
+    unsigned t;
     
     char *exeps;
     int *to_states;
@@ -748,6 +714,7 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
 
    
     symbol=(char *)malloc((var+1)*sizeof(char));
+    table = dfaAcquireTransitionTable(M, var, oldIndices);
     
     /**************************************************
      *   Add a new start state with space self loop   *
@@ -803,36 +770,23 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
     //trim. Example: rightTrim(\s*(ab)*)= (ab)*|\s*(ab)+
     if (M->f[M->s] == 1){
         //construct the added paths for the initial state
-        state_paths = pp = make_paths(M->bddm, M->q[M->s]);
         //printf("\n\n INIT %d \n\n", M1->s);
         k=0;
         
         /******    Copy transitions from original start state to new one  ********/
-        //reset pp
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp = tp->next);
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[j] = '\0';
+        for (t = table->first[M->s]; t < table->first[M->s + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
             
                 //case -1- copying a transition from old start to a state that is not accepting
                 //Transition may have lambda on them
-                if (M->f[pp->to] != 1){
+                if (M->f[table->to[t]] != 1){
                     //if start state does not go to and accept state
                     
                     //start state will have lambde on a self cycle so take care of lambda to other states
-                    if (!isIncludeLambda(symbol, lambda, var)) { // Only Consider Non-lambda case
-                        to_states[k] = pp->to + shift;
+                    if (!packed_label_includes(label, c)) { // Only Consider Non-lambda case
+                        to_states[k] = table->to[t] + shift;
                         for (j = 0; j < var; j++)
                             exeps[k * (len + 1) + j] = symbol[j];
 #if MORE_WORDS_LESS_NDTRANS == 1
@@ -849,7 +803,7 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
                         for (i = 0; i < size; i++)
                         {
                             //						printf("%s, ", charachters[i]);
-                            to_states[k] = pp->to + shift;
+                            to_states[k] = table->to[t] + shift;
                             for (j = 0; j < var; j++)
                                 exeps[k * (len + 1) + j] = charachters[i][j];
                             exeps[k * (len + 1) + j] = 'X';//<-- only if len > var this will matter
@@ -858,14 +812,14 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
                             k++;
                         }
                         //					printf("\n");
-                        to_states[k] = pp->to + shift;
+                        to_states[k] = table->to[t] + shift;
                         for (j = 0; j < var; j++)
                             exeps[k * (len + 1) + j] = lambda[j];
                         exeps[k * (len + 1) + j] = '0';//<-- only if len > var this will matter
                         exeps[k * (len + 1) + len] = '\0';
                         k++;
 #else
-                        to_states[k] = pp->to + shift;
+                        to_states[k] = table->to[t] + shift;
                         for (j = 0; j < var; j++)
                             exeps[k * (len + 1) + j] = symbol[j];
                         exeps[k * (len + 1) + j] = '0';//<-- only if len > var this will matter
@@ -876,14 +830,14 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
                 }
                 else {
                     //copy -1- to original accept state
-                    to_states[k] = pp->to + shift;
+                    to_states[k] = table->to[t] + shift;
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = symbol[j];
                     exeps[k * (len + 1) + j] = '0';//<-- only if len > var this will matter
                     exeps[k * (len + 1) + len] = '\0';
                     k++;
                     //copy -2- to new accept state. Do not copy lambda transitions (reason is complex but true)
-                    if (!isIncludeLambda(symbol, lambda, var)) { // Only Consider Non-lambda case
+                    if (!packed_label_includes(label, c)) { // Only Consider Non-lambda case
                         //copy -2- to new accept state no lambda deletion
                         to_states[k] = newAcceptState;
                         for (j = 0; j < var; j++)
@@ -910,9 +864,7 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
                     }
                 }
             } //end if
-            pp = pp->next;
-        } //end while
-        kill_paths(state_paths);
+        } //end for
         
         //add self cycle on lambda
         to_states[k] = newStart;
@@ -945,29 +897,16 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
     //copy transition to new accept state excep
     //transitions on space
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 //case -1- copying a transition from old start to a state that is not accepting
                 //Transition may have lambda on them
-                if (M->f[pp->to] != 1){
+                if (M->f[table->to[t]] != 1){
                     //start state will have lambde on a self cycle so take care of lambda to other states
-                    to_states[k] = pp->to + shift;
+                    to_states[k] = table->to[t] + shift;
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = symbol[j];
 #if MORE_WORDS_LESS_NDTRANS == 1
@@ -980,14 +919,14 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
                 }
                 else {
                     //copy -1- to original accept state
-                    to_states[k] = pp->to + shift;
+                    to_states[k] = table->to[t] + shift;
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = symbol[j];
                     exeps[k * (len + 1) + j] = '0';//<-- only if len > var this will matter
                     exeps[k * (len + 1) + len] = '\0';
                     k++;
                     //copy -2- to new accept state. Do not copy lambda transitions (reason is complex but true)
-                    if (!isIncludeLambda(symbol, lambda, var)) { // Only Consider Non-lambda case
+                    if (!packed_label_includes(label, c)) { // Only Consider Non-lambda case
                         //copy -2- to new accept state no lambda deletion
                         to_states[k] = newAcceptState;
                         for (j = 0; j < var; j++)
@@ -1014,9 +953,7 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
                     }
                 }                
             }
-            pp = pp->next;
-        } //end while
-        kill_paths(state_paths);
+        } //end for
         
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--)
@@ -1025,6 +962,7 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
         statuces[i + shift] = '-';
 		
     }
+    dfaReleaseTransitionTable(table);
     
     /*************************************************
      *       Add new accept state                    *
@@ -1104,55 +1042,40 @@ DFA *dfaPreRightTrim(DFA *M, char c, int var, int *oldIndices)
  */
 struct int_list_type *reachable_states_lambda_in_nout1(DFA *M, char *lambda, int var, int* indices){
 
-    paths state_paths, pp;
-    trace_descr tp;
-    int j, current;
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, indices);
+    unsigned t, last;
+    int current;
     int sink = find_sink(M);
-    char *symbol;
+    unsigned long long lambdaChar = packed_label_from_string(lambda, var).value;
     struct int_list_type *finallist=NULL;
     if(_FANG_DFA_DEBUG)dfaPrintVerbose(M);
-    symbol=(char *)malloc((var+1)*sizeof(char));
     current = 0;
     boolean keeploop = TRUE;
     while (keeploop){
         keeploop = FALSE;
-        state_paths = pp = make_paths(M->bddm, M->q[current]);
-        while (pp && (!keeploop)) {
-            if(pp->to != sink){
-                // construct transition from current to pp->to and store it in symbol
-                for (j = 0; j < var; j++) {
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp = tp->next);
-                    if (tp) {
-                        if (tp->value) symbol[j]='1';
-                        else symbol[j]='0';
-                    }
-                    else
-                        symbol[j]='X';
-
-                }
-                symbol[j]='\0';
-                // if transition from current state to pp->to state is on labmda
-                if(isIncludeLambda(symbol, lambda, var)){
+        last = table->first[current + 1];
+        for (t = table->first[current]; t < last && (!keeploop); t++) {
+            if(table->to[t] != sink){
+                // if transition from current state to its target state is on labmda
+                if(packed_label_includes(table->labels[t], lambdaChar)){
                     //if not added before
-                    if (!check_value(finallist, pp->to)){
+                    if (!check_value(finallist, table->to[t])){
                         if (current == 0)
                             finallist = enqueue(finallist, current);
-                        finallist = enqueue(finallist, pp->to);
-                        current = pp->to;
+                        finallist = enqueue(finallist, table->to[t]);
+                        current = table->to[t];
                         keeploop = TRUE;
                     }
                 }
             }
-            pp = pp->next;
         }
-        kill_paths(state_paths);
     }
+    dfaReleaseTransitionTable(table);
     if (finallist!=NULL){
 //		printf("list of states reachable on \\s:");
 //		print_ilt(finallist);
 //		printf("\n");
     }
-    free(symbol);
     return finallist;
 }
 
@@ -1276,10 +1199,11 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
 
     int *indices = oldindices; //indices is updated if you need to add auxiliary bits
 
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table;
+    PackedLabel label;
 
     int i, j, z, k;
+    unsigned t;
 
     char *exeps;
     int *to_states;
@@ -1297,8 +1221,10 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
     char *symbol;
 
 
+    table = dfaAcquireTransitionTable(M, var, indices);
     states = reachable_states_lambda_in_nout1(M, lambda, var, indices);
     if(states == NULL){
+        dfaReleaseTransitionTable(table);
         free(lambda);
         return dfaCopy(M);
     }
@@ -1343,25 +1269,13 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
     //setup for the initial state
     tmpState = states->head;
     for (z = 1; z <= states->count; z++) {
-        state_paths = pp = make_paths(M->bddm, M->q[tmpState->value]);
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp = tp->next);
-
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[j] = '\0';
+        for (t = table->first[tmpState->value]; t < table->first[tmpState->value + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
 
-                if (!isIncludeLambda(symbol, lambda, var)) { // Only Consider Non-lambda case
-                    to_states[k] = pp->to + 1;
+                if (!packed_label_includes(label, c)) { // Only Consider Non-lambda case
+                    to_states[k] = table->to[t] + 1;
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = symbol[j];
 
@@ -1377,7 +1291,7 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
                     for (i = 0; i < size; i++)
                     {
 //						printf("%s, ", charachters[i]);
-                        to_states[k] = pp->to + 1;
+                        to_states[k] = table->to[t] + 1;
                         for (j = 0; j < var; j++)
                             exeps[k * (len + 1) + j] = charachters[i][j];
 
@@ -1392,9 +1306,7 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
 //					printf("\n");
                 }
             } //end if
-            pp = pp->next;
-        } //end while
-        kill_paths(state_paths);
+        } //end for
         tmpState = tmpState->next;
     } //end for
 
@@ -1413,27 +1325,14 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
     //for the rest of states (shift one state)
     for (i = 0; i < M->ns; i++) {
 
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
 
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
 
-                to_states[k] = pp->to + 1;
+                to_states[k] = table->to[t] + 1;
                 for (j = 0; j < var; j++)
                     exeps[k * (len + 1) + j] = symbol[j];
                 for (j = var; j < len; j++) { //set to xxxxxxxx100
@@ -1443,8 +1342,7 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
                 k++;
 
             }
-            pp = pp->next;
-        } //end while
+        } //end for
 
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--)
@@ -1455,8 +1353,8 @@ DFA *dfaLeftTrim(DFA *M, char c, int var, int *oldindices)
             statuces[i + 1] = '+';
         else
             statuces[i + 1] = '-';
-        kill_paths(state_paths);
     }
+    dfaReleaseTransitionTable(table);
 
     // Check if a new sink is needed
     if (sink < 0) {
@@ -1512,10 +1410,11 @@ DFA *dfaPreLeftTrim(DFA *M, char c, int var, int *oldIndices)
     char* lambda = bintostr(c, var);
     int *indices = oldIndices; //indices is updated if you need to add auxiliary bits
     
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table;
+    PackedLabel label;
     
     int i, j, k;
+    unsigned t;
     
     char *exeps;
     int *to_states;
@@ -1588,6 +1487,7 @@ DFA *dfaPreLeftTrim(DFA *M, char c, int var, int *oldIndices)
         *   Add a new start state with space self loop   *
         **************************************************/
     
+    table = dfaAcquireTransitionTable(M, var, indices);
     max_exeps=1 << var; //maybe exponential
 
     
@@ -1607,26 +1507,14 @@ DFA *dfaPreLeftTrim(DFA *M, char c, int var, int *oldIndices)
     
     /******    Copy transitions from original start state to new one  ********/
     //construct the added paths for the initial state
-    state_paths = pp = make_paths(M->bddm, M->q[M->s]);
     k=0;
-    while (pp) {
-        if (pp->to != sink) {
-            for (j = 0; j < var; j++) {
-                //the following for loop can be avoided if the indices are in order
-                for (tp = pp->trace; tp && (tp->index != indices[j]); tp = tp->next);
-                
-                if (tp) {
-                    if (tp->value)
-                        symbol[j] = '1';
-                    else
-                        symbol[j] = '0';
-                } else
-                    symbol[j] = 'X';
-            }
-            symbol[j] = '\0';
+    for (t = table->first[M->s]; t < table->first[M->s + 1]; t++) {
+        if (table->to[t] != sink) {
+            label = table->labels[t];
+            packed_label_to_string(label, var, symbol);
             
-            if (!isIncludeLambda(symbol, lambda, var)) { // Only Consider Non-lambda case
-                to_states[k] = pp->to + 1;
+            if (!packed_label_includes(label, c)) { // Only Consider Non-lambda case
+                to_states[k] = table->to[t] + 1;
                 for (j = 0; j < var; j++)
                     exeps[k * (var + 1) + j] = symbol[j];
                 exeps[k * (var + 1) + var] = '\0';
@@ -1637,7 +1525,7 @@ DFA *dfaPreLeftTrim(DFA *M, char c, int var, int *oldIndices)
                 for (i = 0; i < size; i++)
                 {
                     //						printf("%s, ", charachters[i]);
-                    to_states[k] = pp->to + 1;
+                    to_states[k] = table->to[t] + 1;
                     for (j = 0; j < var; j++)
                         exeps[k * (var + 1) + j] = charachters[i][j];
                     exeps[k * (var + 1) + var] = '\0';
@@ -1647,9 +1535,7 @@ DFA *dfaPreLeftTrim(DFA *M, char c, int var, int *oldIndices)
                 //					printf("\n");
             }
         } //end if
-        pp = pp->next;
-    } //end while
-    kill_paths(state_paths);
+    } //end for
     
     //add self cycle on lambda to new start state
     to_states[k] = 0;
@@ -1679,35 +1565,21 @@ DFA *dfaPreLeftTrim(DFA *M, char c, int var, int *oldIndices)
     //for the rest of states (shift one state)
     for (i = 0; i < M->ns; i++) {
         
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 
-                to_states[k] = pp->to + 1;
+                to_states[k] = table->to[t] + 1;
                 for (j = 0; j < var; j++)
                     exeps[k * (var + 1) + j] = symbol[j];
                 exeps[k * (var + 1) + var] = '\0';
                 k++;
                 
             }
-            pp = pp->next;
-        } //end while
+        } //end for
         
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--)
@@ -1718,8 +1590,8 @@ DFA *dfaPreLeftTrim(DFA *M, char c, int var, int *oldIndices)
             statuces[i + 1] = '+';
         else
             statuces[i + 1] = '-';
-        kill_paths(state_paths);
     }
+    dfaReleaseTransitionTable(table);
 
         // Check if a new sink is needed
     if (sink < 0) {
@@ -2020,273 +1892,326 @@ void getUpperCaseCharsHelper(char** result, char* transitions, int* indexInResul
     }
 
 }
-/**
+/*
+ * Fills next[i * (1 << var) + c] with the state reached from state i on
+ * character c, each transition of table only visits the characters on its
+ * label.
  */
-void getLowerUpperCaseCharsPrePostHelper(char** result, char* transitions, int* indexInResult, int currentBit, int var, char* prev, boolean lowerCase, boolean preImage){
-    int i;
-    if (transitions[currentBit] == 'X')
-    {
-        transitions[currentBit] = '0';
-        getLowerUpperCaseCharsPrePostHelper(result, transitions, indexInResult, currentBit, var, prev, lowerCase, preImage);
-        transitions[currentBit] = '1';
-        getLowerUpperCaseCharsPrePostHelper(result, transitions, indexInResult, currentBit, var, prev, lowerCase, preImage);
-        transitions[currentBit] = 'X';
-    }
-    // things that do not contain lower case
-    else if ( (transitions[0] == '1' && currentBit == 0) ||
-              (transitions[1] == '0' && currentBit == 1) ||
-              (currentBit == 2 && ((transitions[2] == '1' && lowerCase) || (transitions[2] == '0' && !lowerCase))) ||
-              (transitions[5] == '1' && transitions[3] == '1' && currentBit == 5) ||
-              (transitions[7] ==  transitions[3] && currentBit == 7)
-        )
-    {
-        result[*indexInResult] = (char*) malloc((var+2)*(sizeof (char)));
-        for (i = 0; i < var; i++){
-            result[*indexInResult][i] = transitions[i];
+static int *table_char_transitions(TransitionTable *table, int var, int sink){
+    int numOfChars = 1 << var;
+    int i, c;
+    unsigned t;
+    unsigned long long free_bits, s;
+    int *next = (int *) malloc(table->ns * numOfChars * sizeof(int));
+
+    for (i = 0; i < table->ns; i++){
+        int *row = next + i * numOfChars;
+        for (c = 0; c < numOfChars; c++)
+            row[c] = sink;
+        for (t = table->first[i]; t < table->first[i + 1]; t++){
+            // enumerate the values of the bits which are X on the label
+            free_bits = ~table->labels[t].mask & (unsigned long long) (numOfChars - 1);
+            s = 0;
+            do {
+                row[table->labels[t].value | s] = table->to[t];
+                s = (s - free_bits) & free_bits;
+            } while (s != 0);
         }
-        result[*indexInResult][var] = '0';//extrabit
-        result[*indexInResult][var+1] = '\0';
-        (*indexInResult)++;
     }
-    else if ( (transitions[3] != transitions[4] && (currentBit == 4 )) ||
-              (transitions[3] != transitions[6] && currentBit == 6 ) ||
-              (transitions[3] != transitions[7] && currentBit == 7 ) ||
-              (transitions[5] == '1' && transitions[3] ==  '0' && currentBit == 5)
-        ){
-        result[*indexInResult] = (char*) malloc((var+2)*(sizeof(char)));
-        for (i = 0; i < var; i++)
-            result[*indexInResult][i] = transitions[i];
-        // only difference between capital and small is bit number 2
-        if (!preImage){
-            if (lowerCase)
-                result[*indexInResult][2] = '1';
-            else
-                result[*indexInResult][2] = '0';
-        }
-        // extrabit should be 1 since we may already have same small letter originally with 0
-        result[*indexInResult][var] = '1';//extrabit
-        result[*indexInResult][var+1] = '\0';
-        (*indexInResult)++;
-        if (preImage){
-            result[*indexInResult] = (char*) malloc((var+2)*(sizeof(char)));
-            for (i = 0; i < var; i++)
-                result[*indexInResult][i] = transitions[i];
-            // only difference between capital and small is bit number 2
-            if (lowerCase)
-                result[*indexInResult][2] = '1';
-            else
-                result[*indexInResult][2] = '0';
-            // extrabit should be 1 since we may already have same small letter originally with 0
-            result[*indexInResult][var] = '1';//extrabit
-            result[*indexInResult][var+1] = '\0';
-            (*indexInResult)++;
+    return next;
+}
+
+/*
+ * Applies the character homomorphism map, which has (1 << var) entries, to
+ * M in a single pass over its transitions:
+ * L(result) = { map(c_1)..map(c_n) | c_1..c_n element_of L(M) }
+ * Characters with the same image may lead to different states, those
+ * transitions are told apart by extra bits which are projected away.
+ */
+DFA *dfa_map_chars(DFA *M, int var, int *oldIndices, const unsigned char *map){
+    if (check_emptiness_minimized(M)){
+        return dfaCopy(M);
+    }
+    int numOfChars = 1 << var;
+    int i, c, d, j, k, a, n;
+    int sink = find_sink(M);
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, oldIndices);
+    int *next = table_char_transitions(table, var, sink);
+    dfaReleaseTransitionTable(table);
+
+    /**************      PREPROCESSING PHASE     ******************/
+    // The characters with image d are source[start[d]] .. source[start[d + 1] - 1]
+    int *start = (int *) calloc(numOfChars + 1, sizeof(int));
+    int *source = (int *) malloc(numOfChars * sizeof(int));
+    for (c = 0; c < numOfChars; c++)
+        start[map[c] + 1]++;
+    for (d = 0; d < numOfChars; d++)
+        start[d + 1] += start[d];
+    int *fill = (int *) malloc(numOfChars * sizeof(int));
+    memcpy(fill, start, numOfChars * sizeof(int));
+    for (c = 0; c < numOfChars; c++)
+        source[fill[map[c]]++] = c;
+    free(fill);
+
+    // The distinct targets of state i on image d are
+    // targets[i * numOfChars + start[d]] .. + count[i * numOfChars + d] - 1
+    int *targets = (int *) malloc(M->ns * numOfChars * sizeof(int));
+    int *count = (int *) malloc(M->ns * numOfChars * sizeof(int));
+    int maxAlternatives = 1;
+    for (i = 0; i < M->ns; i++){
+        for (d = 0; d < numOfChars; d++){
+            int *alternatives = targets + i * numOfChars + start[d];
+            n = 0;
+            for (j = start[d]; j < start[d + 1]; j++){
+                int to = next[i * numOfChars + source[j]];
+                if (to == sink)
+                    continue;
+                for (a = 0; a < n && alternatives[a] != to; a++)
+                    ;
+                if (a == n)
+                    alternatives[n++] = to;
+            }
+            count[i * numOfChars + d] = n;
+            if (n > maxAlternatives)
+                maxAlternatives = n;
         }
     }
-    else{
-        if (currentBit < (var-1)){
-            getLowerUpperCaseCharsPrePostHelper(result, transitions, indexInResult, currentBit + 1, var, prev, lowerCase, preImage);
+    int extraBits = 0;
+    while ((1 << extraBits) < maxAlternatives)
+        extraBits++;
+
+    int ns = M->ns;
+    int new_sink;
+    if (sink < 0) {
+        // Additional state for the new sink
+        new_sink = ns++;
+    } else {
+        new_sink = sink;
+    }
+
+    /**************      BUILDING AUTOMATON PHASE     ******************/
+    int len = var + extraBits;
+    int *indices = allocateArbitraryIndex(len);
+    char *exeps = (char *) malloc(numOfChars * (len + 1) * sizeof(char));
+    int *to_states = (int *) malloc(numOfChars * sizeof(int));
+    char *statuces = (char *) malloc((ns + 1) * sizeof(char));
+    char **charBin = (char **) malloc(numOfChars * sizeof(char *));
+    for (c = 0; c < numOfChars; c++)
+        charBin[c] = bintostr(c, var);
+    DFABuilder *b = dfaSetup(ns, len, indices);
+
+    for (i = 0; i < M->ns; i++){
+        k = 0;
+        for (d = 0; d < numOfChars; d++){
+            for (a = 0; a < count[i * numOfChars + d]; a++){
+                char *exep = exeps + k * (len + 1);
+                to_states[k] = targets[i * numOfChars + start[d] + a];
+                for (j = 0; j < var; j++)
+                    exep[j] = charBin[d][j];
+                // alternative a in binary on the extra bits
+                for (j = 0; j < extraBits; j++)
+                    exep[var + j] = ((a >> (extraBits - 1 - j)) & 1) ? '1' : '0';
+                exep[len] = '\0';
+                k++;
+            }
         }
+        dfaAllocExceptions(b, k);
+        for (k--; k >= 0; k--)
+            dfaStoreException(b, to_states[k], exeps + k * (len + 1));
+        dfaStoreState(b, new_sink);
+        statuces[i] = (M->f[i] == 1) ? '+' : '-';
     }
 
-}
+    if (sink < 0) {
+        dfaAllocExceptions(b, 0);
+        dfaStoreState(b, new_sink);
+        statuces[new_sink] = '-';
+    }
+    statuces[ns] = '\0';
+    DFA *result = dfaBuild(b, statuces);
 
-/**
- * returns same chars in transitions unless char is capital in which case it is converted into small
- * or visa versa
- * examples:
- * A=01000001 -> a=[011000011]
- * {@, A, B, C ,D, E, F, G}=01000XXX -> {@, a, b, c, d, e, f, g}=[010000000, 011000011, 0110001X1, 011001XX1]
- * extrabit will be used. 0 for original letters, 1 for new small letters (converted from capital) to differentiate from original small chars
- */
-void getLowerUpperCaseCharsPrePost(char* transitions, int var, char** result, int* pSize, boolean lowerCase, boolean preImage){
-    int indexInResult = 0;
-    char* prev = (char*) malloc(var*(sizeof(char)));
-    getLowerUpperCaseCharsPrePostHelper(result, transitions, &indexInResult, 0, var, prev, lowerCase, preImage);
-    *pSize = indexInResult;
+    free(exeps);
+    free(to_states);
+    free(statuces);
+    free(indices);
+    free(targets);
+    free(count);
+    free(start);
+    free(source);
+    free(next);
+    for (c = 0; c < numOfChars; c++)
+        free(charBin[c]);
+    free(charBin);
+
+    DFA *tmp;
+    if( DEBUG_SIZE_INFO )
+        printf("\t peak : map_chars : states %d : bddnodes %u : before projection \n", result->ns, bdd_size(result->bddm) );
+    for (j = len - 1; j >= var; j--){
+        tmp = dfaProject(result, (unsigned) j);
+        dfaFree(result);
+        result = tmp;
+    }
+    tmp = dfaMinimize(result);
+    dfaFree(result);
+    if( DEBUG_SIZE_INFO )
+        printf("\t peak : map_chars : states %d : bddnodes %u : after projection \n", tmp->ns, bdd_size(tmp->bddm) );
+    return tmp;
 }
 
-/**
- * This functions models any function that changes all capital letters in a string to small ones (for example strtolower in php)
- * M: dfa to process
- * var: number of bits per character(for ASCII it is 8 bits)
- * indices: the indices
- * output: return D such that L(D) = { W_1S_1W_2S2..W_nS_n | W_1C_1W_2C2..W_nC_n element_of L(M) && W_i element_of Sigma* && S_i, C_i element_of Sigma && S_i = LowerCase(C_i)}
+/*
+ * Pre image of dfa_map_chars:
+ * L(result) = { c_1..c_n | map(c_1)..map(c_n) element_of L(M) }
+ * State i moves on c to the state M reaches from i on map(c), so the result
+ * stays deterministic and has the states of M.
  */
-DFA* dfaPrePostToLowerUpperCaseHelper(DFA* M, int var, int* oldIndices, boolean lowerCase, boolean preImage){
-    DFA *result;
-    paths state_paths, pp;
-    trace_descr tp;
-    int i, j, n, k;
-    char *exeps;
-    int *to_states;
-    int sink, new_sink;
-    long max_exeps;
-    char *statuces;
-    int len;
-    int ns = M->ns;
-
-    len = var + 1;
-    int* indices = allocateArbitraryIndex(len);
+DFA *dfa_pre_map_chars(DFA *M, int var, int *oldIndices, const unsigned char *map){
+    if (check_emptiness_minimized(M)){
+        return dfaCopy(M);
+    }
+    int numOfChars = 1 << var;
+    int i, c, k, d;
+    int sink = find_sink(M);
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, oldIndices);
+    int *next = table_char_transitions(table, var, sink);
+    dfaReleaseTransitionTable(table);
 
-    max_exeps = 1 << len; //maybe exponential
-    sink = find_sink(M);
+    int ns = M->ns;
+    int new_sink;
     if (sink < 0) {
-        ns += 1;
-        new_sink = ns - 1;
+        // Additional state for the new sink
+        new_sink = ns++;
     } else {
         new_sink = sink;
     }
 
-    char* symbol = (char *) malloc((len + 1) * sizeof(char));//len+1 since we need extra bit
-    exeps = (char *) malloc(max_exeps * (len + 1) * sizeof(char));
-    to_states = (int *) malloc(max_exeps * sizeof(int));
-    statuces = (char *) malloc((ns + 1) * sizeof(char));
-    int numOfChars = 1 << len;
-    char** charachters = (char**) malloc(numOfChars * (sizeof (char*)));
-    int size = 0;
-
+    int *indices = allocateArbitraryIndex(var);
+    char *exeps = (char *) malloc(numOfChars * (var + 1) * sizeof(char));
+    int *to_states = (int *) malloc(numOfChars * sizeof(int));
+    char *statuces = (char *) malloc((ns + 1) * sizeof(char));
+    char **charBin = (char **) malloc(numOfChars * sizeof(char *));
+    for (c = 0; c < numOfChars; c++)
+        charBin[c] = bintostr(c, var);
+    DFABuilder *b = dfaSetup(ns, var, indices);
 
-    DFABuilder *b = dfaSetup(ns, len, indices);
-    for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
+    for (i = 0; i < M->ns; i++){
         k = 0;
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp
-                             = tp->next)
-                        ;
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[var] = '\0';
-                // convert symbol into a list of chars where we replace each capital letter with small letter
-                getLowerUpperCaseCharsPrePost(symbol, var, charachters, &size, lowerCase, preImage);
-                for (n = 0; n < size; n++)
-                {
-//						printf("%s, ", charachters[n]);
-                    to_states[k] = pp->to;
-                    for (j = 0; j < len; j++)
-                        exeps[k * (len + 1) + j] = charachters[n][j];
-                    exeps[k * (len + 1) + len] = '\0';
-                    free(charachters[n]);
-                    k++;
-                }
-//					printf("\n");
+        for (c = 0; c < numOfChars; c++){
+            d = next[i * numOfChars + map[c]];
+            if (d != sink){
+                to_states[k] = d;
+                strcpy(exeps + k * (var + 1), charBin[c]);
+                k++;
             }
-            pp = pp->next;
         }
-        kill_paths(state_paths);
-
-        // if accept state create a self loop on lambda
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--)
-            dfaStoreException(b, to_states[k], exeps + k * (len + 1));
+            dfaStoreException(b, to_states[k], exeps + k * (var + 1));
         dfaStoreState(b, new_sink);
-
-        if (M->f[i] == -1)
-            statuces[i] = '-';
-        else if (M->f[i] == 1)
-            statuces[i] = '+';
-        else
-            statuces[i] = '0';
+        statuces[i] = (M->f[i] == 1) ? '+' : '-';
     }
 
-    // Check if a new sink is needed
     if (sink < 0) {
         dfaAllocExceptions(b, 0);
         dfaStoreState(b, new_sink);
-        statuces[ns-1]='-';
+        statuces[new_sink] = '-';
     }
-
     statuces[ns] = '\0';
-    DFA* tmpM = dfaBuild(b, statuces);
-//		dfaPrintGraphviz(tmpM, len, indices);
-//		dfaPrintVerbose(tmpM);
-    flush_output();
-    if( DEBUG_SIZE_INFO )
-        printf("\t peak : upper_lower_case : states %d : bddnodes %u : before projection \n", tmpM->ns, bdd_size(tmpM->bddm) );
-    result = dfaProject(tmpM, ((unsigned)var));
-    dfaFree(tmpM); tmpM = NULL;
-    if( DEBUG_SIZE_INFO )
-        printf("\t peak : upper_lower_case : states %d : bddnodes %u : after projection \n", result->ns, bdd_size(result->bddm) );
-    tmpM = dfaMinimize(result);
-    dfaFree(result);result = NULL;
+    DFA *result = dfaBuild(b, statuces);
 
     free(exeps);
-    free(symbol);
     free(to_states);
     free(statuces);
     free(indices);
-    free(charachters);
+    free(next);
+    for (c = 0; c < numOfChars; c++)
+        free(charBin[c]);
+    free(charBin);
 
-    return tmpM;
+    DFA *tmp = dfaMinimize(result);
+    dfaFree(result);
+    return tmp;
+}
+
+/*
+ * The map of strtolower (lowerCase) or strtoupper, only ASCII letters
+ * change case.
+ */
+static unsigned char *case_map(int var, boolean lowerCase){
+    int c;
+    unsigned char *map = (unsigned char *) malloc((1 << var) * sizeof(unsigned char));
+    for (c = 0; c < (1 << var); c++)
+        map[c] = (unsigned char) c;
+    for (c = 'A'; c <= 'Z'; c++){
+        if (lowerCase)
+            map[c] = (unsigned char) (c - 'A' + 'a');
+        else
+            map[c - 'A' + 'a'] = (unsigned char) c;
+    }
+    return map;
 }
 
+/**
+ * This functions models any function that changes all capital letters in a string to small ones (for example strtolower in php)
+ * M: dfa to process
+ * var: number of bits per character(for ASCII it is 8 bits)
+ * indices: the indices
+ * output: return D such that L(D) = { W_1S_1W_2S2..W_nS_n | W_1C_1W_2C2..W_nC_n element_of L(M) && W_i element_of Sigma* && S_i, C_i element_of Sigma && S_i = LowerCase(C_i)}
+ */
 DFA* dfaToLowerCase(DFA* M, int var, int* indices){
-    return dfaPrePostToLowerUpperCaseHelper(M, var, indices, TRUE, FALSE);
+    unsigned char *map = case_map(var, TRUE);
+    DFA *result = dfa_map_chars(M, var, indices, map);
+    free(map);
+    return result;
 }
 
 DFA* dfaToUpperCase(DFA* M, int var, int* indices){
-    return dfaPrePostToLowerUpperCaseHelper(M, var, indices, FALSE, FALSE);
+    unsigned char *map = case_map(var, FALSE);
+    DFA *result = dfa_map_chars(M, var, indices, map);
+    free(map);
+    return result;
 }
 
 DFA* dfaPreToLowerCase(DFA* M, int var, int* indices){
-    return dfaPrePostToLowerUpperCaseHelper(M, var, indices, FALSE, TRUE);
+    unsigned char *map = case_map(var, TRUE);
+    DFA *result = dfa_pre_map_chars(M, var, indices, map);
+    free(map);
+    return result;
 }
 
 DFA* dfaPreToUpperCase(DFA* M, int var, int* indices){
-    return dfaPrePostToLowerUpperCaseHelper(M, var, indices, FALSE, TRUE);
+    unsigned char *map = case_map(var, FALSE);
+    DFA *result = dfa_pre_map_chars(M, var, indices, map);
+    free(map);
+    return result;
 }
 
 
 PStatePairArrayList getNewStatePairs(DFA *M, int var, int *indices, char **escapedCharsBin, unsigned numOfEscapedChars,int sink){
     int i, j;
-    paths state_paths, pp;
-    trace_descr tp;
-    char *symbol = (char *) malloc((var + 1) * sizeof(char));
+    unsigned t;
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, indices);
+    PackedLabel label;
+    unsigned long long *escapedChars = (unsigned long long *) malloc(numOfEscapedChars * sizeof(unsigned long long));
     PStatePairArrayList statePairs = createStatePairArrayList(((M->ns < 32)? M->ns : 32), numOfEscapedChars);
+    for (j = 0; j < numOfEscapedChars; j++)
+        escapedChars[j] = packed_label_from_string(escapedCharsBin[j], var).value;
     // for each original state
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[var] = '\0';
-                
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
                 for (j = 0; j < numOfEscapedChars; j++){
-                    if (isIncludeLambda(symbol, escapedCharsBin[j], var)) {
-                        char escapedChar = strtobin(escapedCharsBin[j], var);
-                        addEscapeCharToStatePairArrayList(statePairs, i, pp->to, escapedChar);
+                    if (packed_label_includes(label, escapedChars[j])) {
+                        addEscapeCharToStatePairArrayList(statePairs, i, table->to[t], (char) escapedChars[j]);
                     }
                 }
             }
-            pp = pp->next;
-        } //end while        
-        kill_paths(state_paths);
+        } //end for
     } // end for each original s
+    dfaReleaseTransitionTable(table);
     
-    free(symbol);
+    free(escapedChars);
     
     return statePairs;
 }
@@ -2298,10 +2223,11 @@ DFA *dfa_escape(DFA *M, int var, int *oldindices, char escapeChar, char *escaped
     DFA *result = NULL;
     char* escapeCharBin = bintostr(escapeChar, var);
     
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table;
+    PackedLabel label;
     
     int i, j, z, k;
+    unsigned t;
     
     char *exeps;
     int *to_states;
@@ -2330,7 +2256,8 @@ DFA *dfa_escape(DFA *M, int var, int *oldindices, char escapeChar, char *escaped
     numOfChars = 1 << var;
     charachters = (char**) malloc(numOfChars * (sizeof(char*)));
     
-    PStatePairArrayList statePairs = getNewStatePairs(M, var, indices, escapedCharsBin, numOfEscapedChars, sink);
+    table = dfaAcquireTransitionTable(M, var, oldindices);
+    PStatePairArrayList statePairs = getNewStatePairs(M, var, oldindices, escapedCharsBin, numOfEscapedChars, sink);
 //    assert(statePairs->index < INT_MAX && statePairs->sorted);
 //    printStatePairArrayList(statePairs);
     int num_new_states = (int) statePairs->index;
@@ -2353,36 +2280,24 @@ DFA *dfa_escape(DFA *M, int var, int *oldindices, char escapeChar, char *escaped
     
     // for each original state
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         escapeState = false;
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[var] = '\0';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 size_t index;
-                if (searchStatePairArrayListBS(statePairs, i, pp->to
-                                               , &index)){
+                // Only labels on an escaped character need to be split
+                if ((packed_label_includes(label, escapeChar) ||
+                     packed_label_includes_any(label, escapedChars, numOfEscapedChars - 1)) &&
+                    searchStatePairArrayListBS(statePairs, i, table->to[t], &index)){
                     escapeState = true;
                     removeTransitionOnChars(symbol, escapedCharsBin, numOfEscapedChars, var, charachters,
                                             &size);
                     for (z = 0; z < size; z++) {
                         // first copy of non-bamda char to original destination
-                        to_states[k] = pp->to;
+                        to_states[k] = table->to[t];
                         for (j = 0; j < var; j++)
                             exeps[k * (len + 1) + j] = charachters[z][j];
                         exeps[k * (len + 1) + len] = '\0';
@@ -2391,15 +2306,14 @@ DFA *dfa_escape(DFA *M, int var, int *oldindices, char escapeChar, char *escaped
                     }
                 }
                 else {
-                    to_states[k] = pp->to;
+                    to_states[k] = table->to[t];
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = symbol[j];
                     exeps[k * (len + 1) + len] = '\0';
                     k++;
                 }
             }
-            pp = pp->next;
-        } //end while
+        } //end for
         
         if (escapeState){
             to_states[k] = (int) numOfEscapeStates + M->ns;
@@ -2421,9 +2335,8 @@ DFA *dfa_escape(DFA *M, int var, int *oldindices, char escapeChar, char *escaped
             statuces[i] = '+';
         else
             statuces[i] = '-';
-        
-        kill_paths(state_paths);
     } // end for each original state
+    dfaReleaseTransitionTable(table);
 
     // add new states
     // i-> new state number
@@ -2499,47 +2412,27 @@ DFA *dfa_escape(DFA *M, int var, int *oldindices, char escapeChar, char *escaped
 bool getNextStateOnLambda(DFA *M, int var, int *indices, char *lambda, unsigned srcState, unsigned *pNextState){
 
     int sink = find_sink(M);
-    unsigned j;
     if (pNextState)
         *pNextState = UINT_MAX;
     bool found = false;
-    paths state_paths, pp;
-    trace_descr tp;
-    char *symbol = (char *) malloc((var + 1) * sizeof(char));
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, indices);
+    unsigned t;
+    unsigned long long lambdaChar = packed_label_from_string(lambda, var).value;
     
-    state_paths = pp = make_paths(M->bddm, M->q[srcState]);
     // for each transition out from current state srcState
-    while (pp) {
-        if (pp->to != sink) {
-            for (j = 0; j < var; j++) {
-                //the following for loop can be avoided if the indices are in order
-                for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                         tp->next)
-                    ;
-                
-                if (tp) {
-                    if (tp->value)
-                        symbol[j] = '1';
-                    else
-                        symbol[j] = '0';
-                } else
-                    symbol[j] = 'X';
-            }
-            symbol[var] = '\0';
-                        
-            if (isIncludeLambda(symbol, lambda, var)) {
+    for (t = table->first[srcState]; t < table->first[srcState + 1]; t++) {
+        if (table->to[t] != sink) {
+            if (packed_label_includes(table->labels[t], lambdaChar)) {
                 if (pNextState)
-                    *pNextState = pp->to;
+                    *pNextState = table->to[t];
                 found = true;
                 break;
 
             }
         }
-        pp = pp->next;
-    } //end while
-    kill_paths(state_paths);
+    } //end for
+    dfaReleaseTransitionTable(table);
     
-    free(symbol);
     return found;
 }
 
@@ -2739,10 +2632,11 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
     DFA *result = NULL;
     char* escapeCharBin = bintostr(escapeChar, var);
         
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table;
+    PackedLabel label;
     
     int i, j, k, z;
+    unsigned t;
     unsigned nextState;
     
     char *exeps;
@@ -2763,6 +2657,7 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
     
     PStatePairArrayList escapeTransitions = createStatePairArrayList(32, numOfEscapedChars);
     PUIntArrayList escapedStates = createUIntArrayList(32);
+    table = dfaAcquireTransitionTable(M, var, indices);
     getEscapeTransitions(M, var, indices, escapeCharBin, escapeChar, numOfEscapedChars, escapeTransitions, escapedStates);
     
     unsigned *shiftArray = getShiftArray(escapedStates, M->ns);
@@ -2792,26 +2687,12 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
 //            printf("state skipped = %d\n",i);
             continue;
         }
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                             tp->next)
-                        ;
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[var] = '\0';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 
                 /*
                   1- if an escape transition (from, to) then add all escaped transitions (out from "to" state)
@@ -2821,7 +2702,7 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
                   there is a path s->...->from->to->to` where the escape char is not escaping and not being escaped.
                 */
                 //if escape char is escaping
-                if (searchStatePairArrayListBS(escapeTransitions, i, pp->to, NULL)){
+                if (searchStatePairArrayListBS(escapeTransitions, i, table->to[t], NULL)){
                     //assert invariant: only one transition out and it is on escape char
                     for (j = 0; j < var; j++)
                         assert(symbol[j] == escapeCharBin[j]);
@@ -2831,10 +2712,10 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
                         //if next state has an escaped char out of it then add it to next of
                         //currentState in new automaton (no need for extra bits due to
                         //invariant above)
-                        if (getNextStateOnLambda(M, var, indices, escapedCharsBin[z], pp->to, &nextState))
+                        if (getNextStateOnLambda(M, var, indices, escapedCharsBin[z], table->to[t], &nextState))
                         {
                             //assert invariant: next state is not an escape state
-                            assert(searchUIntArrayListBS(escapedStates, pp->to, NULL));
+                            assert(searchUIntArrayListBS(escapedStates, table->to[t], NULL));
                             found = true;
                             to_states[k] = nextState - shiftArray[nextState];
                             for (j = 0; j < var; j++)
@@ -2856,7 +2737,7 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
                 //new automaton so it is OK to copy it as it is since it will be removed
                 //by minimization
                 else if (!searchUIntArrayListBS(escapedStates, i, NULL)){
-                    to_states[k] = pp->to - shiftArray[pp->to]; // destination new accept state
+                    to_states[k] = table->to[t] - shiftArray[table->to[t]]; // destination new accept state
                     for (j = 0; j < var; j++)
                         exeps[k * (var + 1) + j] = symbol[j];
                     exeps[k * (var + 1) + var] = '\0';
@@ -2867,8 +2748,7 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
                   of escape.
                 */
             }
-            pp = pp->next;
-        } //end while
+        } //end for
         
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--)
@@ -2878,9 +2758,8 @@ DFA *dfa_pre_escape(DFA *M, int var, int *indices, char escapeChar, char *escape
             statuces[i - shiftArray[i]] = '+';
         else
             statuces[i - shiftArray[i]] = '-';
-        
-        kill_paths(state_paths);
     } // end for each original state
+    dfaReleaseTransitionTable(table);
     //    assert(new_state_counter == (num_new_states - 1));
     // Check if a new sink is needed
     if (sink < 0) {
@@ -2958,39 +2837,20 @@ unsigned *getShiftArray2(PStatePairArrayList addedStates, int size, int shiftLen
 }
 
 bool checkExtraBitNeeded(DFA *M, int var, int *indices, int state, char *lambda){
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, indices);
+    unsigned t;
     int sink = find_sink(M);
-    int j;
-    char *symbol = (char *) malloc((var + 1) * sizeof(char));
+    unsigned long long lambdaChar = packed_label_from_string(lambda, var).value;
     bool retMe = false;
-    state_paths = pp = make_paths(M->bddm, M->q[state]);
-    while (pp) {
-        if (pp->to != sink){
-            for (j = 0; j < var; j++){
-                //the following for loop can be avoided if the indices are in order
-                for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-                         tp->next)
-                    ;
-                
-                if (tp) {
-                    if (tp->value)
-                        symbol[j] = '1';
-                    else
-                        symbol[j] = '0';
-                } else
-                    symbol[j] = 'X';
-            }
-            symbol[var] = '\0';
-            if (isIncludeLambda(symbol, lambda, var)){
+    for (t = table->first[state]; t < table->first[state + 1]; t++) {
+        if (table->to[t] != sink){
+            if (packed_label_includes(table->labels[t], lambdaChar)){
                 retMe = true;
                 break;
             }
         }
-        pp = pp->next;
     }
-    kill_paths(state_paths);
-    free(symbol);
+    dfaReleaseTransitionTable(table);
     return retMe;
 }
 
@@ -3012,8 +2872,9 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
     char firstChar = string[0];
     char *firstCharBin = bintostr(firstChar, var);
     size_t strLength = strlen(string);
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, oldIndices);
+    unsigned t;
+    PackedLabel label;
     int i, j, k, z;
     char *exeps;
     int *to_states;
@@ -3029,35 +2890,20 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
 
     /**************      PREPROCESSING PHASE     ******************/
     for (i = 0; i < M->ns; i++){
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
-        while (pp) {
-            if (pp->to != sink){
-                for (j = 0; j < var; j++){
-                    // The following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != oldIndices[j]); tp = tp->next);
-                    if (tp) {
-                        if (tp->value) {
-                            symbol[j] = '1';
-                        } else {
-                            symbol[j] = '0';
-                        }
-                    } else {
-                        symbol[j] = 'X';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink){
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
+                if (packed_label_includes(label, replacedChar)){
+                    if (!searchStatePairArrayListBS(replaceTransitions, i, table->to[t], NULL)){
+                        insertIntoStatePairSortedArrayList(replaceTransitions, i, table->to[t], replacedChar);
                     }
-                }
-                symbol[var] = '\0';
-                if (isIncludeLambda(symbol, replacedCharBin, var)){
-                    if (!searchStatePairArrayListBS(replaceTransitions, i, pp->to, NULL)){
-                        insertIntoStatePairSortedArrayList(replaceTransitions, i, pp->to, replacedChar);
-                    }
-                    if (!extraBitNeeded && (isIncludeLambda(symbol, firstCharBin, var) || checkExtraBitNeeded(M, var, oldIndices, i, firstCharBin))) {
+                    if (!extraBitNeeded && (packed_label_includes(label, firstChar) || checkExtraBitNeeded(M, var, oldIndices, i, firstCharBin))) {
                         extraBitNeeded = true;
                     }
                 }
             }
-            pp = pp->next;
         }
-        kill_paths(state_paths);
     }
 
     /**************      BUILDING AUTOMATON PHASE     ******************/
@@ -3094,38 +2940,25 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
 
     // for each original state
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         toState = -1;
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != oldIndices[j]); tp = tp->next);
-                    if (tp) {
-                        if (tp->value) {
-                            symbol[j] = '1';
-                        } else {
-                            symbol[j] = '0';
-                        }
-                    } else {
-                        symbol[j] = 'X';
-                    }
-                }
-                symbol[var] = '\0';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 /*
                   if we need to replace "replace char" between these two states then
                   remove transition to old dest and add a new one to a new state.
                   At the end of the whole for loop we will add other states for
                   remaining of the string
                 */
-                if (searchStatePairArrayListBS(replaceTransitions, i, pp->to, NULL)){
-                    if (isIncludeLambda(symbol, replacedCharBin, var)){
+                if (searchStatePairArrayListBS(replaceTransitions, i, table->to[t], NULL)){
+                    if (packed_label_includes(label, replacedChar)){
                         //if we are replacing one char with another char
                         if (strLength == 1){
                             //add first char of the string to the new dest state
-                            to_states[k] = pp->to + M->ns;
+                            to_states[k] = table->to[t] + M->ns;
                             for (j = 0; j < var; j++) {
                                 exeps[k * (len + 1) + j] = firstCharBin[j];
                             }
@@ -3139,7 +2972,7 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
                         // remove replace char from old dest state
                         removeTransitionOnChar(symbol, replacedCharBin, var, charachters, &size);
                         for (z = 0; z < size; z++) {
-                            to_states[k] = pp->to;
+                            to_states[k] = table->to[t];
                             for (j = 0; j < var; j++) {
                                 exeps[k * (len + 1) + j] = charachters[z][j];
                             }
@@ -3149,7 +2982,7 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
                             free(charachters[z]);
                         }
                     } else { // does not include symbol no need to replace anything
-                        to_states[k] = pp->to;
+                        to_states[k] = table->to[t];
                         for (j = 0; j < var; j++) {
                             exeps[k * (len + 1) + j] = symbol[j];
                         }
@@ -3158,7 +2991,7 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
                         k++;
                     }
                 } else { // Not in replacement list, no need to replace anything
-                    to_states[k] = pp->to;
+                    to_states[k] = table->to[t];
                     for (j = 0; j < var; j++) {
                         exeps[k * (len + 1) + j] = symbol[j];
                     }
@@ -3167,7 +3000,6 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
                     k++;
                 }
             }
-            pp = pp->next;
         } // Loop over transitions
 
         dfaAllocExceptions(b, k);
@@ -3181,7 +3013,6 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
         } else {
             statuces[i] = '-';
         }
-        kill_paths(state_paths);
 
     } // end for each original state
 
@@ -3189,30 +3020,17 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
     // automaton states after the first character has been replaced
     // for each original state, all the state indices shifted by M->ns
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         toState = -1;
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != oldIndices[j]); tp = tp->next);
-                    if (tp) {
-                        if (tp->value) {
-                            symbol[j] = '1';
-                        } else {
-                            symbol[j] = '0';
-                        }
-                    } else {
-                        symbol[j] = 'X';
-                    }
-                }
-                symbol[var] = '\0';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 /*
                   Not replacing anything this time
                 */
-                to_states[k] = pp->to + M->ns;
+                to_states[k] = table->to[t] + M->ns;
                 for (j = 0; j < var; j++) {
                     exeps[k * (len + 1) + j] = symbol[j];
                 }
@@ -3220,7 +3038,6 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
                 exeps[k * (len + 1) + len] = '\0';
                 k++;
             }
-            pp = pp->next;
         } // Loop over transitions
 
         dfaAllocExceptions(b, k);
@@ -3233,7 +3050,6 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
         } else {
             statuces[i + M->ns] = '-';
         }
-        kill_paths(state_paths);
     } // end for each original state
 
     // Check if a new sink is needed
@@ -3244,6 +3060,7 @@ DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char re
     }
 
     statuces[ns] = '\0';
+    dfaReleaseTransitionTable(table);
     result = dfaBuild(b, statuces);
     free(exeps);
     //	//printf("FREE ToState\n");
@@ -3298,8 +3115,9 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
     size_t strLength = strlen(string);
     int numOfAddedStates = 0;
     
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, oldIndices);
+    unsigned t;
+    PackedLabel label;
     
     int i, j, k, z;
     
@@ -3318,37 +3136,21 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
     
     /**************      PREPROCESSING PHASE     ******************/
     for (i = 0; i < M->ns; i++){
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
-        while (pp) {
-            if (pp->to != sink){
-                for (j = 0; j < var; j++){
-                    // The following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != oldIndices[j]); tp = tp->next);
-                    
-                    if (tp) {
-                        if (tp->value) {
-                            symbol[j] = '1';
-                        } else {
-                            symbol[j] = '0';
-                        }
-                    } else {
-                        symbol[j] = 'X';
-                    }
-                }
-                symbol[var] = '\0';
-                if (isIncludeLambda(symbol, replacedCharBin, var)){
-                    if (!searchStatePairArrayListBS(replaceTransitions, i, pp->to, NULL)){
-                        insertIntoStatePairSortedArrayList(replaceTransitions, i, pp->to, replacedChar);
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink){
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
+                if (packed_label_includes(label, replacedChar)){
+                    if (!searchStatePairArrayListBS(replaceTransitions, i, table->to[t], NULL)){
+                        insertIntoStatePairSortedArrayList(replaceTransitions, i, table->to[t], replacedChar);
                         numOfAddedStates += (strLength - 1);
                     }
-                    if (!extraBitNeeded && (isIncludeLambda(symbol, firstCharBin, var) || checkExtraBitNeeded(M, var, oldIndices, i, firstCharBin))) {
+                    if (!extraBitNeeded && (packed_label_includes(label, firstChar) || checkExtraBitNeeded(M, var, oldIndices, i, firstCharBin))) {
                         extraBitNeeded = true;
                     }
                 }
             }
-            pp = pp->next;
         }
-        kill_paths(state_paths);
     }
     
     /**************      BUILDING AUTOMATON PHASE     ******************/
@@ -3390,28 +3192,14 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
     
     // for each original state
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         toState = -1;
         new_state_counter = i + shiftArray[i] + 1;
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != oldIndices[j]); tp =
-                             tp->next)
-                        ;
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[var] = '\0';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
             
                 /*
                   if we need to replace "replace char" between these two states then
@@ -3419,12 +3207,12 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
                   At the end of the whole for loop we will add other states for
                   remaining of the string
                 */
-                if (searchStatePairArrayListBS(replaceTransitions, i, pp->to, NULL)){
-                    if (isIncludeLambda(symbol, replacedCharBin, var)){
+                if (searchStatePairArrayListBS(replaceTransitions, i, table->to[t], NULL)){
+                    if (packed_label_includes(label, replacedChar)){
                         //if we are replacing one char with another char
                         if (strLength == 1){
                             //add first char of the string to the new dest state
-                            to_states[k] = pp->to;
+                            to_states[k] = table->to[t];
                             for (j = 0; j < var; j++)
                                 exeps[k * (len + 1) + j] = firstCharBin[j];
                             exeps[k * (len + 1) + var] = '1';
@@ -3432,7 +3220,7 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
                             k++;
                         }
                         else {
-                            toState = pp->to + shiftArray[pp->to];
+                            toState = table->to[t] + shiftArray[table->to[t]];
                             //add first char of the string to the new dest state
                             to_states[k] = new_state_counter++;
                             for (j = 0; j < var; j++)
@@ -3446,7 +3234,7 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
                                                &size);
                         for (z = 0; z < size; z++) {
                             //							printf("%s, ", charachters[z]);
-                            to_states[k] = pp->to + shiftArray[pp->to]; // destination new accept state
+                            to_states[k] = table->to[t] + shiftArray[table->to[t]]; // destination new accept state
                             for (j = 0; j < var; j++)
                                 exeps[k * (len + 1) + j] = charachters[z][j];
                             exeps[k * (len + 1) + var] = '0';
@@ -3456,7 +3244,7 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
                         }
                     }
                     else {//no need to replace anything
-                        to_states[k] = pp->to + shiftArray[pp->to]; // destination new accept state
+                        to_states[k] = table->to[t] + shiftArray[table->to[t]]; // destination new accept state
                         for (j = 0; j < var; j++)
                             exeps[k * (len + 1) + j] = symbol[j];
                         exeps[k * (len + 1) + var] = '0';
@@ -3465,7 +3253,7 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
                     }
                 }
                 else {//no need to replace anything
-                    to_states[k] = pp->to + shiftArray[pp->to]; // destination new accept state
+                    to_states[k] = table->to[t] + shiftArray[table->to[t]]; // destination new accept state
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = symbol[j];
                     exeps[k * (len + 1) + var] = '0';
@@ -3473,8 +3261,7 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
                     k++;
                 }
             }
-            pp = pp->next;
-        } //end while
+        } //end for
         
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--){
@@ -3485,7 +3272,6 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
             statuces[i + shiftArray[i]] = '+';
         else
             statuces[i + shiftArray[i]] = '-';
-        kill_paths(state_paths);
         
         //Now if state i has a transition out on "replaced char" then we add additional states
         //from state i for the replace string
@@ -3516,6 +3302,7 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
     }
 
     statuces[ns] = '\0';
+    dfaReleaseTransitionTable(table);
     result = dfaBuild(b, statuces);
     
     free(exeps);
@@ -3557,18 +3344,7 @@ DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replace
 
 
 int transitionIncludesChar(const char *str, char target, int var){
-    int i;
-    boolean result;
-    result = TRUE;
-    char* targetS = bintostr(target, var);
-    for(i=0; i<var; i++){
-        if(str[i]!='X' && str[i]!=targetS[i]){
-            result = FALSE;
-            break;
-        }
-    }
-    free(targetS);
-    return result;
+    return packed_label_includes(packed_label_from_string(str, var), target);
 }
 
 
@@ -3582,10 +3358,9 @@ int stringAcceptedFromState(DFA* M, int state, char* string, int var, int* indic
         return -2;
     }
     
-    int length, i, j, currentState = state;
-    paths state_paths, pp;
-    trace_descr tp;
-    char* symbol;
+    int length, i, currentState = state;
+    TransitionTable *table;
+    unsigned t;
     bool found = true;
 
     int sink = find_sink(M);
@@ -3594,44 +3369,27 @@ int stringAcceptedFromState(DFA* M, int state, char* string, int var, int* indic
     
     if (length == 0)
         return state;
-    
-    symbol = (char *) malloc((var + 1) * sizeof(char));
+
+    table = dfaAcquireTransitionTable(M, var, indices);
     
     //we stop searching if:
     //1- we finished the sting
     //2- if we hit the sink state
     for (i = 0; i < length && currentState != sink; i++){
         found = false;
-        state_paths = pp = make_paths(M->bddm, M->q[currentState]);
-        while (pp) {
-            for (j = 0; j < var; j++) {
-                //the following for loop can be avoided if the indices are in order
-                for (tp = pp->trace; tp && (tp->index != indices[j]); tp
-                         = tp->next)
-                    ;
-                if (tp) {
-                    if (tp->value)
-                        symbol[j] = '1';
-                    else
-                        symbol[j] = '0';
-                } else
-                    symbol[j] = 'X';
-            }
-            symbol[var] = '\0';
-            if (transitionIncludesChar(symbol, string[i], var)){
-                currentState = pp->to;
+        for (t = table->first[currentState]; t < table->first[currentState + 1]; t++) {
+            if (packed_label_includes(table->labels[t], string[i])){
+                currentState = table->to[t];
                 //we found next state so stop searching from current state
                 found = true;
                 break;
             }
-            pp = pp->next;
         }
-        kill_paths(state_paths);
         //we must find a transition on current char but it may lead to sink state
         assert(found);
     }
+    dfaReleaseTransitionTable(table);
   	
-    free(symbol);
 
     //if we (1) finished the whole string and (2) did not hit the sink state then string is accepted from state
     if (i == length && currentState != sink)
@@ -3659,8 +3417,9 @@ DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char rep
     char* replacedCharBin = bintostr(replacedChar, var);
     bool extraBitNeeded = false;
     
-    paths state_paths, pp;
-    trace_descr tp;
+    TransitionTable *table = dfaAcquireTransitionTable(M, var, oldIndices);
+    unsigned t;
+    PackedLabel label;
     
     int i, j, k, z;
     
@@ -3714,38 +3473,24 @@ DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char rep
     
     // for each original state
     for (i = 0; i < M->ns; i++) {
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
         k = 0;
         // for each transition out from current state (state i)
-        while (pp) {
-            if (pp->to != sink) {
-                for (j = 0; j < var; j++) {
-                    //the following for loop can be avoided if the indices are in order
-                    for (tp = pp->trace; tp && (tp->index != oldIndices[j]); tp =
-                             tp->next)
-                        ;
-                    
-                    if (tp) {
-                        if (tp->value)
-                            symbol[j] = '1';
-                        else
-                            symbol[j] = '0';
-                    } else
-                        symbol[j] = 'X';
-                }
-                symbol[var] = '\0';
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] != sink) {
+                label = table->labels[t];
+                packed_label_to_string(label, var, symbol);
                 
                 //Add original transitions
 #if MORE_WORDS_LESS_NDTRANS == 0
-                to_states[k] = pp->to;
+                to_states[k] = table->to[t];
                 for (j = 0; j < var; j++)
                     exeps[k * (len + 1) + j] = symbol[j];
                 exeps[k * (len + 1) + j] = '0';//<-- only if len > var this will matter
                 exeps[k * (len + 1) + len] = '\0';
                 k++;
 #else
-                if (!isIncludeLambda(symbol, replacedCharBin, var)) { // Only Consider Non-lambda case
-                    to_states[k] = pp->to;
+                if (!packed_label_includes(label, replacedChar)) { // Only Consider Non-lambda case
+                    to_states[k] = table->to[t];
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = symbol[j];
                     exeps[k * (len + 1) + j] = 'X';//<-- only if len > var this will matter
@@ -3757,7 +3502,7 @@ DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char rep
                     for (z = 0; z < size; z++)
                     {
                         //						printf("%s, ", charachters[i]);
-                        to_states[k] = pp->to;
+                        to_states[k] = table->to[t];
                         for (j = 0; j < var; j++)
                             exeps[k * (len + 1) + j] = charachters[z][j];
                         exeps[k * (len + 1) + j] = 'X';//<-- only if len > var this will matter
@@ -3766,7 +3511,7 @@ DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char rep
                         k++;
                     }
                     //					printf("\n");
-                    to_states[k] = pp->to;
+                    to_states[k] = table->to[t];
                     for (j = 0; j < var; j++)
                         exeps[k * (len + 1) + j] = replacedCharBin[j];
                     exeps[k * (len + 1) + j] = '0';//<-- only if len > var this will matter
@@ -3793,8 +3538,7 @@ DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char rep
                 }
                     
             }
-            pp = pp->next;
-        } //end while
+        } //end for
         
         dfaAllocExceptions(b, k);
         for (k--; k >= 0; k--){
@@ -3805,7 +3549,6 @@ DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char rep
             statuces[i] = '+';
         else
             statuces[i] = '-';
-        kill_paths(state_paths);
     } // end for each original state
 
     // Check if a new sink is needed
@@ -3816,6 +3559,7 @@ DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char rep
     }
 
     statuces[new_ns] = '\0';
+    dfaReleaseTransitionTable(table);
     result = dfaBuild(b, statuces);
     
         
@@ -4092,6 +3836,376 @@ DFA *dfaPreHtmlSpecialChars(DFA *inputAuto, int var, int *indices, hscflags_t fl
     return result;
 }
 
+/*
+ * Fills next[i * (1 << var) + c] with the state reached from state i on
+ * character c by walking the transition BDD of i with the bits of c.
+ */
+static int *dfa_char_transitions(DFA *M, int var, int *indices, char **charBin){
+    int numOfChars = 1 << var;
+    int i, j, c, maxIndex = 0;
+    int *position;
+    int *next = (int *) malloc(M->ns * numOfChars * sizeof(int));
+    bdd_ptr p;
+
+    for (j = 0; j < var; j++)
+        if (indices[j] > maxIndex)
+            maxIndex = indices[j];
+    position = (int *) malloc((maxIndex + 1) * sizeof(int));
+    for (j = 0; j <= maxIndex; j++)
+        position[j] = -1;
+    for (j = 0; j < var; j++)
+        position[indices[j]] = j;
+
+    for (i = 0; i < M->ns; i++){
+        for (c = 0; c < numOfChars; c++){
+            p = M->q[i];
+            while (!bdd_is_leaf(M->bddm, p)){
+                unsigned index = bdd_ifindex(M->bddm, p);
+                j = (index <= (unsigned) maxIndex) ? position[index] : -1;
+                if (j >= 0 && charBin[c][j] == '1')
+                    p = bdd_then(M->bddm, p);
+                else
+                    p = bdd_else(M->bddm, p);
+            }
+            next[i * numOfChars + c] = bdd_leaf_value(M->bddm, p);
+        }
+    }
+    free(position);
+    return next;
+}
+
+#define REPLACE_TRIE_NONE -1
+#define REPLACE_TRIE_LEAF(c) (-2 - (c))
+#define REPLACE_TRIE_LEAF_CHAR(v) (-2 - (v))
+
+/*
+ * Builds a trie of the replacement strings, child[n * (1 << var) + c] is the
+ * trie node reached from node n on c, or REPLACE_TRIE_LEAF(r) if the
+ * replacement for r ends there. Returns the number of nodes (root is 0)
+ * or -1 if the replacements are not prefix free, in which case the
+ * simultaneous replacement would not be deterministic.
+ */
+static int build_replace_trie(const char *replacements[], int var, int **childOut){
+    int numOfChars = 1 << var;
+    int r, k, c, x, len, node, size = 1, capacity = 16;
+    int *child = (int *) malloc(capacity * numOfChars * sizeof(int));
+    for (c = 0; c < numOfChars; c++)
+        child[c] = REPLACE_TRIE_NONE;
+
+    for (r = 0; r < numOfChars; r++){
+        if (replacements[r] == NULL)
+            continue;
+        len = (int) strlen(replacements[r]);
+        if (len == 0){
+            free(child);
+            return -1;
+        }
+        node = 0;
+        for (k = 0; k < len; k++){
+            c = (unsigned char) replacements[r][k];
+            int *entry = &child[node * numOfChars + c];
+            if (k == len - 1){
+                if (*entry != REPLACE_TRIE_NONE){
+                    free(child);
+                    return -1;
+                }
+                *entry = REPLACE_TRIE_LEAF(r);
+            } else if (*entry == REPLACE_TRIE_NONE){
+                if (size == capacity){
+                    capacity *= 2;
+                    child = (int *) realloc(child, capacity * numOfChars * sizeof(int));
+                    entry = &child[node * numOfChars + c];
+                }
+                for (x = 0; x < numOfChars; x++)
+                    child[size * numOfChars + x] = REPLACE_TRIE_NONE;
+                *entry = size;
+                node = size++;
+            } else if (*entry < 0){
+                free(child);
+                return -1;
+            } else {
+                node = *entry;
+            }
+        }
+    }
+    *childOut = child;
+    return size;
+}
+
+static void store_char_exception(char *exeps, int *to_states, int *k, int var, int len,
+                                 const char *bin, char extraBit, int to){
+    int j;
+    to_states[*k] = to;
+    for (j = 0; j < var; j++)
+        exeps[*k * (len + 1) + j] = bin[j];
+    if (len > var)
+        exeps[*k * (len + 1) + var] = extraBit;
+    exeps[*k * (len + 1) + len] = '\0';
+    (*k)++;
+}
+
+/*
+ * Replaces every character c for which replacements[c] is not NULL with the
+ * string replacements[c], all characters at the same time and in a single
+ * traversal of M. replacements has (1 << var) entries and its non NULL
+ * entries must be prefix free (e.g. "%XX" percent encodings).
+ * This is equivalent to calling dfa_replace_char_with_string for each
+ * character as long as no replacement string contains a replaced character.
+ * Each state with a replaced character gets a copy of the trie of the
+ * replacement strings, an extra bit is only added when a kept character of
+ * a state is also the first character of one of the replacement strings.
+ */
+DFA *dfa_replace_chars_with_strings(DFA *M, int var, int *oldIndices, const char *replacements[]){
+    if (check_emptiness_minimized(M)){
+        return dfaCopy(M);
+    }
+    int numOfChars = 1 << var;
+    int *child = NULL;
+    int trieSize = build_replace_trie(replacements, var, &child);
+    if (trieSize < 0) {
+        return NULL;
+    }
+
+    int i, c, n, k, d;
+    int sink = find_sink(M);
+    char **charBin = (char **) malloc(numOfChars * sizeof(char *));
+    for (c = 0; c < numOfChars; c++)
+        charBin[c] = bintostr(c, var);
+    int *next = dfa_char_transitions(M, var, oldIndices, charBin);
+
+    /**************      PREPROCESSING PHASE     ******************/
+    // Only states with a replaced char leaving them get a copy of the trie
+    int *trieBase = (int *) malloc(M->ns * sizeof(int));
+    int ns = M->ns;
+    bool extraBitNeeded = false;
+    for (i = 0; i < M->ns; i++){
+        trieBase[i] = -1;
+        for (c = 0; c < numOfChars; c++){
+            if (replacements[c] != NULL && next[i * numOfChars + c] != sink){
+                trieBase[i] = ns;
+                ns += trieSize - 1;
+                break;
+            }
+        }
+        if (trieBase[i] >= 0 && !extraBitNeeded){
+            for (c = 0; c < numOfChars; c++){
+                if (replacements[c] == NULL && child[c] != REPLACE_TRIE_NONE &&
+                    next[i * numOfChars + c] != sink){
+                    extraBitNeeded = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    int new_sink;
+    if (sink < 0) {
+        // Additional state for the new sink
+        new_sink = ns++;
+    } else {
+        new_sink = sink;
+    }
+
+    /**************      BUILDING AUTOMATON PHASE     ******************/
+    int len = extraBitNeeded ? (var + 1) : var;
+    int *indices = allocateArbitraryIndex(len);
+    long max_exeps = 2 * numOfChars;
+    char *exeps = (char *) malloc(max_exeps * (len + 1) * sizeof(char));
+    int *to_states = (int *) malloc(max_exeps * sizeof(int));
+    char *statuces = (char *) malloc((ns + 1) * sizeof(char));
+    DFABuilder *b = dfaSetup(ns, len, indices);
+
+    for (i = 0; i < M->ns; i++){
+        k = 0;
+        for (c = 0; c < numOfChars; c++){
+            d = next[i * numOfChars + c];
+            if (replacements[c] == NULL && d != sink)
+                store_char_exception(exeps, to_states, &k, var, len, charBin[c], '0', d);
+        }
+        if (trieBase[i] >= 0){
+            // first char of each replacement string
+            for (c = 0; c < numOfChars; c++){
+                n = child[c];
+                if (n == REPLACE_TRIE_NONE)
+                    continue;
+                d = (n > 0) ? trieBase[i] + n - 1 : next[i * numOfChars + REPLACE_TRIE_LEAF_CHAR(n)];
+                if (d != sink)
+                    store_char_exception(exeps, to_states, &k, var, len, charBin[c], '1', d);
+            }
+        }
+        dfaAllocExceptions(b, k);
+        for (k--; k >= 0; k--)
+            dfaStoreException(b, to_states[k], exeps + k * (len + 1));
+        dfaStoreState(b, new_sink);
+        statuces[i] = (M->f[i] == 1) ? '+' : '-';
+    }
+
+    // The copies of the trie for each state
+    for (i = 0; i < M->ns; i++){
+        if (trieBase[i] < 0)
+            continue;
+        for (n = 1; n < trieSize; n++){
+            k = 0;
+            for (c = 0; c < numOfChars; c++){
+                int t = child[n * numOfChars + c];
+                if (t == REPLACE_TRIE_NONE)
+                    continue;
+                d = (t > 0) ? trieBase[i] + t - 1 : next[i * numOfChars + REPLACE_TRIE_LEAF_CHAR(t)];
+                if (d != sink)
+                    store_char_exception(exeps, to_states, &k, var, len, charBin[c], 'X', d);
+            }
+            dfaAllocExceptions(b, k);
+            for (k--; k >= 0; k--)
+                dfaStoreException(b, to_states[k], exeps + k * (len + 1));
+            dfaStoreState(b, new_sink);
+            statuces[trieBase[i] + n - 1] = '-';
+        }
+    }
+
+    if (sink < 0) {
+        dfaAllocExceptions(b, 0);
+        dfaStoreState(b, new_sink);
+        statuces[new_sink] = '-';
+    }
+    statuces[ns] = '\0';
+    DFA *result = dfaBuild(b, statuces);
+
+    free(exeps);
+    free(to_states);
+    free(statuces);
+    free(indices);
+    free(trieBase);
+    free(next);
+    free(child);
+    for (c = 0; c < numOfChars; c++)
+        free(charBin[c]);
+    free(charBin);
+
+    DFA *tmp;
+    if (extraBitNeeded){
+        if( DEBUG_SIZE_INFO )
+            printf("\t peak : replace_chars_with_strings : states %d : bddnodes %u : before projection \n", result->ns, bdd_size(result->bddm) );
+        tmp = dfaProject(result, var);
+        dfaFree(result);
+        result = dfaMinimize(tmp);
+        dfaFree(tmp);
+    } else {
+        if( DEBUG_SIZE_INFO )
+            printf("\t peak : replace_chars_with_strings : states %d : bddnodes %u \n", result->ns, bdd_size(result->bddm) );
+        tmp = dfaMinimize(result);
+        dfaFree(result);
+        result = tmp;
+    }
+    return result;
+}
+
+/*
+ * Pre image of dfa_replace_chars_with_strings: keeps all transitions of M and
+ * adds a transition on c from i to j for each replaced c whose replacement
+ * string leads from i to j in M. All replacement strings are followed in M
+ * itself, so a decoded character is never used to decode another sequence.
+ */
+DFA *dfa_pre_replace_chars_with_strings(DFA *M, int var, int *oldIndices, const char *replacements[]){
+    if (check_emptiness_minimized(M)){
+        return dfaCopy(M);
+    }
+    int numOfChars = 1 << var;
+    int i, c, k, d, z;
+    int sink = find_sink(M);
+    char **charBin = (char **) malloc(numOfChars * sizeof(char *));
+    for (c = 0; c < numOfChars; c++)
+        charBin[c] = bintostr(c, var);
+    int *next = dfa_char_transitions(M, var, oldIndices, charBin);
+
+    /**************      PREPROCESSING PHASE     ******************/
+    // end[i * numOfChars + c] is the state reached from i on replacements[c]
+    int *end = (int *) malloc(M->ns * numOfChars * sizeof(int));
+    bool extraBitNeeded = false;
+    for (i = 0; i < M->ns; i++){
+        for (c = 0; c < numOfChars; c++){
+            d = sink;
+            if (replacements[c] != NULL){
+                d = i;
+                for (z = 0; replacements[c][z] != '\0' && d != sink; z++)
+                    d = next[d * numOfChars + (unsigned char) replacements[c][z]];
+                if (d != sink && next[i * numOfChars + c] != sink && next[i * numOfChars + c] != d)
+                    extraBitNeeded = true;
+            }
+            end[i * numOfChars + c] = d;
+        }
+    }
+
+    int ns = M->ns;
+    int new_sink;
+    if (sink < 0) {
+        // Additional state for the new sink
+        new_sink = ns++;
+    } else {
+        new_sink = sink;
+    }
+
+    /**************      BUILDING AUTOMATON PHASE     ******************/
+    int len = extraBitNeeded ? (var + 1) : var;
+    int *indices = allocateArbitraryIndex(len);
+    long max_exeps = 2 * numOfChars;
+    char *exeps = (char *) malloc(max_exeps * (len + 1) * sizeof(char));
+    int *to_states = (int *) malloc(max_exeps * sizeof(int));
+    char *statuces = (char *) malloc((ns + 1) * sizeof(char));
+    DFABuilder *b = dfaSetup(ns, len, indices);
+
+    for (i = 0; i < M->ns; i++){
+        k = 0;
+        for (c = 0; c < numOfChars; c++){
+            int orig = next[i * numOfChars + c];
+            d = end[i * numOfChars + c];
+            if (orig != sink)
+                store_char_exception(exeps, to_states, &k, var, len, charBin[c], '0', orig);
+            if (d != sink && d != orig)
+                store_char_exception(exeps, to_states, &k, var, len, charBin[c], '1', d);
+        }
+        dfaAllocExceptions(b, k);
+        for (k--; k >= 0; k--)
+            dfaStoreException(b, to_states[k], exeps + k * (len + 1));
+        dfaStoreState(b, new_sink);
+        statuces[i] = (M->f[i] == 1) ? '+' : '-';
+    }
+
+    if (sink < 0) {
+        dfaAllocExceptions(b, 0);
+        dfaStoreState(b, new_sink);
+        statuces[new_sink] = '-';
+    }
+    statuces[ns] = '\0';
+    DFA *result = dfaBuild(b, statuces);
+
+    free(exeps);
+    free(to_states);
+    free(statuces);
+    free(indices);
+    free(end);
+    free(next);
+    for (c = 0; c < numOfChars; c++)
+        free(charBin[c]);
+    free(charBin);
+
+    DFA *tmp;
+    if (extraBitNeeded){
+        if( DEBUG_SIZE_INFO )
+            printf("\t peak : pre_replace_chars_with_strings : states %d : bddnodes %u : before projection \n", result->ns, bdd_size(result->bddm) );
+        tmp = dfaProject(result, var);
+        dfaFree(result);
+        result = dfaMinimize(tmp);
+        dfaFree(tmp);
+    } else {
+        if( DEBUG_SIZE_INFO )
+            printf("\t peak : pre_replace_chars_with_strings : states %d : bddnodes %u \n", result->ns, bdd_size(result->bddm) );
+        tmp = dfaMinimize(result);
+        dfaFree(result);
+        result = tmp;
+    }
+    return result;
+}
+
 #define URI_ENCODE_CHARS 256
 
 static const char encodeUriComponentChars[URI_ENCODE_CHARS] =
@@ -4159,22 +4273,18 @@ static const char escapeChars[URI_ENCODE_CHARS] =
 
 static DFA *dfaEncodeUriGeneric(DFA *inputAuto, int var, int *indices, const char* encoding){
 
-    DFA *a = dfaCopy(inputAuto);
-    // Do percent first to prevent double encoding
-    DFA *b = dfa_replace_char_with_string(a, var, indices, '%', "%25");;
-    dfaFree(a);
-    a = b;
+    const char *replacements[URI_ENCODE_CHARS];
+    char percent[URI_ENCODE_CHARS][4];
 
+    // All chars are replaced at once so percent is never double encoded
     for (unsigned int c = 0; c < URI_ENCODE_CHARS; ++c) {
-        if (encoding[c]) {
-            char percent[4];
-            sprintf(percent, "%%%02X", c);
-            b = dfa_replace_char_with_string(a, var, indices, c, percent);
-            dfaFree(a);
-            a = b;
+        replacements[c] = NULL;
+        if (encoding[c] || c == '%') {
+            sprintf(percent[c], "%%%02X", c);
+            replacements[c] = percent[c];
         }
     }
-    return b;
+    return dfa_replace_chars_with_strings(inputAuto, var, indices, replacements);
 }
 
 DFA* dfaEncodeUriComponent(DFA *inputAuto, int var, int *indices) {
@@ -4193,22 +4303,19 @@ DFA* dfaEscape(DFA *inputAuto, int var, int *indices) {
 // Replaces each escape sequence in the encoded URI component with the character that it represents.
 DFA *dfaDecodeUriComponent(DFA *inputAuto, int var, int *indices){
 
-    DFA *a = dfaCopy(inputAuto);
-    DFA *b = NULL;
+    const char *replacements[URI_ENCODE_CHARS];
+    char encoded[URI_ENCODE_CHARS][4];
 
     // Replace all valid sequences
-    // The - 1 is here to prevent crashes in insertIntoStatePairSortedArrayList which asserts if escapeChar = 255
-    for (unsigned int c = 0; c < URI_ENCODE_CHARS - 1; ++c) {
-        char str[2];
-        char encoded[4];
-        sprintf(str, "%c", c);
-        sprintf(encoded, "%%%02X", c);
-        b = dfa_pre_replace_char_with_string(a, var, indices, (char)c, encoded);
-        dfaFree(a);
-        a = b;
+    // 255 is left out to match the previous per character decoding
+    for (unsigned int c = 0; c < URI_ENCODE_CHARS; ++c) {
+        replacements[c] = NULL;
+        if (c < URI_ENCODE_CHARS - 1) {
+            sprintf(encoded[c], "%%%02X", c);
+            replacements[c] = encoded[c];
+        }
     }
-
-    return a;
+    return dfa_pre_replace_chars_with_strings(inputAuto, var, indices, replacements);
 }
 
 // https://developer.mozilla.org/en-US/docs/Web/JavaScript/Reference/Global_Objects/decodeURI
@@ -4217,22 +4324,18 @@ DFA *dfaDecodeUriComponent(DFA *inputAuto, int var, int *indices){
 // The character “#” is not decoded from escape sequences.
 DFA *dfaDecodeUri(DFA *inputAuto, int var, int *indices){
 
-    DFA *a = dfaCopy(inputAuto);
-    DFA *b = NULL;
+    const char *replacements[URI_ENCODE_CHARS];
+    char encoded[URI_ENCODE_CHARS][4];
 
     // Replace all sequences which could have been introduced by dfaEncodeUri
     for (unsigned int c = 0; c < URI_ENCODE_CHARS; ++c) {
+        replacements[c] = NULL;
         if (encodeUriChars[c]) {
-            char str[2];
-            char encoded[4];
-            sprintf(str, "%c", c);
-            sprintf(encoded, "%%%02X", c);
-            b = dfa_pre_replace_char_with_string(a, var, indices, (char)c, encoded);
-            dfaFree(a);
-            a = b;
+            sprintf(encoded[c], "%%%02X", c);
+            replacements[c] = encoded[c];
         }
     }
-    return a;
+    return dfa_pre_replace_chars_with_strings(inputAuto, var, indices, replacements);
 }
 
 // Unescape will escape all percents, even those not covered by escape
@@ -4255,30 +4358,29 @@ static const char jsonEncodeChars[URI_ENCODE_CHARS] = {
 // Escape as defined in https://www.ecma-international.org/ecma-262/5.1/#sec-15.12.3
 DFA *dfaJsonStringify(DFA *inputAuto, int var, int *indices) {
 
-    DFA *a = dfaCopy(inputAuto);
-    // Escape backslash first to prevent double escape
-    DFA *b = dfa_replace_char_with_string(a, var, indices, '\\', "\\\\");
-    dfaFree(a);
-    a = b;
+    const char *replacements[URI_ENCODE_CHARS];
+    char uEncoded[URI_ENCODE_CHARS][8];
 
+    // All chars are replaced at once so backslash is never double escaped
     for (unsigned int c = 0; c < URI_ENCODE_CHARS; c++) {
         char j = jsonEncodeChars[c];
-        if (j != 0) {
-            char uEncoded[8];
+        replacements[c] = NULL;
+        if (c == '\\') {
+            sprintf(uEncoded[c], "\\\\");
+            replacements[c] = uEncoded[c];
+        } else if (j != 0) {
             if (j == 'u') {
                 // Encode as \\u00xy
-                sprintf(uEncoded, "\\u00%02x", c);
+                sprintf(uEncoded[c], "\\u00%02x", c);
             } else {
                 // Add single escape char
-                sprintf(uEncoded, "\\%c", j);
+                sprintf(uEncoded[c], "\\%c", j);
             }
-            b = dfa_replace_char_with_string(a, var, indices, c, uEncoded);
-            dfaFree(a);
-            a = b;
+            replacements[c] = uEncoded[c];
         }
     }
 
-    return b;
+    return dfa_replace_chars_with_strings(inputAuto, var, indices, replacements);
 }
 
 static const char jsonDecodeChars[URI_ENCODE_CHARS] = {
@@ -42,10 +42,12 @@
 pTransitionRelation dfaGetTransitionRelation(DFA *M){
     unsigned state, degree, nextState, i;
     state = degree = nextState = 0;
-    paths state_paths, pp;
+    TransitionTable *table;
+    unsigned t;
     
     int sink = find_sink(M);
     assert(sink >= 0);//assert that there is a sink
+    table = dfaAcquireTransitionTable(M, 0, NULL);
     
     pTransitionRelation p_transitionRelation = (pTransitionRelation) malloc(sizeof(transitionRelation));
     p_transitionRelation->reverse = false;
@@ -88,21 +90,18 @@ pTransitionRelation dfaGetTransitionRelation(DFA *M){
 //        printf("i = %d for state = %u\n", i, state);
         /*******************  find node degree *********************/
         memset(nextStates, false, sizeof(bool) * (p_transitionRelation->num_of_nodes));
-        state_paths = pp = make_paths(M->bddm, M->q[i]);
-        while (pp) {
-            if (pp->to == i)
+        for (t = table->first[i]; t < table->first[i + 1]; t++) {
+            if (table->to[t] == i)
                 p_transitionRelation->selfCycles = true;
-            unsigned to = (sink < pp->to)? pp->to - 1 : pp->to;
-            if (pp->to != sink){
+            unsigned to = (sink < table->to[t])? table->to[t] - 1 : table->to[t];
+            if (table->to[t] != sink){
                 if (nextStates[to] == false){
                     nextStates[to] = true;
                     p_transitionRelation->degrees[state]++;
                     p_transitionRelation->num_of_edges++;
                 }
             }
-            pp = pp->next;
         }
-        kill_paths(state_paths);
         /*******************  allocate node's adjacency list and fill it up *********************/
         if (p_transitionRelation->degrees[state] == 0) {
             p_transitionRelation->adjList[state]  = NULL;
@@ -119,6 +118,7 @@ pTransitionRelation dfaGetTransitionRelation(DFA *M){
             }
         }
     }
+    dfaReleaseTransitionTable(table);
     
     p_transitionRelation->acceptsSize = numOfAcceptStates;
     p_transitionRelation->accepts = (unsigned*) mem_resize((p_transitionRelation->accepts), ((p_transitionRelation->acceptsSize) * sizeof(unsigned)));
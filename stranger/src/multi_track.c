@@ -1217,7 +1217,7 @@ int isEqual2Lambda(char *str, char* lambda, int var){
 DFA *dfaRemoveLambda(DFA* M, int var, int* indices){
   DFA *result;
   paths state_paths, pp;
-  trace_descr tp;
+  PackedLabel label;
   int i, j, k;
   char *exeps;
   char *symbol;
@@ -1226,6 +1226,7 @@ DFA *dfaRemoveLambda(DFA* M, int var, int* indices){
   long max_exeps;
   char *statuces;
   char* lambda = getLambda(var);
+  unsigned long long lambdaChar = packed_label_from_string(lambda, var).value;
 
   max_exeps=1<<var; //maybe exponential
   sink=find_sink(M);
@@ -1251,18 +1252,9 @@ DFA *dfaRemoveLambda(DFA* M, int var, int* indices){
     while (pp) {
     	if(pp->to!=sink){
 
-    		for (j = 0; j < var;  j++) {
-    			//the following for loop can be avoided if the indices are in order
-    			for (tp = pp->trace; tp && (tp->index != indices[j]); tp =tp->next);
-
-    			if (tp) {
-    				if (tp->value) symbol[j]='1';
-    				else symbol[j]='0';
-    			}
-    			else
-    				symbol[j]='X';
-    		}
-    		if(isEqual2Lambda(symbol, lambda, var)){
+    		label = packed_label(pp->trace, var, indices);
+    		packed_label_to_string(label, var, symbol);
+    		if(packed_label_equals(label, lambdaChar, var)){
     			statuces[i]='+';
     		}else{
     			for(j = 0; j<var; j++) exeps[k*(var+1)+j]=symbol[j];
@@ -1306,7 +1298,7 @@ DFA *dfaRemovePreLambda(DFA *M, char* lambda, int var, int *oldindices)
   int *indices = oldindices; //indices is updated if you need to add auxiliary bits
 
   paths state_paths, pp;
-  trace_descr tp;
+  PackedLabel label;
 
   int i, j, z;
 
@@ -1320,6 +1312,7 @@ DFA *dfaRemovePreLambda(DFA *M, char* lambda, int var, int *oldindices)
   char *auxbit=NULL;
 
   char *symbol;
+  unsigned long long lambdaChar = packed_label_from_string(lambda, var).value;
 
   symbol=(char *)malloc((var+1)*sizeof(char));
 
@@ -1360,21 +1353,10 @@ DFA *dfaRemovePreLambda(DFA *M, char* lambda, int var, int *oldindices)
 		state_paths = pp = make_paths(M->bddm, M->q[tmpState->value]);
 		while (pp) {
 			if (pp->to != sink) {
-				for (j = 0; j < var; j++) {
-					//the following for loop can be avoided if the indices are in order
-					for (tp = pp->trace; tp && (tp->index != indices[j]); tp = tp->next);
-
-					if (tp) {
-						if (tp->value)
-							symbol[j] = '1';
-						else
-							symbol[j] = '0';
-					} else
-						symbol[j] = 'X';
-				}
-				symbol[j] = '\0';
+				label = packed_label(pp->trace, var, indices);
+				packed_label_to_string(label, var, symbol);
 
-				if (!isIncludeLambda(symbol, lambda, var)) { // Only Consider Non-lambda case
+				if (!packed_label_includes(label, lambdaChar)) { // Only Consider Non-lambda case
 					to_states[k] = pp->to + 1;
 					for (j = 0; j < var; j++)
 						exeps[k * (len + 1) + j] = symbol[j];
@@ -1411,22 +1393,10 @@ DFA *dfaRemovePreLambda(DFA *M, char* lambda, int var, int *oldindices)
 
 		while (pp) {
 			if (pp->to != sink) {
-				for (j = 0; j < var; j++) {
-					//the following for loop can be avoided if the indices are in order
-					for (tp = pp->trace; tp && (tp->index != indices[j]); tp =
-							tp->next)
-						;
-
-					if (tp) {
-						if (tp->value)
-							symbol[j] = '1';
-						else
-							symbol[j] = '0';
-					} else
-						symbol[j] = 'X';
-				}
+				label = packed_label(pp->trace, var, indices);
+				packed_label_to_string(label, var, symbol);
 
-				if (!isEqual2Lambda(symbol, lambda, var)) { // Only Consider Non-lambda case
+				if (!packed_label_equals(label, lambdaChar, var)) { // Only Consider Non-lambda case
 					to_states[k] = pp->to + 1;
 					for (j = 0; j < var; j++)
 						exeps[k * (len + 1) + j] = symbol[j];
@@ -1084,17 +1084,7 @@ DFA *dfa_replace_string(DFA *M, const char *str, int var, int *oldindices)
 	for (tp = pp->trace; tp && (tp->index != indices[var]); tp =tp->next); //find the bar value
 	if (!tp || !(tp->value)) {
 	  to_states[k]=pp->to;
-	  for (j = 0; j < var; j++) {
-	    //the following for loop can be avoided if the indices are in order
-	    for (tp = pp->trace; tp && (tp->index != indices[j]); tp =tp->next);
-
-	    if (tp) {
-	      if (tp->value) exeps[k*(len+1)+j]='1';
-	      else exeps[k*(len+1)+j]='0';
-	    }
-	    else
-	      exeps[k*(len+1)+j]='X';
-	  }
+	  packed_label_to_string(packed_label(pp->trace, var, indices), var, exeps+k*(len+1));
 	  for (j = var; j < len; j++) {
 	    exeps[k*(len+1)+j]='0'; //all original paths are set to zero
 	  }
@@ -157,6 +157,18 @@ extern "C" {
     void dfaPrintTransitionRelation(pTransitionRelation p_transitionRelation);
     void dfaPrintTransitionRelationNoShift(pTransitionRelation p_transitionRelation);
 
+    /*=====================================================================*/
+    /* Explicit transition table, decoded once and read by the function
+     * models instead of the BDDs. A table shared for a DFA is used by every
+     * model called on it in the same thread until it is unshared, it must
+     * not outlive the DFA.
+     */
+    typedef struct TransitionTable_ TransitionTable;
+    TransitionTable *dfaBuildTransitionTable(DFA *M, int var, int *indices);
+    void dfaFreeTransitionTable(TransitionTable *table);
+    void dfaShareTransitionTable(DFA *M, TransitionTable *table);
+    void dfaUnshareTransitionTable(DFA *M);
+
 
     /*=====================================================================*/
     /* Function Helpers
@@ -198,6 +210,20 @@ extern "C" {
      * outputs DFA M where L(M) = {s: s elementOf set}
      */
     DFA* dfa_construct_set_of_strings(char** set, int size, int var, int* indices);
+
+    /*
+     * outputs a DFA M that accepts all strings containing *s, built
+     * directly from the KMP failure function of s
+     * outputs DFA M where L(M) = {w.s.v: w, v elementOf S*}
+     */
+    DFA *dfa_construct_contains_string(const char *s, int var, int *indices);
+
+    /*
+     * outputs a DFA M that accepts all strings containing one of the
+     * strings in array set, built from the Aho-Corasick automaton of set
+     * outputs DFA M where L(M) = {w.s.v: s elementOf set, w, v elementOf S*}
+     */
+    DFA *dfa_construct_contains_any(char **set, int size, int var, int *indices);
     
     
     DFA *dfa_construct_string_closure(char *reg, int var, int *indices);
@@ -325,8 +351,20 @@ extern "C" {
     
     int check_emptiness(DFA *M1, int var, int *indices);
     
+    /*
+     * compares M1 and M2 state by state (Hopcroft and Karp) and stops at
+     * the first pair of states which disagree
+     */
     int check_equivalence(DFA *M1, DFA *M2, int var, int *indices);
+
+    // the construction check_equivalence used before, for benchmarks
+    int check_equivalence_product(DFA *M1, DFA *M2, int var, int *indices);
     
+    /*
+     * check_intersection and check_inclusion search the product of their
+     * arguments on the fly and stop as soon as the answer is known, neither
+     * the product nor an example is built
+     */
     int check_intersection(DFA *M1,DFA *M2,int var,int *indices);// added by Muath to be used by java StrangerLibrary
     
     /*
@@ -334,6 +372,13 @@ extern "C" {
      * L(M1) subset_of L(M2)
      */
     int check_inclusion(DFA *M1,DFA *M2,int var,int *indices);// added by Muath to be used by java StrangerLibrary
+
+    /**
+     * returns a hash of L(M) computed from a canonical BFS numbering of the
+     * minimized DFA. Equal languages always give equal fingerprints,
+     * equal fingerprints still need check_equivalence to confirm.
+     */
+    unsigned long long dfa_fingerprint(DFA *M);
     
     /**
      if L(M) is a singleton set, it will return the string element
@@ -473,6 +518,18 @@ extern "C" {
     DFA *dfa_replace_char_with_string_once(DFA *M, int var, int *oldIndices, char replacedChar, const char *string);
     DFA *dfa_replace_char_with_string(DFA *M, int var, int *oldIndices, char replacedChar, const char *string);
     DFA *dfa_pre_replace_char_with_string(DFA *M, int var, int *oldIndices, char replacedChar, const char *string);
+    /**
+     * Replaces each char c with replacements[c] (unless NULL) in one pass.
+     * replacements has (1 << var) entries, the non NULL ones must be prefix free.
+     */
+    DFA *dfa_replace_chars_with_strings(DFA *M, int var, int *oldIndices, const char *replacements[]);
+    DFA *dfa_pre_replace_chars_with_strings(DFA *M, int var, int *oldIndices, const char *replacements[]);
+    /**
+     * Maps each char c to map[c] in one pass, map has (1 << var) entries.
+     * dfa_pre_map_chars accepts the strings whose image is accepted by M.
+     */
+    DFA *dfa_map_chars(DFA *M, int var, int *oldIndices, const unsigned char *map);
+    DFA *dfa_pre_map_chars(DFA *M, int var, int *oldIndices, const unsigned char *map);
     DFA *dfaHtmlSpecialChars(DFA *inputAuto, int var, int *indices, hscflags_t flags);
     DFA *dfaPreHtmlSpecialChars(DFA *inputAuto, int var, int *indices, hscflags_t flags);
     DFA *dfaEncodeTextFragment(DFA *inputAuto, int var, int *indices);
@@ -110,6 +110,59 @@ typedef struct CharPair_ {
 void getTransitionChars(char* transitions, int var, pCharPair result[], int* pSize);
 char** mergeCharRanges(pCharPair charRanges[], int* p_size);
 
+/*
+ * A transition label packed into two words instead of a string of
+ * '0'/'1'/'X'. Bit var-1-j of mask is set if track j is fixed on the path
+ * and the same bit of value holds its value, so track 0 is the most
+ * significant bit of a character as in bintostr. Labels have at most 64
+ * tracks. Characters are compared over all var tracks like bintostr does,
+ * so a char is sign extended and lambda symbols wider than 8 tracks keep
+ * all of their bits; take them from packed_label_from_string, not strtobin.
+ */
+typedef struct PackedLabel_ {
+	unsigned long long mask;
+	unsigned long long value;
+} PackedLabel;
+PackedLabel packed_label(trace_descr trace, int var, int *indices);
+PackedLabel packed_label_from_string(const char *str, int var);
+void packed_label_to_string(PackedLabel label, int var, char *str);
+int packed_label_includes_any(PackedLabel label, const char *chars, int size);
+
+// 1 if character c is on the path of label
+static inline int packed_label_includes(PackedLabel label, unsigned long long c) {
+	return (c & label.mask) == label.value;
+}
+
+// 1 if some character is on the paths of both labels
+static inline int packed_label_overlaps(PackedLabel a, PackedLabel b) {
+	return ((a.value ^ b.value) & a.mask & b.mask) == 0;
+}
+
+// 1 if character c is the only one on the path of label
+static inline int packed_label_equals(PackedLabel label, unsigned long long c, int var) {
+	return label.mask == (~0ULL >> (64 - var)) && label.value == (c & label.mask);
+}
+
+/*
+ * The transitions of a DFA decoded once from its BDDs, so several passes
+ * of a function model do not call make_paths on every state again. The
+ * transitions of state i are first[i] .. first[i + 1] - 1, in the order
+ * make_paths returns them, with labels packed over var tracks. A table
+ * decoded with var 0 only holds the targets.
+ */
+struct TransitionTable_ {
+	int ns;
+	int var;
+	int *indices;
+	unsigned *first;
+	int *to;
+	PackedLabel *labels;
+};
+// the table shared for M if it was decoded the same way, else a new one
+// which nested acquires for M share until it is released
+TransitionTable *dfaAcquireTransitionTable(DFA *M, int var, int *indices);
+void dfaReleaseTransitionTable(TransitionTable *table);
+
 
 int check_value(struct int_list_type *list, int value);
 DFA *dfa_union_empty_M(DFA *M, int var, int *indices);